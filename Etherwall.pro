@@ -1,6 +1,7 @@
 TEMPLATE = app
 
-QT += qml quick widgets network websockets
+QT += qml quick widgets network websockets concurrent
+CONFIG += c++14
 
 INCLUDEPATH += src src/ew-node/src
 DEPENDPATH += src src/ew-node/src
@@ -37,7 +38,26 @@ SOURCES += src/main.cpp \
     src/accountproxymodel.cpp \
     src/contractmodel.cpp \
     src/contractinfo.cpp \
+    src/abicache.cpp \
+    src/callcache.cpp \
+    src/gasoracle.cpp \
+    src/noncemanager.cpp \
+    src/batchsendmodel.cpp \
+    src/pendingtracker.cpp \
+    src/pendingfeed.cpp \
+    src/lightingest.cpp \
+    src/address.cpp \
+    src/balancetotal.cpp \
+    src/settingscache.cpp \
+    src/recordstore.cpp \
+    src/statesnapshot.cpp \
+    src/startupsequence.cpp \
+    src/ipcsocketwatcher.cpp \
+    src/ipcsession.cpp \
+    src/decodedblock.cpp \
+    src/blockdecoder.cpp \
     src/eventmodel.cpp \
+    src/eventarchive.cpp \
     src/filtermodel.cpp \
     src/trezor/trezor.cpp \
     src/trezor/proto/messages.pb.cc \
@@ -55,11 +75,18 @@ SOURCES += src/main.cpp \
     src/ew-node/src/types.cpp \
     src/ew-node/src/ethereum/tx.cpp \
     src/ew-node/src/ethereum/bigint.cpp \
-    src/ew-node/src/nodeipc.cpp \
-    src/ew-node/src/nodews.cpp \
     src/gethlogapp.cpp \
     src/etherlogapp.cpp
 
+# the node client is built from src/, not from the ew-node submodule, whose NodeIPC has no
+# socket watcher, session resume or filter reinstall. Only the logging, helpers and ethereum
+# sources come from the submodule
+SOURCES += src/nodeipc.cpp \
+    src/nodews.cpp
+
+HEADERS += src/nodeipc.h \
+    src/nodews.h
+
 RESOURCES += qml/qml.qrc
 
 # Additional import path used to resolve QML modules in Qt Creator's code model
@@ -86,7 +113,27 @@ HEADERS += \
     src/accountproxymodel.h \
     src/contractmodel.h \
     src/contractinfo.h \
+    src/abicache.h \
+    src/erc20codec.h \
+    src/callcache.h \
+    src/gasoracle.h \
+    src/noncemanager.h \
+    src/batchsendmodel.h \
+    src/pendingtracker.h \
+    src/pendingfeed.h \
+    src/lightingest.h \
+    src/address.h \
+    src/balancetotal.h \
+    src/settingscache.h \
+    src/recordstore.h \
+    src/statesnapshot.h \
+    src/startupsequence.h \
+    src/ipcsocketwatcher.h \
+    src/ipcsession.h \
+    src/decodedblock.h \
+    src/blockdecoder.h \
     src/eventmodel.h \
+    src/eventarchive.h \
     src/filtermodel.h \
     src/trezor/trezor.h \
     src/trezor/proto/messages.pb.h \
@@ -103,8 +150,6 @@ HEADERS += \
     src/ew-node/src/etherlog.h \
     src/ew-node/src/gethlog.h \
     src/ew-node/src/helpers.h \
-    src/ew-node/src/nodeipc.h \
-    src/ew-node/src/nodews.h \
     src/ew-node/src/ethereum/bigint.h \
     src/ew-node/src/ethereum/tx.h \
     src/ew-node/src/ethereum/keccak.h \
@@ -126,6 +126,7 @@ Tab {
                 width: 1 * dpi
                 horizontalAlignment: TextInput.AlignRight
                 readOnly: true
+                opacity: accountModel.stale ? 0.5 : 1.0
                 text: Number(accountModel.total).toFixed(2)
             }
         }
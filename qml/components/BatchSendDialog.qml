@@ -0,0 +1,146 @@
+import QtQuick 2.0
+import QtQuick.Dialogs 1.2
+import QtQuick.Controls 1.1
+
+Dialog {
+    id: batchDialog
+    title: qsTr("Batch send")
+    standardButtons: StandardButton.Close
+    modality: Qt.WindowModal
+    visible: false
+    width: 9 * dpi
+    height: 6 * dpi
+
+    function display() {
+        open()
+    }
+
+    function statusText(status) {
+        switch ( status ) {
+            case 0: return qsTr("Queued")
+            case 1: return qsTr("Sending")
+            case 2: return qsTr("Sent")
+            case 3: return qsTr("Failed")
+            case 4: return qsTr("Unknown")
+        }
+
+        return ""
+    }
+
+    Connections {
+        target: batchSendModel
+        onBatchError: appWindow.showBadge(error)
+        onBatchDone: appWindow.showBadge(qsTr("Batch done, sent: ") + batchSendModel.sentCount)
+    }
+
+    PasswordDialog {
+        id: batchPasswordDialog
+        title: qsTr("Confirm batch send")
+
+        onPasswordSubmitted: {
+            batchSendModel.start(batchFromField.currentIndex, password, transactionModel.gasPrice)
+        }
+    }
+
+    FileDialog {
+        id: csvImportDialog
+        selectFolder: false
+        selectExisting: true
+        selectMultiple: false
+        folder: shortcuts.documents
+        nameFilters: [ "CSV (*.csv)", "All files (*)" ]
+        onAccepted: batchSendModel.importCSV(fileUrl)
+    }
+
+    Column {
+        id: batchColumn
+        width: parent.width
+        spacing: 0.1 * dpi
+
+        Row {
+            spacing: 0.1 * dpi
+
+            ComboBox {
+                id: batchFromField
+                width: batchColumn.width - 4 * dpi - 0.3 * dpi
+                model: accountModel
+                textRole: "summary"
+                currentIndex: accountModel.defaultIndex
+                enabled: !batchSendModel.running
+            }
+
+            Button {
+                width: 1 * dpi
+                text: qsTr("Import CSV")
+                enabled: !batchSendModel.running
+                onClicked: csvImportDialog.open()
+            }
+
+            Button {
+                width: 1 * dpi
+                text: batchSendModel.running ? qsTr("Stop") : qsTr("Send")
+                enabled: batchView.rowCount > 0 && !ipc.syncing && !ipc.closing && !ipc.starting
+                onClicked: {
+                    if ( batchSendModel.running ) {
+                        batchSendModel.stop()
+                        return
+                    }
+
+                    batchPasswordDialog.text = qsTr("Send ") + batchView.rowCount + qsTr(" transfers at gas price ") + transactionModel.gasPrice
+                    batchPasswordDialog.openFocused()
+                }
+            }
+
+            Button {
+                width: 1 * dpi
+                text: qsTr("Clear")
+                enabled: !batchSendModel.running
+                onClicked: batchSendModel.clear()
+            }
+        }
+
+        Label {
+            text: qsTr("Sent: ") + batchSendModel.sentCount + "/" + batchView.rowCount +
+                  qsTr(" failed: ") + batchSendModel.failedCount +
+                  qsTr(" rate: ") + batchSendModel.rate.toFixed(1) + qsTr(" per minute")
+        }
+
+        TableView {
+            id: batchView
+            width: parent.width
+            height: batchDialog.height - 2 * dpi
+            model: batchSendModel
+
+            TableViewColumn {
+                role: "to"
+                title: qsTr("To")
+                width: batchView.width * 0.35
+            }
+            TableViewColumn {
+                horizontalAlignment: Text.AlignRight
+                role: "amount"
+                title: qsTr("Amount")
+                width: batchView.width * 0.15
+            }
+            TableViewColumn {
+                role: "token"
+                title: qsTr("Token")
+                width: batchView.width * 0.15
+            }
+            TableViewColumn {
+                horizontalAlignment: Text.AlignRight
+                role: "nonce"
+                title: qsTr("Nonce")
+                width: batchView.width * 0.1
+            }
+            TableViewColumn {
+                role: "status"
+                title: qsTr("Status")
+                width: batchView.width * 0.2
+                delegate: Label {
+                    text: batchDialog.statusText(styleData.value)
+                }
+            }
+        }
+    }
+}
@@ -63,7 +63,7 @@ Dialog {
         }
 
         Connections {
-            target: ipc
+            target: callCache
 
             onCallDone: {
                 if ( userData["type"] === "functionCall" ) {
@@ -1,5 +1,6 @@
 import QtQuick 2.0
 import QtQuick.Controls 1.2
+import QtQuick.Dialogs 1.2
 
 Item {
     anchors.fill: parent
@@ -47,6 +48,13 @@ Item {
                     }
                 }
 
+                MenuItem {
+                    text: qsTr("Export all to CSV")
+                    onTriggered: {
+                        csvExportDialog.open()
+                    }
+                }
+
                 MenuItem {
                     text: qsTr("Find on blockchain explorer")
                     onTriggered: {
@@ -62,6 +70,20 @@ Item {
                 }
             }
 
+            FileDialog {
+                id: csvExportDialog
+                selectFolder: false
+                selectExisting: false
+                selectMultiple: false
+                folder: shortcuts.documents
+                nameFilters: [ "CSV (*.csv)", "All files (*)" ]
+                onAccepted: {
+                    if ( !eventModel.exportEvents(fileUrl) ) {
+                        appWindow.showBadge(qsTr("Error saving events to ") + helpers.localURLToString(fileUrl))
+                    }
+                }
+            }
+
             MouseArea {
                 anchors.fill: parent
                 acceptedButtons: Qt.RightButton
@@ -32,7 +32,7 @@ Dialog {
 
     onAccepted: {
         settings.setValue("program/v2firstrun", new Date())
-        initializer.start();
+        startup.start();
     }
 
     Column {
@@ -31,7 +31,7 @@ Item {
     signal done()
 
     Connections {
-        target: ipc
+        target: callCache
 
         onCallDone: {
             if ( userData["type"] === "functionCall" ) {
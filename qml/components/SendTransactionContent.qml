@@ -31,7 +31,7 @@ Item {
         }
         var result = sendButton.refresh()
         if ( !result.error ) {
-            ipc.estimateGas(result.from, result.to, result.txtVal, "3141592", result.txtGasPrice, contractData)
+            transactionModel.estimateGas(result.from, result.to, result.txtVal, "3141592", result.txtGasPrice, contractData)
         }
     }
 
@@ -45,7 +45,16 @@ Item {
         onTriggered: {
             var result = sendButton.refresh()
             if ( !result.error ) {
-                ipc.estimateGas(result.from, result.to, result.txtVal, "3141592", result.txtGasPrice, contractData)
+                transactionModel.estimateGas(result.from, result.to, result.txtVal, "3141592", result.txtGasPrice, contractData)
+            }
+        }
+    }
+
+    Connections {
+        target: transactionModel
+        onGasEstimateDone: {
+            if ( !gasField.manual ) {
+                gasField.text = price
             }
         }
     }
@@ -60,12 +69,6 @@ Item {
             sendButton.enabled = true
         }
 
-        onEstimateGasDone: {
-            if ( !gasField.manual ) {
-                gasField.text = price
-            }
-        }
-
         onSendTransactionDone: {
             if ( ipcConnection.deployedName.length ) {
                 contractModel.addPendingContract(ipcConnection.deployedName, ipcConnection.deployedAbi, hash)
@@ -113,7 +116,7 @@ Item {
                 onActivated: {
                     var result = sendButton.refresh(index)
                     if ( !result.error ) {
-                        ipc.estimateGas(result.from, result.to, result.txtVal, "3141592", result.txtGasPrice, contractData)
+                        transactionModel.estimateGas(result.from, result.to, result.txtVal, "3141592", result.txtGasPrice, contractData)
                     }
                 }
             }
@@ -145,7 +148,13 @@ Item {
                     var result = sendButton.refresh()
                     if ( !result.error ) {
                         contractData = tokenModel.getTokenTransferData(tokenCombo.currentIndex, text, valueField.text)
-                        ipc.estimateGas(result.from, result.to, result.txtVal, "3141592", result.txtGasPrice, contractData)
+                        transactionModel.estimateGas(result.from, result.to, result.txtVal, "3141592", result.txtGasPrice, contractData)
+                    } else if ( result.from && acceptableInput && helpers.checkAddress(text) ) {
+                        // no value yet, warm up an estimate to show until the one for the typed in amount is back
+                        var prefetchData = tokenModel.getTokenTransferData(tokenCombo.currentIndex, text, "1")
+                        var prefetchTo = tokenCombo.currentIndex > 0 ? tokenAddress : text
+                        var prefetchValue = tokenCombo.currentIndex > 0 ? "0" : "1"
+                        transactionModel.prefetchGasEstimate(result.from, prefetchTo, prefetchValue, "3141592", gasPriceField.text, prefetchData)
                     }
                 }
             }
@@ -153,7 +162,8 @@ Item {
 
         Row {
             Label {
-                text: qsTr("Gas: ")
+                // "~" while showing an estimate for another amount, the exact one replaces it
+                text: transactionModel.gasEstimateProvisional && !gasField.manual ? qsTr("Gas: ~") : qsTr("Gas: ")
                 width: 1 * dpi
             }
 
@@ -179,7 +189,7 @@ Item {
                     gasField.manual = false // allow overrides
                     var result = sendButton.refresh()
                     if ( !result.error ) {
-                        ipc.estimateGas(result.from, result.to, result.txtVal, "3141592", result.txtGasPrice, contractData)
+                        transactionModel.estimateGas(result.from, result.to, result.txtVal, "3141592", result.txtGasPrice, contractData)
                     }
                 }
             }
@@ -203,7 +213,7 @@ Item {
                         text = String(text)
                         var result = sendButton.refresh()
                         if ( !result.error ) {
-                            ipc.estimateGas(result.from, result.to, result.txtVal, "3141592", result.txtGasPrice, contractData)
+                            transactionModel.estimateGas(result.from, result.to, result.txtVal, "3141592", result.txtGasPrice, contractData)
                         }
                     }
                 }
@@ -214,12 +224,13 @@ Item {
                 height: 32
                 width: 32
                 iconSource: "/images/gas"
-                tooltip: qsTr("Apply current gas price")
+                tooltip: gasOracle.samples > 0 ? qsTr("Apply current gas price") + " (" + qsTr("slow: ") + gasOracle.slow + ", " + qsTr("fast: ") + gasOracle.fast + ")"
+                                               : qsTr("Apply current gas price")
                 onClicked: {
                     gasPriceField.text = Qt.binding(function() { return transactionModel.gasPrice })
                     var result = sendButton.refresh()
                     if ( !result.error ) {
-                        ipc.estimateGas(result.from, result.to, result.txtVal, "3141592", result.txtGasPrice, contractData)
+                        transactionModel.estimateGas(result.from, result.to, result.txtVal, "3141592", result.txtGasPrice, contractData)
                     }
                 }
             }
@@ -273,7 +284,7 @@ Item {
                     } else {
                         var result = sendButton.refresh()
                         contractData = tokenModel.getTokenTransferData(index, toField.text, "0")
-                        ipc.estimateGas(result.from, result.to, result.txtVal, "3141592", result.txtGasPrice, contractData)
+                        transactionModel.estimateGas(result.from, result.to, result.txtVal, "3141592", result.txtGasPrice, contractData)
                     }
                     var regstr = "^[0-9]{1,40}([.][0-9]{1," + decimals + "})?$"
                     valueValidator.regExp = new RegExp(regstr)
@@ -359,6 +370,7 @@ Item {
                     return
                 }
 
+                result.nonce = accountModel.reserveAccountNonce(fromField.currentIndex)
                 transactionModel.sendTransaction(password, result.from, result.to, result.txtVal, result.nonce, result.txtGas, result.txtGasPrice, contractData)
             }
         }
@@ -520,6 +532,7 @@ Item {
 
                 // trezor asks for confirmation[s] on it's display, one more is cumbersome
                 if ( result.hdpath.length ) {
+                    result.nonce = accountModel.reserveAccountNonce(fromField.currentIndex)
                     trezor.signTransaction(result.chain_id, result.hdpath, result.from, result.to, result.txtVal, result.nonce, result.txtGas, result.txtGasPrice, contractData)
                     return
                 }
@@ -69,6 +69,59 @@ TabView {
                         onActivated: currencyModel.setHelperIndex(index)
                     }
                 }
+
+                Row {
+                    width: parent.width
+
+                    Label {
+                        text: qsTr("Stuck transactions: ")
+                    }
+
+                    ComboBox {
+                        id: replacePolicyCombo
+                        width: 2 * dpi
+                        model: [qsTr("Ignore"), qsTr("Notify"), qsTr("Replace automatically")]
+                        currentIndex: pendingTracker.policy
+
+                        onActivated: pendingTracker.policy = index
+                    }
+                }
+
+                CheckBox {
+                    id: pendingFeedCheck
+                    text: qsTr("Show incoming transactions before they're mined")
+                    enabled: !thinClient
+                    checked: pendingFeed.enabled
+
+                    onClicked: pendingFeed.enabled = pendingFeedCheck.checked
+                }
+
+                Row {
+                    width: parent.width
+
+                    Label {
+                        text: qsTr("Balance checker: ")
+                    }
+
+                    TextField {
+                        id: balanceCheckerField
+                        width: 3.5 * dpi
+                        maximumLength: 42
+                        placeholderText: qsTr("contract address, see README")
+                        text: contractModel.balanceChecker
+
+                        onEditingFinished: contractModel.balanceChecker = text
+                    }
+                }
+
+                CheckBox {
+                    id: lightIngestCheck
+                    text: qsTr("Download blocks only when account balances change")
+                    enabled: lightIngest.available // needs a balance checker contract to batch the balance checks
+                    checked: lightIngest.enabled && lightIngest.available
+
+                    onClicked: lightIngest.enabled = lightIngestCheck.checked
+                }
             }
         }
     }
@@ -244,6 +297,26 @@ TabView {
                 }
             }
 
+            Row {
+                id: rowEventsMemory
+                width: parent.width
+
+                Label {
+                    id: eventsMemoryLabel
+                    text: qsTr("Events kept in memory (0 = all): ")
+                }
+
+                SpinBox {
+                    id: eventsMemoryField
+                    width: 1 * dpi
+                    minimumValue: 0
+                    maximumValue: 1000000
+                    stepSize: 1000
+                    value: settings.value("events/memorylimit", 10000)
+                    onValueChanged: settings.setValue("events/memorylimit", eventsMemoryField.value)
+                }
+            }
+
             CheckBox {
                 id: gethTestnetCheck
                 enabled: !thinClient
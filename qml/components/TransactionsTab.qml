@@ -40,20 +40,51 @@ Tab {
             id: details
         }
 
-        Button {
-            id: sendButton
-            text: "Send Ether"
+        BatchSendDialog {
+            id: batchDialog
+        }
+
+        Connections {
+            target: pendingTracker
+            onStuckTransaction: appWindow.showBadge(qsTr("Transaction seems stuck, right click it to speed up: ") + hash)
+            onReplacedTransaction: appWindow.showBadge(qsTr("Transaction replaced by: ") + newHash)
+        }
+
+        PasswordDialog {
+            id: speedUpDialog
+            property string hash
+
+            onPasswordSubmitted: pendingTracker.speedUp(hash, password)
+        }
+
+        Row {
+            id: sendRow
             width: parent.width
-            height: 1 * dpi
 
-            onClicked: sendDialog.display()
+            Button {
+                id: sendButton
+                text: "Send Ether"
+                width: parent.width - batchButton.width
+                height: 1 * dpi
+
+                onClicked: sendDialog.display()
+            }
+
+            Button {
+                id: batchButton
+                text: qsTr("Batch send")
+                width: 1.5 * dpi
+                height: 1 * dpi
+
+                onClicked: batchDialog.display()
+            }
         }
 
         TableView {
             id: transactionView
             anchors.left: parent.left
             anchors.right: parent.right
-            height: parent.height - parent.spacing - sendButton.height
+            height: parent.height - parent.spacing - sendRow.height
 
             TableViewColumn {
                 horizontalAlignment: Text.AlignRight
@@ -102,6 +133,27 @@ Tab {
                     }
                 }
 
+                MenuItem {
+                    text: qsTr("Speed up")
+                    onTriggered: {
+                        var hash = transactionModel.getHash(transactionView.currentRow)
+                        var tx = pendingTracker.getReplacement(hash)
+                        if ( !tx.from ) {
+                            appWindow.showBadge(qsTr("Transaction is not pending"))
+                            return
+                        }
+
+                        if ( tx.hdpath.length ) {
+                            trezor.signTransaction(ipc.testnet ? 4 : 1, tx.hdpath, tx.from, tx.to, tx.value, tx.nonce, tx.gas, tx.gasPrice, tx.data)
+                            return
+                        }
+
+                        speedUpDialog.hash = hash
+                        speedUpDialog.text = qsTr("Resend with gas price ") + tx.gasPrice
+                        speedUpDialog.openFocused(qsTr("Speed up transaction"))
+                    }
+                }
+
                 MenuItem {
                     text: qsTr("Copy Transaction Hash")
                     onTriggered: {
@@ -166,6 +166,7 @@ ApplicationWindow {
         target: eventModel
 
         onReceivedEvent: badge.show(qsTr("Received event from contract " + contract + ": ") + signature)
+        onEventsExported: badge.show((success ? qsTr("Events saved to ") : qsTr("Error saving events to ")) + fileName)
     }
 
     Connections {
@@ -361,6 +362,7 @@ ApplicationWindow {
                 visible: false
                 width: 100
                 readOnly: true
+                opacity: transactionModel.blockNumberStale ? 0.5 : 1.0
                 text: transactionModel.blockNumber
             }
 
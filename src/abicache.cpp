@@ -0,0 +1,203 @@
+#include "abicache.h"
+#include "etherlog.h"
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+#include <QCryptographicHash>
+
+namespace Etherwall {
+
+    static const quint32 sMagic = 0x45574143; // EWAC
+    static const quint32 sVersion = 1;
+    static const qint64 sHeaderSize = 12; // magic, version, entry count
+
+    AbiCache::AbiCache(const QString& fileName) : fFile(fileName), fMap(0), fIndex(), fPending()
+    {
+        QDir().mkpath(QFileInfo(fileName).absolutePath());
+        open();
+    }
+
+    AbiCache::~AbiCache()
+    {
+        close();
+    }
+
+    const QByteArray AbiCache::key(const QJsonArray& abi)
+    {
+        // md5 good enough here, not security related and we need speed
+        return QCryptographicHash::hash(QJsonDocument(abi).toJson(QJsonDocument::Compact), QCryptographicHash::Md5);
+    }
+
+    bool AbiCache::load(const QByteArray& key, ContractFunctionList& functions, ContractEventList& events) const
+    {
+        const QByteArray data = entry(key);
+        if ( data.isEmpty() ) {
+            return false;
+        }
+
+        QDataStream stream(data);
+        stream.setVersion(QDataStream::Qt_5_0);
+        quint32 functionCount, eventCount;
+        ContractFunctionList loadedFunctions;
+        ContractEventList loadedEvents;
+
+        stream >> functionCount;
+        for ( quint32 i = 0; i < functionCount && stream.status() == QDataStream::Ok; i++ ) {
+            loadedFunctions.append(ContractFunction(stream));
+        }
+
+        stream >> eventCount;
+        for ( quint32 i = 0; i < eventCount && stream.status() == QDataStream::Ok; i++ ) {
+            loadedEvents.append(ContractEvent(stream));
+        }
+
+        if ( stream.status() != QDataStream::Ok ) {
+            EtherLog::logMsg("Corrupt ABI cache entry, reparsing", LS_Warning);
+            return false;
+        }
+
+        functions = loadedFunctions;
+        events = loadedEvents;
+        return true;
+    }
+
+    void AbiCache::store(const QByteArray& key, const ContractFunctionList& functions, const ContractEventList& events)
+    {
+        if ( fIndex.contains(key) || fPending.contains(key) ) {
+            return;
+        }
+
+        QByteArray data;
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_5_0);
+
+        stream << (quint32)functions.size();
+        foreach ( const ContractFunction& func, functions ) {
+            func.serialize(stream);
+        }
+
+        stream << (quint32)events.size();
+        foreach ( const ContractEvent& event, events ) {
+            event.serialize(stream);
+        }
+
+        fPending[key] = data;
+    }
+
+    bool AbiCache::save()
+    {
+        if ( fPending.isEmpty() ) {
+            return true;
+        }
+
+        // gather all entries before we unmap the old file
+        QHash<QByteArray, QByteArray> entries = fPending;
+        foreach ( const QByteArray& key, fIndex.keys() ) {
+            entries[key] = entry(key);
+        }
+
+        QByteArray index;
+        QByteArray payload;
+        QDataStream indexStream(&index, QIODevice::WriteOnly);
+        indexStream.setVersion(QDataStream::Qt_5_0);
+        const qint64 indexSize = entries.size() * (16 + 8 + 8);
+        foreach ( const QByteArray& key, entries.keys() ) {
+            const QByteArray& data = entries.value(key);
+            indexStream.writeRawData(key.constData(), 16);
+            indexStream << (qint64)(sHeaderSize + indexSize + payload.size()) << (qint64)data.size();
+            payload.append(data);
+        }
+
+        close();
+
+        QSaveFile file(fFile.fileName());
+        if ( !file.open(QIODevice::WriteOnly) ) {
+            EtherLog::logMsg("Unable to write ABI cache: " + file.errorString(), LS_Error);
+            open();
+            return false;
+        }
+
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_5_0);
+        stream << sMagic << sVersion << (quint32)entries.size();
+        stream.writeRawData(index.constData(), index.size());
+        stream.writeRawData(payload.constData(), payload.size());
+
+        if ( !file.commit() ) {
+            EtherLog::logMsg("Unable to write ABI cache: " + file.errorString(), LS_Error);
+            open();
+            return false;
+        }
+
+        fPending.clear();
+        open();
+        return true;
+    }
+
+    void AbiCache::open()
+    {
+        if ( !fFile.exists() || !fFile.open(QIODevice::ReadOnly) ) {
+            return;
+        }
+
+        const qint64 size = fFile.size();
+        if ( size < sHeaderSize || (fMap = fFile.map(0, size)) == 0 ) {
+            return close();
+        }
+
+        const QByteArray raw = QByteArray::fromRawData((const char*)fMap, size);
+        QDataStream stream(raw);
+        stream.setVersion(QDataStream::Qt_5_0);
+        quint32 magic, version, count;
+        stream >> magic >> version >> count;
+        if ( magic != sMagic || version != sVersion ) {
+            EtherLog::logMsg("ABI cache version mismatch, rebuilding", LS_Info);
+            return close();
+        }
+
+        for ( quint32 i = 0; i < count; i++ ) {
+            QByteArray key(16, '\0');
+            qint64 offset, length;
+            stream.readRawData(key.data(), 16);
+            stream >> offset >> length;
+
+            if ( stream.status() != QDataStream::Ok || offset < 0 || length < 0 || offset + length > size ) {
+                EtherLog::logMsg("Corrupt ABI cache index, rebuilding", LS_Warning);
+                fIndex.clear();
+                return close();
+            }
+
+            fIndex[key] = EntryRange(offset, length);
+        }
+    }
+
+    void AbiCache::close()
+    {
+        if ( fMap != 0 ) {
+            fFile.unmap(fMap);
+            fMap = 0;
+        }
+
+        if ( fFile.isOpen() ) {
+            fFile.close();
+        }
+
+        fIndex.clear();
+    }
+
+    const QByteArray AbiCache::entry(const QByteArray& key) const
+    {
+        if ( fPending.contains(key) ) {
+            return fPending.value(key);
+        }
+
+        if ( fMap == 0 || !fIndex.contains(key) ) {
+            return QByteArray();
+        }
+
+        const EntryRange range = fIndex.value(key);
+        return QByteArray::fromRawData((const char*)fMap + range.first, range.second);
+    }
+
+}
@@ -0,0 +1,40 @@
+#ifndef ABICACHE_H
+#define ABICACHE_H
+
+#include <QFile>
+#include <QHash>
+#include <QPair>
+#include <QByteArray>
+#include "contractinfo.h"
+
+namespace Etherwall {
+
+    // persistent cache of compiled contract ABIs (functions and events with
+    // their argument layouts, signatures and selectors), keyed by ABI hash
+    // the cache file is memory mapped, entries are only deserialized on use
+    class AbiCache
+    {
+    public:
+        AbiCache(const QString& fileName);
+        ~AbiCache();
+
+        static const QByteArray key(const QJsonArray& abi);
+        bool load(const QByteArray& key, ContractFunctionList& functions, ContractEventList& events) const;
+        void store(const QByteArray& key, const ContractFunctionList& functions, const ContractEventList& events);
+        bool save();
+    private:
+        typedef QPair<qint64, qint64> EntryRange; // offset, size
+
+        QFile fFile;
+        uchar* fMap;
+        QHash<QByteArray, EntryRange> fIndex;
+        QHash<QByteArray, QByteArray> fPending;
+
+        void open();
+        void close();
+        const QByteArray entry(const QByteArray& key) const;
+    };
+
+}
+
+#endif // ABICACHE_H
@@ -26,30 +26,35 @@
 #include <QDateTime>
 #include <QFile>
 #include <QFileInfo>
+#include <QSet>
 
 #define EMPTY_BALANCE "0.000000000000000000"
 #define DEFAULT_DEVICE "geth"
 
 namespace Etherwall {
 
-    AccountModel::AccountModel(NodeIPC& ipc, const CurrencyModel& currencyModel, Trezor::TrezorDevice& trezor) :
+    AccountModel::AccountModel(NodeIPC& ipc, const CurrencyModel& currencyModel, Trezor::TrezorDevice& trezor, SettingsCache& settingsCache, RecordStore& store) :
         QAbstractListModel(0),
-        fIpc(ipc), fAccountList(), fAliasMap(), fTrezor(trezor),
+        fIpc(ipc), fAccountList(), fAccountIndex(), fAliasMap(), fTrezor(trezor),
         fSelectedAccountRow(-1), fCurrencyModel(currencyModel), fBusy(false),
-        fCurrentToken("ETH")
+        fCurrentToken("ETH"), fCurrentTokenAddress(), fNonceManager(), fSettingsCache(settingsCache), fStore(store), fBlockNumber(0), fTotal(), fStaleAccounts(), fStaleNetwork(0), fTokenAddresses()
     {
         connect(&ipc, &NodeIPC::connectToServerDone, this, &AccountModel::connectToServerDone);
+        connect(&ipc, &NodeIPC::reloadNeeded, this, &AccountModel::onReloadNeeded);
         connect(&ipc, &NodeIPC::getAccountsDone, this, &AccountModel::getAccountsDone);
         connect(&ipc, &NodeIPC::newAccountDone, this, &AccountModel::newAccountDone);
         connect(&ipc, &NodeIPC::accountBalanceChanged, this, &AccountModel::accountBalanceChanged);
         connect(&ipc, &NodeIPC::accountSentTransChanged, this, &AccountModel::accountSentTransChanged);
-        connect(&ipc, &NodeIPC::newBlock, this, &AccountModel::newBlock);
+        connect(&ipc, &NodeIPC::sendTransactionDone, this, &AccountModel::onSendTransactionDone);
+        connect(&ipc, &NodeIPC::sendTransactionFailed, this, &AccountModel::onSendFailed);
+        connect(&ipc, &NodeIPC::pendingTransactionCountDone, this, &AccountModel::onPendingTransactionCountDone);
         connect(&ipc, &NodeIPC::syncingChanged, this, &AccountModel::syncingChanged);
 
         connect(&currencyModel, &CurrencyModel::currencyChanged, this, &AccountModel::currencyChanged);
 
         connect(&trezor, &Trezor::TrezorDevice::initialized, this, &AccountModel::onTrezorInitialized);
         connect(&trezor, &Trezor::TrezorDevice::addressRetrieved, this, &AccountModel::onTrezorAddressRetrieved);
+        connect(&trezor, &Trezor::TrezorDevice::signingFailed, this, &AccountModel::onSendFailed);
     }
 
     QHash<int, QByteArray> AccountModel::roleNames() const {
@@ -81,38 +86,31 @@ namespace Etherwall {
         return result;
     }
 
-    // TODO: optimize with hashmap
     bool AccountModel::containsAccount(const QString& from, const QString& to, int& i1, int& i2) const {
-        i1 = -1;
-        i2 = -1;
-        int i = 0;
-        foreach ( const AccountInfo& a, fAccountList ) {
-            const QString addr = a.value(HashRole).toString().toLower();
-            if ( addr == from ) {
-                i1 = i;
-            }
+        return containsAccount(Address::fromHex(from), Address::fromHex(to), i1, i2);
+    }
 
-            if ( addr == to ) {
-                i2 = i;
-            }
-            i++;
-        }
+    bool AccountModel::containsAccount(const Address& from, const Address& to, int& i1, int& i2) const {
+        i1 = accountIndex(from);
+        i2 = accountIndex(to);
 
         return (i1 >= 0 || i2 >= 0);
     }
 
-    const QString AccountModel::getTotal() const {
-        BigInt::Rossi total;
-
-        foreach ( const AccountInfo& info, fAccountList ) {
-            const QVariant balance = info.value(BalanceRole);
-            double dVal = fCurrencyModel.recalculate(balance).toDouble();
-            const QString strVal = QString::number(dVal, 'f', 18);
-            total += Helpers::etherStrToRossi(strVal);
+    int AccountModel::accountIndex(const Address& address) const {
+        if ( address.isNull() ) {
+            return -1; // e.g. contract creation
         }
 
-        const QString weiStr = QString(total.toStrDec().data());
-        return Helpers::weiStrToEtherStr(weiStr);
+        return fAccountIndex.value(address, -1);
+    }
+
+    const QString AccountModel::getTotal() const {
+        const QString total = Helpers::weiStrToEtherStr(QString(fTotal.total().toStrDec().data()));
+
+        // conversion is linear, do it once on the sum
+        const QString converted = fCurrencyModel.recalculate(total).toString();
+        return Helpers::weiStrToEtherStr(QString(Helpers::etherStrToRossi(converted).toStrDec().data()));
     }
 
     int AccountModel::size() const
@@ -156,22 +154,18 @@ namespace Etherwall {
     }
 
     void AccountModel::removeAccount(const QString& address) {
-        QSettings settings;
         const QString key = address.toLower();
 
         beginResetModel();
 
-        const QString chain = fIpc.getNetworkPostfix();
-        settings.beginGroup("accounts" + chain);
-        settings.remove(key);
-        settings.endGroup();
+        fStore.remove("accounts" + fIpc.getNetworkPostfix(), key);
 
-        for ( int i = 0; i < fAccountList.size(); i++ ) {
-            if ( fAccountList.at(i).hash().toLower() == key ) {
-                fAccountList.removeAt(i);
-                break;
-            }
+        const int index = accountIndex(Address::fromHex(key));
+        if ( index >= 0 ) {
+            fAccountList.removeAt(index);
+            rebuildAccountIndex();
         }
+        clearStale(Address::fromHex(key));
 
         endResetModel();
     }
@@ -196,7 +190,18 @@ namespace Etherwall {
     quint64 AccountModel::getAccountNonce(int index) const
     {
         if ( index >= 0 && fAccountList.length() > index ) {
-            return fAccountList.at(index).transactionCount() + fIpc.nonceStart();
+            const AccountInfo& info = fAccountList.at(index);
+            return fNonceManager.next(info.hash(), info.transactionCount() + fIpc.nonceStart());
+        }
+
+        return 0; // TODO: throw
+    }
+
+    quint64 AccountModel::reserveAccountNonce(int index)
+    {
+        if ( index >= 0 && fAccountList.length() > index ) {
+            const AccountInfo& info = fAccountList.at(index);
+            return fNonceManager.reserve(info.hash(), info.transactionCount() + fIpc.nonceStart(), fBlockNumber);
         }
 
         return 0; // TODO: throw
@@ -239,11 +244,8 @@ namespace Etherwall {
     void AccountModel::setAsDefault(const QString &address)
     {
         beginResetModel();
-        QSettings settings;
-        const QString defaultKey = "default/" + fIpc.getNetworkPostfix(); // settings.value("geth/testnet", false).toBool() ? "testnetDefault" : "default";
-        settings.beginGroup("accounts");
-        settings.setValue(defaultKey, address.toLower());
-        settings.endGroup();
+        const QString defaultKey = "accounts/default/" + fIpc.getNetworkPostfix();
+        fSettingsCache.setValue(defaultKey, address.toLower());
 
         defaultIndexChanged(getDefaultIndex());
         endResetModel();
@@ -281,8 +283,10 @@ namespace Etherwall {
         }
 
         fAccountList[accountIndex].setTokenBalance(tokenAddress, balance);
+        fTokenAddresses.insert(tokenAddress);
 
         if ( fAccountList.at(accountIndex).getCurrentTokenAddress() == tokenAddress ) {
+            updateTotal(accountIndex);
             QVector<int> roles(1);
             roles[0] = BalanceRole;
             const QModelIndex& leftIndex = QAbstractListModel::createIndex(accountIndex, 0);
@@ -354,14 +358,12 @@ namespace Etherwall {
 
     int AccountModel::getAccountIndex(const QString &address) const
     {
-        const QString addressLower = address.toLower();
-        for ( int i = 0; i < fAccountList.size(); i++ ) {
-            if ( fAccountList.at(i).hash().toLower() == addressLower ) {
-                return i;
-            }
+        const int index = accountIndex(Address::fromHex(address));
+        if ( index < 0 ) {
+            throw QString("Account not found");
         }
 
-        throw QString("Account not found");
+        return index;
     }
 
     void AccountModel::selectToken(const QString& name, const QString& tokenAddress)
@@ -372,6 +374,7 @@ namespace Etherwall {
         for ( int i = 0; i < fAccountList.size(); i++ ) {
             fAccountList[i].setCurrentTokenAddress(tokenAddress);
         }
+        recomputeTotal(); // every balance is a different one now
         endResetModel();
 
         emit currentTokenChanged();
@@ -466,6 +469,7 @@ namespace Etherwall {
             beginInsertRows(QModelIndex(), fAccountList.size(), fAccountList.size());
             fAccountList.append(AccountInfo(address, QString(), fTrezor.getDeviceID(), EMPTY_BALANCE, 0, hdPath, fIpc.network()));
             fAccountList.last().setCurrentTokenAddress(fCurrentTokenAddress);
+            fAccountIndex.insert(Address::fromHex(address), fAccountList.size() - 1);
             endInsertRows();
             fIpc.refreshAccount(address, fAccountList.size() - 1); // refresh ETH
             emit existingAccountImported(Helpers::vitalizeAddress(address), fAccountList.size() - 1); // refresh ERC20 (all), NOTE: needs to be vitalized!
@@ -482,16 +486,38 @@ namespace Etherwall {
         }
     }
 
+    void AccountModel::onSendTransactionDone(const QString& hash, const QString& from, quint64 nonce) {
+        Q_UNUSED(hash);
+        if ( !from.isEmpty() ) {
+            fNonceManager.submitted(from, nonce);
+        }
+    }
+
+    void AccountModel::onSendFailed(const QString& from, quint64 nonce) {
+        fNonceManager.rollback(from, nonce);
+    }
+
+    void AccountModel::onPendingTransactionCountDone(const QString& hash, quint64 count) {
+        fNonceManager.confirmPending(hash, count + fIpc.nonceStart(), fBlockNumber);
+    }
+
     void AccountModel::connectToServerDone() {
+        fNonceManager.clear();
         loadAccountList();
         fIpc.getAccounts();
     }
 
+    // same node, just a long gap: refetch accounts and balances but keep reserved nonces
+    void AccountModel::onReloadNeeded() {
+        fIpc.getAccounts();
+    }
+
     void AccountModel::newAccountDone(const QString& hash, int index) {
         if ( !hash.isEmpty() ) {
             beginInsertRows(QModelIndex(), index, index);
             fAccountList.append(AccountInfo(hash, QString(), DEFAULT_DEVICE, EMPTY_BALANCE, 0, QString(), fIpc.network()));
             fAccountList.last().setCurrentTokenAddress(fCurrentTokenAddress);
+            fAccountIndex.insert(Address::fromHex(hash), fAccountList.size() - 1);
             endInsertRows();
             EtherLog::logMsg("New account created");
 
@@ -521,10 +547,13 @@ namespace Etherwall {
 
     void AccountModel::getAccountsDone(const QStringList& list) {
         beginResetModel();
+        QSet<Address> listed;
         foreach ( const QString& addr, list ) {
+            listed.insert(Address::fromHex(addr));
             int i1, i2;
             if ( !containsAccount(addr, "unused", i1, i2) ) {
                 fAccountList.append(AccountInfo(addr, QString(), DEFAULT_DEVICE, EMPTY_BALANCE, 0, QString(), fIpc.network()));
+                fAccountIndex.insert(Address::fromHex(addr), fAccountList.size() - 1);
             }
         }
         // drop non-hw accounts removed from geth somehow
@@ -534,12 +563,19 @@ namespace Etherwall {
                 continue; // keep hw accounts
             }
 
-            if ( !list.contains(info.hash(), Qt::CaseInsensitive) ) {
+            if ( !listed.contains(Address::fromHex(info.hash())) ) {
                 fAccountList.removeAt(i);
             }
         }
+        rebuildAccountIndex();
         endResetModel();
 
+        foreach ( const Address& address, fStaleAccounts.keys() ) {
+            if ( !fAccountIndex.contains(address) ) {
+                clearStale(address); // gone since the snapshot, won't get refreshed
+            }
+        }
+
         storeAccountList();
 
         refreshAccounts();
@@ -568,6 +604,8 @@ namespace Etherwall {
         }
 
         fAccountList[index].setBalance(balanceStr);
+        updateTotal(index);
+        clearStale(Address::fromHex(fAccountList.at(index).hash()));
         const QModelIndex& leftIndex = QAbstractListModel::createIndex(index, 0);
         const QModelIndex& rightIndex = QAbstractListModel::createIndex(index, 4);
         emit dataChanged(leftIndex, rightIndex);
@@ -581,36 +619,49 @@ namespace Etherwall {
         }
 
         fAccountList[index].setTransactionCount(count);
+        fNonceManager.confirm(fAccountList.at(index).hash(), count + fIpc.nonceStart());
         const QModelIndex& leftIndex = QAbstractListModel::createIndex(index, 0);
         const QModelIndex& rightIndex = QAbstractListModel::createIndex(index, 4);
         emit dataChanged(leftIndex, rightIndex);
     }
 
-    void AccountModel::newBlock(const QJsonObject& block) {
-        const QJsonArray transactions = block.value("transactions").toArray();
-        const QString miner = block.value("miner").toString("bogus").toLower();
+    void AccountModel::newBlock(const DecodedBlock& block) {
+        const quint64 blockNum = block.fNumber;
         int i1, i2;
-        if ( containsAccount(miner, "bogus", i1, i2) ) {
-            fIpc.refreshAccount(miner, i1);
+        if ( block.fMinerOurs && !block.fRefetch ) {
+            const int minerIndex = accountIndex(block.fMiner);
+            if ( minerIndex >= 0 ) {
+                fIpc.refreshAccount(block.fMiner.toHex(), minerIndex);
+            }
         }
 
-        foreach ( QJsonValue t, transactions ) {
-            const QJsonObject to = t.toObject();
-            const TransactionInfo info(to);
-            const QString& sender = info.value(SenderRole).toString().toLower();
-            const QString& receiver = info.value(ReceiverRole).toString().toLower();
+        // only the few flagged ones get their addresses back to strings, with the index at hand
+        for ( int i = 0; i < block.fTransactions.size(); i++ ) {
+            if ( !block.fOurs.testBit(i) ) {
+                continue;
+            }
 
-            if ( containsAccount(sender, receiver, i1, i2) ) {
+            const DecodedTransaction& tx = block.fTransactions.at(i);
+            if ( containsAccount(tx.fFrom, tx.fTo, i1, i2) ) {
                 if ( i1 >= 0 ) {
+                    const QString sender = tx.fFrom.toHex();
                     fIpc.refreshAccount(sender, i1);
+                    fNonceManager.confirm(sender, tx.fNonce + 1); // no need to wait for the count
                 }
 
                 if ( i2 >= 0 ) {
-                    fIpc.refreshAccount(receiver, i2);
+                    fIpc.refreshAccount(tx.fTo.toHex(), i2);
                 }
             }
         }
 
+        if ( blockNum > 0 && !block.fRefetch ) {
+            fBlockNumber = blockNum;
+            foreach ( const QString& address, fNonceManager.expired(blockNum) ) {
+                fIpc.getTransactionCount(address, accountIndex(Address::fromHex(address)), true);
+            }
+        }
+
         emit totalChanged();
     }
 
@@ -620,39 +671,26 @@ namespace Etherwall {
 
     int AccountModel::getDefaultIndex() const
     {
-        const QSettings settings;
         const QString defaultKey = "accounts/default/" + fIpc.getNetworkPostfix();
-        const QString address = settings.value(defaultKey).toString();
+        const QString address = fSettingsCache.value(defaultKey).toString();
 
         if ( address.isEmpty() ) {
             return 0;
         }
 
-        for ( int i = 0; i < fAccountList.size(); i++ ) {
-            if ( fAccountList.at(i).hash().toLower() == address ) {
-                return i;
-            }
-        }
-
-        return 0;
+        const int index = accountIndex(Address::fromHex(address));
+        return index >= 0 ? index : 0;
     }
 
     bool AccountModel::hasDefaultIndex() const
     {
-        const QSettings settings;
         const QString defaultKey = "accounts/default/" + fIpc.getNetworkPostfix();
-        const QString address = settings.value(defaultKey).toString();
+        const QString address = fSettingsCache.value(defaultKey).toString();
         if ( address.isEmpty() ) {
             return false;
         }
 
-        foreach ( const AccountInfo info, fAccountList ) {
-            if ( info.hash().toLower() == address ) {
-                return true;
-            }
-        }
-
-        return false;
+        return accountIndex(Address::fromHex(address)) >= 0;
     }
 
     void AccountModel::setSelectedAccountRow(int row) {
@@ -666,10 +704,8 @@ namespace Etherwall {
 
     void AccountModel::storeAccountList() const
     {
-        QSettings settings;
-
-        const QString chain = fIpc.getNetworkPostfix();
-        settings.beginGroup("accounts" + chain);
+        // unchanged entries are skipped by the store, only what changed gets written
+        const QString table = "accounts" + fIpc.getNetworkPostfix();
         int index = 0;
         foreach ( const AccountInfo& addr, fAccountList ) {
             const QString key = addr.hash().toLower();
@@ -677,27 +713,35 @@ namespace Etherwall {
             QJsonObject json = addr.toJson();
             json["index"] = index++;
             const QJsonDocument doc(json);
-            const QString serialized = doc.toJson(QJsonDocument::Compact);
 
-            settings.setValue(key, serialized);
+            fStore.put(table, key, doc.toJson(QJsonDocument::Compact));
         }
-        settings.endGroup();
     }
 
     void AccountModel::loadAccountList()
     {
-        QSettings settings;
+        const bool restored = !fStaleAccounts.isEmpty();
+        if ( restored ) { // snapshot rows get replaced, their balances are kept until refreshed
+            beginResetModel();
+            fAccountList.clear();
+            if ( fStaleNetwork != fIpc.network() ) {
+                fStaleAccounts.clear();
+                emit staleChanged(false);
+            }
+        }
 
-        const QString chain = fIpc.getNetworkPostfix();
-        settings.beginGroup("accounts" + chain);
-        const QStringList keys = settings.allKeys();
+        const QString table = "accounts" + fIpc.getNetworkPostfix();
+        const QStringList keys = fStore.keys(table);
         QList<QJsonObject> parsedList;
 
         foreach ( const QString& key, keys ) {
-            const QString serialized = settings.value(key, "invalid").toString();
-            parsedList.append(QJsonDocument::fromJson(serialized.toUtf8()).object());
+            const QJsonDocument jsonDoc = QJsonDocument::fromJson(fStore.value(table, key));
+            if ( !jsonDoc.isObject() ) { // e.g. the mainnet default account an older migration put in here
+                EtherLog::logMsg("Skipping stored account that isn't an account record: " + key, LS_Warning);
+                continue;
+            }
+            parsedList.append(jsonDoc.object());
         }
-        settings.endGroup();
 
         // SORT parsed list based on index
         std::sort(parsedList.begin(), parsedList.end(), [](const QJsonObject& a, const QJsonObject& b) {
@@ -709,9 +753,47 @@ namespace Etherwall {
             const QString alias = json.value("alias").toString();
             const QString deviceID = json.value("deviceID").toString();
             const QString hdPath = json.value("HDPath").toString();
-            fAccountList.append(AccountInfo(hash, alias, deviceID, EMPTY_BALANCE, 0, hdPath, fIpc.network()));
+            const Address address = Address::fromHex(hash);
+            if ( fStaleAccounts.contains(address) ) {
+                fAccountList.append(fStaleAccounts.value(address));
+            } else {
+                fAccountList.append(AccountInfo(hash, alias, deviceID, EMPTY_BALANCE, 0, hdPath, fIpc.network()));
+            }
             setAccountAlias(hash, alias);
         }
+
+        rebuildAccountIndex();
+        if ( restored ) {
+            endResetModel();
+            emit totalChanged();
+        }
+    }
+
+    void AccountModel::rebuildAccountIndex()
+    {
+        fAccountIndex.clear();
+        fAccountIndex.reserve(fAccountList.size());
+        for ( int i = 0; i < fAccountList.size(); i++ ) {
+            fAccountIndex.insert(Address::fromHex(fAccountList.at(i).hash()), i);
+        }
+
+        recomputeTotal(); // removed accounts have to drop out of it
+    }
+
+    void AccountModel::updateTotal(int index)
+    {
+        const Address address = Address::fromHex(fAccountList.at(index).hash());
+        const BigInt::Rossi balance = Helpers::etherStrToRossi(fAccountList.at(index).value(BalanceRole).toString());
+
+        fTotal.set(address, balance);
+    }
+
+    void AccountModel::recomputeTotal()
+    {
+        fTotal.clear();
+        for ( int i = 0; i < fAccountList.size(); i++ ) {
+            updateTotal(i);
+        }
     }
 
     const QString AccountModel::getHDPathBase() const
@@ -725,6 +807,80 @@ namespace Etherwall {
         return "m/44'/60'/0'/0";
     }
 
+    void AccountModel::clearStale(const Address& address)
+    {
+        if ( fStaleAccounts.remove(address) > 0 && fStaleAccounts.isEmpty() ) {
+            emit staleChanged(false);
+        }
+    }
+
+    bool AccountModel::getStale() const
+    {
+        return !fStaleAccounts.isEmpty();
+    }
+
+    void AccountModel::saveState(QDataStream& stream) const
+    {
+        stream << (qint32)fIpc.network() << (quint32)fAccountList.size();
+        foreach ( const AccountInfo& info, fAccountList ) {
+            AccountInfo ether = info; // balance role gives the selected token's otherwise
+            ether.setCurrentTokenAddress(QString());
+
+            QMap<QString, QString> tokens;
+            foreach ( const QString& tokenAddress, fTokenAddresses ) {
+                tokens[tokenAddress] = info.getTokenBalance(tokenAddress);
+            }
+
+            stream << QJsonDocument(info.toJson()).toJson(QJsonDocument::Compact) << ether.value(BalanceRole).toString();
+            stream << (quint64)info.transactionCount() << tokens;
+        }
+    }
+
+    void AccountModel::loadState(QDataStream& stream)
+    {
+        qint32 network;
+        quint32 count;
+        stream >> network >> count;
+
+        AccountList restored;
+        QSet<QString> tokenAddresses;
+        for ( quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++ ) {
+            QByteArray serialized;
+            QString balance;
+            quint64 transCount;
+            QMap<QString, QString> tokens;
+            stream >> serialized >> balance >> transCount >> tokens;
+
+            const QJsonObject json = QJsonDocument::fromJson(serialized).object();
+            AccountInfo info(json.value("hash").toString(), json.value("alias").toString(), json.value("deviceID").toString(),
+                             balance, transCount, json.value("HDPath").toString(), network);
+            foreach ( const QString& tokenAddress, tokens.keys() ) {
+                info.setTokenBalance(tokenAddress, tokens.value(tokenAddress));
+                tokenAddresses.insert(tokenAddress);
+            }
+            info.setCurrentTokenAddress(fCurrentTokenAddress);
+            restored.append(info);
+        }
+
+        if ( stream.status() != QDataStream::Ok || !fAccountList.isEmpty() ) {
+            return; // broken, or the node beat us to it
+        }
+
+        beginResetModel();
+        fAccountList = restored;
+        foreach ( const AccountInfo& info, restored ) {
+            fStaleAccounts[Address::fromHex(info.hash())] = info;
+            setAccountAlias(info.hash(), info.value(AliasRole).toString());
+        }
+        fStaleNetwork = network;
+        fTokenAddresses += tokenAddresses;
+        rebuildAccountIndex();
+        endResetModel();
+
+        emit staleChanged(getStale());
+        emit totalChanged();
+    }
+
     void AccountModel::setAccountAlias(const QString &hash, const QString &alias)
     {
         fAliasMap[hash.toLower()] = alias;
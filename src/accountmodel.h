@@ -27,11 +27,21 @@
 #include <QJsonArray>
 #include <QJsonValue>
 #include <QMap>
+#include <QHash>
+#include <QSet>
 #include <QUrl>
+#include <QDataStream>
 #include "types.h"
 #include "currencymodel.h"
+#include "settingscache.h"
+#include "recordstore.h"
 #include "nodeipc.h"
 #include "etherlog.h"
+#include "noncemanager.h"
+#include "balancetotal.h"
+#include "decodedblock.h"
+#include "address.h"
+#include "ethereum/bigint.h"
 #include "trezor/trezor.h"
 
 namespace Etherwall {
@@ -50,13 +60,16 @@ namespace Etherwall {
         Q_PROPERTY(bool busy MEMBER fBusy NOTIFY busyChanged)
         Q_PROPERTY(int defaultIndex READ getDefaultIndex NOTIFY defaultIndexChanged)
         Q_PROPERTY(QString currentToken READ getCurrentToken NOTIFY currentTokenChanged)
+        Q_PROPERTY(bool stale READ getStale NOTIFY staleChanged)
     public:
-        AccountModel(NodeIPC& ipc, const CurrencyModel& currencyModel, Trezor::TrezorDevice& trezor);
+        AccountModel(NodeIPC& ipc, const CurrencyModel& currencyModel, Trezor::TrezorDevice& trezor, SettingsCache& settingsCache, RecordStore& store);
         QString getError() const;
         QHash<int, QByteArray> roleNames() const;
         int rowCount(const QModelIndex & parent = QModelIndex()) const;
         QVariant data(const QModelIndex & index, int role = Qt::DisplayRole) const;
         bool containsAccount(const QString& from, const QString& to, int& i1, int& i2) const;
+        bool containsAccount(const Address& from, const Address& to, int& i1, int& i2) const;
+        int accountIndex(const Address& address) const; // -1 if not ours
         const QJsonArray getAccountsJsonArray() const;
         const QString getAccountAlias(const QString& hash) const;
         const QString getTotal() const;
@@ -71,6 +84,9 @@ namespace Etherwall {
         const QVariantList getAccountAddresses() const;
         int getAccountIndex(const QString& address) const;
         void selectToken(const QString& name, const QString& tokenAddress);
+        bool getStale() const;
+        void saveState(QDataStream& stream) const;
+        void loadState(QDataStream& stream); // accounts and balances from the last run, until refreshed
 
         Q_INVOKABLE void newAccount(const QString& pw);
         Q_INVOKABLE void renameAccount(const QString& name, int index);
@@ -79,6 +95,7 @@ namespace Etherwall {
         Q_INVOKABLE const QString getAccountHash(int index) const;
         Q_INVOKABLE const QString getAccountHDPath(int index) const;
         Q_INVOKABLE quint64 getAccountNonce(int index) const;
+        Q_INVOKABLE quint64 reserveAccountNonce(int index);
         Q_INVOKABLE void exportWallet(const QUrl& fileName) const;
         Q_INVOKABLE void importWallet(const QUrl& fileName);
         Q_INVOKABLE bool exportAccount(const QUrl& fileName, int index);
@@ -87,13 +104,17 @@ namespace Etherwall {
         Q_INVOKABLE const QString getMaxTokenValue(int accountIndex, const QString& tokenAddress) const;
     public slots:
         void onTokenBalanceDone(int accountIndex, const QString& tokenAddress, const QString& balance);
+        void newBlock(const DecodedBlock& block);
     private slots:
         void connectToServerDone();
+        void onReloadNeeded();
         void getAccountsDone(const QStringList& list);
         void newAccountDone(const QString& hash, int index);
         void accountBalanceChanged(int index, const QString& balanceStr);
         void accountSentTransChanged(int index, quint64 count);
-        void newBlock(const QJsonObject& block);
+        void onSendTransactionDone(const QString& hash, const QString& from, quint64 nonce);
+        void onSendFailed(const QString& from, quint64 nonce);
+        void onPendingTransactionCountDone(const QString& hash, quint64 count);
         void currencyChanged();
         void syncingChanged(bool syncing);
         void importWalletDone();
@@ -112,9 +133,11 @@ namespace Etherwall {
         void accountsRemoved() const;
         void currentTokenChanged() const;
         void existingAccountImported(const QString& address, int accountIndex) const;
+        void staleChanged(bool stale) const;
     private:
         NodeIPC& fIpc;
         AccountList fAccountList;
+        QHash<Address, int> fAccountIndex; // address -> row, rebuilt whenever fAccountList changes
         QMap<QString, QString> fAliasMap;
         Trezor::TrezorDevice& fTrezor;
         int fSelectedAccountRow;
@@ -123,6 +146,14 @@ namespace Etherwall {
         bool fBusy;
         QString fCurrentToken;
         QString fCurrentTokenAddress;
+        NonceManager fNonceManager;
+        SettingsCache& fSettingsCache;
+        RecordStore& fStore;
+        quint64 fBlockNumber;
+        BalanceTotal fTotal; // current token's balances, in wei or base units
+        QHash<Address, AccountInfo> fStaleAccounts; // restored from the snapshot, not refreshed yet
+        int fStaleNetwork;
+        QSet<QString> fTokenAddresses; // tokens we've seen balances of, for the snapshot
 
         int getSelectedAccountRow() const;
         int getDefaultIndex() const;
@@ -131,6 +162,10 @@ namespace Etherwall {
         const QString getSelectedAccount() const;
         void storeAccountList() const;
         void loadAccountList();
+        void rebuildAccountIndex();
+        void updateTotal(int index);
+        void recomputeTotal();
+        void clearStale(const Address& address);
         const QString getHDPathBase() const;
         void setAccountAlias(const QString& hash, const QString& alias);
         int exportableAddresses() const;
@@ -0,0 +1,82 @@
+#include "address.h"
+#include <cstring>
+
+namespace Etherwall {
+
+    static int hexNibble(ushort c) {
+        if ( c >= '0' && c <= '9' ) {
+            return c - '0';
+        }
+        if ( c >= 'a' && c <= 'f' ) {
+            return c - 'a' + 10;
+        }
+        if ( c >= 'A' && c <= 'F' ) {
+            return c - 'A' + 10;
+        }
+
+        return -1;
+    }
+
+    Address::Address() : fNull(true)
+    {
+        memset(fBytes, 0, sizeof(fBytes));
+    }
+
+    Address::Address(const QByteArray& bytes) : fNull(bytes.size() != sizeof(fBytes))
+    {
+        memset(fBytes, 0, sizeof(fBytes));
+        if ( !fNull ) {
+            memcpy(fBytes, bytes.constData(), sizeof(fBytes));
+        }
+    }
+
+    const Address Address::fromHex(const QString& hex) {
+        const int start = hex.startsWith("0x") || hex.startsWith("0X") ? 2 : 0;
+        if ( hex.length() - start != 40 ) {
+            return Address();
+        }
+
+        // straight from the QChars, no intermediate latin1 copy
+        Address result;
+        const QChar* chars = hex.constData() + start;
+        for ( int i = 0; i < 20; i++ ) {
+            const int high = hexNibble(chars[2 * i].unicode());
+            const int low = hexNibble(chars[2 * i + 1].unicode());
+            if ( high < 0 || low < 0 ) {
+                return Address();
+            }
+            result.fBytes[i] = (quint8)((high << 4) | low);
+        }
+        result.fNull = false;
+
+        return result;
+    }
+
+    bool Address::isNull() const {
+        return fNull;
+    }
+
+    const QByteArray Address::toBytes() const {
+        return fNull ? QByteArray() : QByteArray((const char*)fBytes, sizeof(fBytes));
+    }
+
+    const QString Address::toHex() const {
+        return fNull ? QString() : "0x" + QString(toBytes().toHex());
+    }
+
+    uint Address::hashValue() const {
+        // addresses are keccak output, any 4 bytes are as good as a real hash
+        uint result;
+        memcpy(&result, fBytes + 16, sizeof(result));
+        return result;
+    }
+
+    bool Address::operator==(const Address& other) const {
+        return fNull == other.fNull && memcmp(fBytes, other.fBytes, sizeof(fBytes)) == 0;
+    }
+
+    bool Address::operator!=(const Address& other) const {
+        return !(*this == other);
+    }
+
+}
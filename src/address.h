@@ -0,0 +1,40 @@
+#ifndef ADDRESS_H
+#define ADDRESS_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMetaType>
+
+namespace Etherwall {
+
+    // 20 byte account address as a plain value, cheap to copy, compare and hash.
+    // Parsing is case insensitive so checksummed and lowercase hex map to the same key
+    class Address
+    {
+    public:
+        Address();
+        explicit Address(const QByteArray& bytes); // 20 raw bytes, anything else gives a null address
+
+        static const Address fromHex(const QString& hex); // with or without 0x, null if invalid
+
+        bool isNull() const;
+        const QByteArray toBytes() const;
+        const QString toHex() const; // lowercase with 0x prefix, empty for null
+        uint hashValue() const;
+
+        bool operator==(const Address& other) const;
+        bool operator!=(const Address& other) const;
+    private:
+        quint8 fBytes[20];
+        bool fNull;
+    };
+
+    inline uint qHash(const Address& address, uint seed = 0) {
+        return address.hashValue() ^ seed;
+    }
+
+}
+
+Q_DECLARE_METATYPE(Etherwall::Address)
+
+#endif // ADDRESS_H
@@ -0,0 +1,27 @@
+#include "balancetotal.h"
+
+namespace Etherwall {
+
+    BalanceTotal::BalanceTotal() : fTotal(), fParts()
+    {
+    }
+
+    void BalanceTotal::set(const Address& address, const BigInt::Rossi& balance) {
+        fTotal = fTotal - fParts.value(address) + balance;
+        fParts[address] = balance;
+    }
+
+    void BalanceTotal::clear() {
+        fTotal = BigInt::Rossi();
+        fParts.clear();
+    }
+
+    const BigInt::Rossi BalanceTotal::total() const {
+        return fTotal;
+    }
+
+    int BalanceTotal::size() const {
+        return fParts.size();
+    }
+
+}
@@ -0,0 +1,28 @@
+#ifndef BALANCETOTAL_H
+#define BALANCETOTAL_H
+
+#include <QHash>
+#include "address.h"
+#include "ethereum/bigint.h"
+
+namespace Etherwall {
+
+    // exact sum of account balances kept up to date per account, a balance change adjusts
+    // the sum by the difference instead of adding all accounts up again
+    class BalanceTotal
+    {
+    public:
+        BalanceTotal();
+
+        void set(const Address& address, const BigInt::Rossi& balance); // replaces what the account added before
+        void clear();
+        const BigInt::Rossi total() const;
+        int size() const;
+    private:
+        BigInt::Rossi fTotal;
+        QHash<Address, BigInt::Rossi> fParts; // what each account adds to fTotal
+    };
+
+}
+
+#endif // BALANCETOTAL_H
@@ -0,0 +1,410 @@
+#include "batchsendmodel.h"
+#include "helpers.h"
+#include "etherlog.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QStandardPaths>
+#include <QRegExp>
+
+namespace Etherwall {
+
+    static const int sMaxInFlight = 16; // node handles requests one by one, just keep it busy
+    static const char* sEtherGas = "21000";
+    static const char* sTokenGas = "100000";
+
+    BatchItem::BatchItem() : fTo(), fAmount(), fToken(), fNonce(0), fStatus(BatchQueued), fHash(), fError()
+    {
+    }
+
+    BatchItem::BatchItem(const QString& to, const QString& amount, const QString& token) :
+        fTo(to), fAmount(amount), fToken(token), fNonce(0), fStatus(BatchQueued), fHash(), fError()
+    {
+    }
+
+    BatchItem::BatchItem(const QJsonObject& source) :
+        fTo(source.value("to").toString()), fAmount(source.value("amount").toString()),
+        fToken(source.value("token").toString()), fNonce(source.value("nonce").toString().toULongLong()),
+        fStatus((BatchSendStatus)source.value("status").toInt()), fHash(source.value("hash").toString()),
+        fError(source.value("error").toString())
+    {
+    }
+
+    const QJsonObject BatchItem::toJson() const {
+        QJsonObject result;
+        result["to"] = fTo;
+        result["amount"] = fAmount;
+        result["token"] = fToken;
+        result["nonce"] = QString::number(fNonce);
+        result["status"] = (int)fStatus;
+        result["hash"] = fHash;
+        result["error"] = fError;
+
+        return result;
+    }
+
+    const QVariant BatchItem::value(int role) const {
+        switch ( role ) {
+            case BatchToRole: return QVariant(fTo);
+            case BatchAmountRole: return QVariant(fAmount);
+            case BatchTokenRole: return QVariant(fToken.isEmpty() ? QString("ETH") : fToken);
+            case BatchNonceRole: return fStatus == BatchQueued ? QVariant(QString()) : QVariant(fNonce);
+            case BatchStatusRole: return QVariant((int)fStatus);
+            case BatchHashRole: return QVariant(fHash);
+            case BatchErrorRole: return QVariant(fError);
+        }
+
+        return QVariant();
+    }
+
+    BatchSendModel::BatchSendModel(TransactionModel& transactionModel, AccountModel& accountModel, ContractModel& contractModel) :
+        QAbstractListModel(0), fTransactionModel(transactionModel), fAccountModel(accountModel), fContractModel(contractModel),
+        fItems(), fRunning(false), fInFlight(0), fNextItem(0), fSentSinceStart(0), fFrom(), fPassword(), fGasPrice(),
+        fAccountIndex(-1), fTimer()
+    {
+        connect(&transactionModel, &TransactionModel::batchTransactionSent, this, &BatchSendModel::onBatchTransactionSent);
+        connect(&transactionModel, &TransactionModel::batchTransactionFailed, this, &BatchSendModel::onBatchTransactionFailed);
+
+        load();
+    }
+
+    QHash<int, QByteArray> BatchSendModel::roleNames() const {
+        QHash<int, QByteArray> roles;
+        roles[BatchToRole] = "to";
+        roles[BatchAmountRole] = "amount";
+        roles[BatchTokenRole] = "token";
+        roles[BatchNonceRole] = "nonce";
+        roles[BatchStatusRole] = "status";
+        roles[BatchHashRole] = "hash";
+        roles[BatchErrorRole] = "error";
+
+        return roles;
+    }
+
+    int BatchSendModel::rowCount(const QModelIndex & parent __attribute__ ((unused))) const {
+        return fItems.size();
+    }
+
+    QVariant BatchSendModel::data(const QModelIndex & index, int role) const {
+        if ( index.row() < 0 || index.row() >= fItems.size() ) {
+            return QVariant();
+        }
+
+        return fItems.at(index.row()).value(role);
+    }
+
+    bool BatchSendModel::getRunning() const {
+        return fRunning;
+    }
+
+    int BatchSendModel::getSentCount() const {
+        int result = 0;
+        foreach ( const BatchItem& item, fItems ) {
+            if ( item.fStatus == BatchSent ) {
+                result++;
+            }
+        }
+
+        return result;
+    }
+
+    int BatchSendModel::getFailedCount() const {
+        int result = 0;
+        foreach ( const BatchItem& item, fItems ) {
+            if ( item.fStatus == BatchFailed || item.fStatus == BatchUnknown ) {
+                result++;
+            }
+        }
+
+        return result;
+    }
+
+    double BatchSendModel::getRate() const {
+        if ( !fTimer.isValid() || fSentSinceStart == 0 ) {
+            return 0.0;
+        }
+
+        const double minutes = qMax<qint64>(fTimer.elapsed(), 1) / 60000.0;
+        return fSentSinceStart / minutes;
+    }
+
+    bool BatchSendModel::importCSV(const QUrl& fileName) {
+        if ( fRunning ) {
+            emit batchError(tr("Batch is running"));
+            return false;
+        }
+
+        QFile file(fileName.toLocalFile());
+        if ( !file.open(QFile::ReadOnly | QFile::Text) ) {
+            emit batchError(tr("Unable to open file: ") + file.errorString());
+            return false;
+        }
+
+        const QRegExp amountExp("^[0-9]+([.][0-9]{1,18})?$");
+        QList<BatchItem> items;
+        QTextStream stream(&file);
+        int lineNumber = 0;
+        while ( !stream.atEnd() ) {
+            const QString line = stream.readLine().trimmed();
+            lineNumber++;
+            if ( line.isEmpty() || line.startsWith('#') ) {
+                continue;
+            }
+
+            const QStringList fields = line.split(',');
+            const QString to = fields.at(0).trimmed();
+            if ( lineNumber == 1 && !to.startsWith("0x") ) {
+                continue; // header
+            }
+
+            const QString amount = fields.size() > 1 ? fields.at(1).trimmed() : QString();
+            QString token = fields.size() > 2 ? fields.at(2).trimmed() : QString();
+            if ( token.compare("ETH", Qt::CaseInsensitive) == 0 ) {
+                token.clear();
+            }
+
+            try {
+                if ( !QRegExp("^0x[a-fA-F0-9]{40}$").exactMatch(to) ) {
+                    throw tr("invalid address ") + to;
+                }
+                if ( to != to.toLower() && Helpers::vitalizeAddress(to) != to ) {
+                    throw tr("address checksum mismatch ") + to;
+                }
+                if ( !amountExp.exactMatch(amount) ) {
+                    throw tr("invalid amount ") + amount;
+                }
+                if ( !token.isEmpty() ) {
+                    const int contractIndex = tokenIndex(token);
+                    if ( contractIndex < 0 ) {
+                        throw tr("unknown token ") + token;
+                    }
+                    token = fContractModel.getAddress(contractIndex);
+                }
+            } catch ( QString err ) {
+                emit batchError(tr("Line ") + QString::number(lineNumber) + ": " + err);
+                return false;
+            }
+
+            items.append(BatchItem(to, amount, token));
+        }
+
+        beginResetModel();
+        fItems = items;
+        fNextItem = 0;
+        fSentSinceStart = 0;
+        fTimer.invalidate();
+        endResetModel();
+
+        save();
+        emit progressChanged();
+        EtherLog::logMsg("Imported batch of " + QString::number(items.size()) + " transfers", LS_Info);
+        return true;
+    }
+
+    void BatchSendModel::start(int accountIndex, const QString& password, const QString& gasPrice) {
+        if ( fRunning || fItems.isEmpty() ) {
+            return;
+        }
+
+        if ( !fAccountModel.getAccountHDPath(accountIndex).isEmpty() ) {
+            // each signature needs a confirmation on the device, nothing to pipeline
+            emit batchError(tr("Batch sending from TREZOR accounts is not supported"));
+            return;
+        }
+
+        const QString from = fAccountModel.getAccountHash(accountIndex);
+        if ( from.isEmpty() ) {
+            emit batchError(tr("Sender account invalid"));
+            return;
+        }
+
+        fAccountIndex = accountIndex;
+        fFrom = from;
+        fPassword = password;
+        fGasPrice = gasPrice;
+        fNextItem = 0;
+        fSentSinceStart = 0;
+        fTimer.start();
+
+        setRunning(true);
+        pump();
+    }
+
+    void BatchSendModel::stop() {
+        fPassword.clear();
+        setRunning(false); // in flight ones still finish
+    }
+
+    void BatchSendModel::clear() {
+        if ( fRunning ) {
+            return;
+        }
+
+        beginResetModel();
+        fItems.clear();
+        fNextItem = 0;
+        endResetModel();
+
+        QFile::remove(getFileName());
+        emit progressChanged();
+    }
+
+    void BatchSendModel::onBatchTransactionSent(int batchIndex, const QString& hash) {
+        if ( batchIndex < 0 || batchIndex >= fItems.size() ) {
+            return;
+        }
+
+        fInFlight--;
+        fSentSinceStart++;
+        setStatus(batchIndex, BatchSent, hash);
+        pump();
+    }
+
+    void BatchSendModel::onBatchTransactionFailed(int batchIndex, const QString& error) {
+        if ( batchIndex < 0 || batchIndex >= fItems.size() ) {
+            return;
+        }
+
+        fInFlight--;
+        setStatus(batchIndex, BatchFailed, QString(), error);
+        emit batchError(tr("Transfer to ") + fItems.at(batchIndex).fTo + tr(" failed: ") + error);
+        stop(); // its nonce is free again, restarting fills the gap
+    }
+
+    void BatchSendModel::pump() {
+        while ( fRunning && fInFlight < sMaxInFlight && fNextItem < fItems.size() ) {
+            const int index = fNextItem++;
+            const BatchSendStatus status = fItems.at(index).fStatus;
+            if ( status != BatchQueued && status != BatchFailed ) {
+                continue;
+            }
+
+            if ( !sendItem(index) ) {
+                return stop();
+            }
+        }
+
+        if ( fInFlight == 0 && fNextItem >= fItems.size() && fRunning ) {
+            setRunning(false);
+            fPassword.clear();
+            EtherLog::logMsg("Batch done, " + QString::number(fSentSinceStart) + " transfers sent at " +
+                             QString::number(getRate(), 'f', 1) + " per minute", LS_Info);
+            emit batchDone();
+        }
+    }
+
+    bool BatchSendModel::sendItem(int index) {
+        const BatchItem& item = fItems.at(index);
+        QString to = item.fTo;
+        QString value = item.fAmount;
+        QString data;
+        QString gas = sEtherGas;
+
+        if ( !item.fToken.isEmpty() ) {
+            const int contractIndex = tokenIndex(item.fToken);
+            data = contractIndex >= 0 ? fContractModel.encodeTransfer(contractIndex, item.fTo, item.fAmount) : QString();
+            if ( data.isEmpty() ) {
+                setStatus(index, BatchFailed, QString(), tr("Unable to encode token transfer"));
+                return false;
+            }
+
+            to = item.fToken;
+            value = "0";
+            gas = sTokenGas;
+        }
+
+        try {
+            const quint64 nonce = fAccountModel.reserveAccountNonce(fAccountIndex);
+            const Ethereum::Tx tx(fFrom, to, value, nonce, gas, fGasPrice, data);
+            fItems[index].fNonce = nonce;
+            setStatus(index, BatchSending);
+            fInFlight++;
+            fTransactionModel.sendBatchTransaction(fPassword, tx, nonce, index);
+        } catch ( QString err ) {
+            setStatus(index, BatchFailed, QString(), err);
+            return false;
+        }
+
+        return true;
+    }
+
+    int BatchSendModel::tokenIndex(const QString& token) const {
+        const bool isAddress = token.startsWith("0x");
+        for ( int i = 0; i < fContractModel.rowCount(); i++ ) {
+            if ( isAddress && fContractModel.getAddress(i).compare(token, Qt::CaseInsensitive) == 0 ) {
+                return i;
+            }
+
+            if ( !isAddress && fContractModel.getName(i) == token ) {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    void BatchSendModel::setStatus(int index, BatchSendStatus status, const QString& hash, const QString& error) {
+        BatchItem& item = fItems[index];
+        item.fStatus = status;
+        item.fHash = hash;
+        item.fError = error;
+
+        const QModelIndex& leftIndex = QAbstractListModel::createIndex(index, 0);
+        const QModelIndex& rightIndex = QAbstractListModel::createIndex(index, 0);
+        emit dataChanged(leftIndex, rightIndex);
+        emit progressChanged();
+
+        save(); // resumability, a few hundred lines are cheap to rewrite
+    }
+
+    void BatchSendModel::setRunning(bool running) {
+        if ( running != fRunning ) {
+            fRunning = running;
+            emit runningChanged(running);
+        }
+    }
+
+    const QString BatchSendModel::getFileName() const {
+        return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/batch.json";
+    }
+
+    void BatchSendModel::save() const {
+        QJsonArray items;
+        foreach ( const BatchItem& item, fItems ) {
+            items.append(item.toJson());
+        }
+
+        QSaveFile file(getFileName());
+        if ( !file.open(QFile::WriteOnly) ) {
+            EtherLog::logMsg("Unable to store batch state: " + file.errorString(), LS_Error);
+            return;
+        }
+
+        file.write(QJsonDocument(items).toJson(QJsonDocument::Compact));
+        if ( !file.commit() ) {
+            EtherLog::logMsg("Unable to store batch state: " + file.errorString(), LS_Error);
+        }
+    }
+
+    void BatchSendModel::load() {
+        QFile file(getFileName());
+        if ( !file.open(QFile::ReadOnly) ) {
+            return; // no batch in progress
+        }
+
+        const QJsonArray items = QJsonDocument::fromJson(file.readAll()).array();
+        foreach ( const QJsonValue& value, items ) {
+            BatchItem item(value.toObject());
+            if ( item.fStatus == BatchSending ) {
+                // we don't know if the node got it, resending could pay twice. The nonce is the one we sent with
+                item.fStatus = BatchUnknown;
+                item.fError = tr("Interrupted while sending, check if the transaction with nonce ") + QString::number(item.fNonce) +
+                              tr(" from the sending account is on chain before resending");
+            }
+            fItems.append(item);
+        }
+    }
+
+}
@@ -0,0 +1,112 @@
+#ifndef BATCHSENDMODEL_H
+#define BATCHSENDMODEL_H
+
+#include <QAbstractListModel>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QList>
+#include <QUrl>
+#include "transactionmodel.h"
+#include "accountmodel.h"
+#include "contractmodel.h"
+
+namespace Etherwall {
+
+    enum BatchSendRoles {
+        BatchToRole = Qt::UserRole + 1,
+        BatchAmountRole,
+        BatchTokenRole,
+        BatchNonceRole,
+        BatchStatusRole,
+        BatchHashRole,
+        BatchErrorRole
+    };
+
+    enum BatchSendStatus {
+        BatchQueued = 0,
+        BatchSending,
+        BatchSent,
+        BatchFailed,
+        BatchUnknown // was on its way when we went down, check on chain before resending
+    };
+
+    class BatchItem {
+    public:
+        BatchItem();
+        BatchItem(const QString& to, const QString& amount, const QString& token);
+        BatchItem(const QJsonObject& source);
+
+        const QJsonObject toJson() const;
+        const QVariant value(int role) const;
+
+        QString fTo;
+        QString fAmount;
+        QString fToken; // empty for ETH
+        quint64 fNonce;
+        BatchSendStatus fStatus;
+        QString fHash;
+        QString fError;
+    };
+
+    // payouts from a CSV of to,amount[,token] lines. Nonces are assigned up front and
+    // up to sMaxInFlight transactions are handed to the node at once so signing and
+    // submission overlap. State is kept on disk so a batch can be resumed after a restart
+    class BatchSendModel : public QAbstractListModel
+    {
+        Q_OBJECT
+        Q_PROPERTY(bool running READ getRunning NOTIFY runningChanged FINAL)
+        Q_PROPERTY(int sentCount READ getSentCount NOTIFY progressChanged FINAL)
+        Q_PROPERTY(int failedCount READ getFailedCount NOTIFY progressChanged FINAL)
+        Q_PROPERTY(double rate READ getRate NOTIFY progressChanged FINAL)
+    public:
+        BatchSendModel(TransactionModel& transactionModel, AccountModel& accountModel, ContractModel& contractModel);
+
+        QHash<int, QByteArray> roleNames() const;
+        int rowCount(const QModelIndex & parent = QModelIndex()) const;
+        QVariant data(const QModelIndex & index, int role = Qt::DisplayRole) const;
+
+        bool getRunning() const;
+        int getSentCount() const;
+        int getFailedCount() const;
+        double getRate() const; // transactions per minute since start
+
+        Q_INVOKABLE bool importCSV(const QUrl& fileName);
+        Q_INVOKABLE void start(int accountIndex, const QString& password, const QString& gasPrice);
+        Q_INVOKABLE void stop();
+        Q_INVOKABLE void clear();
+    signals:
+        void runningChanged(bool running) const;
+        void progressChanged() const;
+        void batchError(const QString& error) const;
+        void batchDone() const;
+    private slots:
+        void onBatchTransactionSent(int batchIndex, const QString& hash);
+        void onBatchTransactionFailed(int batchIndex, const QString& error);
+    private:
+        TransactionModel& fTransactionModel;
+        AccountModel& fAccountModel;
+        ContractModel& fContractModel;
+        QList<BatchItem> fItems;
+        bool fRunning;
+        int fInFlight;
+        int fNextItem;
+        int fSentSinceStart;
+        QString fFrom;
+        QString fPassword;
+        QString fGasPrice;
+        int fAccountIndex;
+        QElapsedTimer fTimer;
+
+        void pump();
+        bool sendItem(int index);
+        int tokenIndex(const QString& token) const;
+        void setStatus(int index, BatchSendStatus status, const QString& hash = QString(), const QString& error = QString());
+        void setRunning(bool running);
+        const QString getFileName() const;
+        void save() const;
+        void load();
+    };
+
+}
+
+#endif // BATCHSENDMODEL_H
@@ -0,0 +1,66 @@
+#include "blockdecoder.h"
+#include "helpers.h"
+#include <QMutexLocker>
+#include <QJsonArray>
+
+namespace Etherwall {
+
+    static const int sMaxHashOnly = 64;
+
+    BlockDecoder::BlockDecoder(NodeIPC& ipc, const AccountModel& accountModel) :
+        QObject(0), fAccountModel(accountModel), fAddresses(), fAddressesMutex(), fHashOnly()
+    {
+        qRegisterMetaType<DecodedBlock>();
+
+        // direct, so the decoding happens on the node's thread and only the result is queued to us
+        connect(&ipc, &NodeIPC::newBlock, this, &BlockDecoder::onNewBlock, Qt::DirectConnection);
+        connect(&accountModel, &AccountModel::accountsReady, this, &BlockDecoder::onAccountsReady);
+        connect(&accountModel, &AccountModel::rowsInserted, this, &BlockDecoder::onAccountsReady);
+        connect(&accountModel, &AccountModel::rowsRemoved, this, &BlockDecoder::onAccountsReady);
+    }
+
+    void BlockDecoder::onNewBlock(const QJsonObject& block) {
+        DecodedBlock decoded;
+        decoded.fNumber = Helpers::toQUInt64(block.value("number"));
+        decoded.fHash = block.value("hash").toString();
+        decoded.fMiner = Address::fromHex(block.value("miner").toString());
+
+        const QJsonArray transactions = block.value("transactions").toArray();
+        decoded.fFull = transactions.isEmpty() || transactions.first().isObject();
+        if ( decoded.fFull ) {
+            decoded.fTransactions.reserve(transactions.size());
+            foreach ( const QJsonValue& t, transactions ) {
+                decoded.fTransactions.append(DecodedTransaction(t.toObject()));
+            }
+            decoded.fRefetch = fHashOnly.removeAll(decoded.fHash) > 0; // light ingest asked for the body
+        } else {
+            fHashOnly.append(decoded.fHash);
+            while ( fHashOnly.size() > sMaxHashOnly ) {
+                fHashOnly.removeFirst();
+            }
+        }
+
+        decoded.fOurs.resize(decoded.fTransactions.size());
+        {
+            QMutexLocker locker(&fAddressesMutex);
+            decoded.fMinerOurs = fAddresses.contains(decoded.fMiner);
+            for ( int i = 0; i < decoded.fTransactions.size(); i++ ) {
+                const DecodedTransaction& tx = decoded.fTransactions.at(i);
+                decoded.fOurs.setBit(i, fAddresses.contains(tx.fFrom) || fAddresses.contains(tx.fTo));
+            }
+        }
+
+        emit blockDecoded(decoded);
+    }
+
+    void BlockDecoder::onAccountsReady() {
+        QSet<Address> addresses;
+        foreach ( const AccountInfo& info, fAccountModel.getAccounts() ) {
+            addresses.insert(Address::fromHex(info.hash()));
+        }
+
+        QMutexLocker locker(&fAddressesMutex);
+        fAddresses = addresses;
+    }
+
+}
@@ -0,0 +1,36 @@
+#ifndef BLOCKDECODER_H
+#define BLOCKDECODER_H
+
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QMutex>
+#include <QJsonObject>
+#include "nodeipc.h"
+#include "accountmodel.h"
+#include "decodedblock.h"
+
+namespace Etherwall {
+
+    // decodes new blocks straight on the node's thread and hands them to the models,
+    // addresses are compared as 20 byte keys against a snapshot of our accounts
+    class BlockDecoder : public QObject
+    {
+        Q_OBJECT
+    public:
+        BlockDecoder(NodeIPC& ipc, const AccountModel& accountModel);
+    signals:
+        void blockDecoded(const DecodedBlock& block) const;
+    private slots:
+        void onNewBlock(const QJsonObject& block);
+        void onAccountsReady();
+    private:
+        const AccountModel& fAccountModel;
+        QSet<Address> fAddresses;
+        QMutex fAddressesMutex;
+        QStringList fHashOnly; // recent hash only blocks, node thread only
+    };
+
+}
+
+#endif // BLOCKDECODER_H
@@ -0,0 +1,140 @@
+#include "callcache.h"
+#include "etherlog.h"
+#include <QSettings>
+#include <QTimer>
+#include <QCryptographicHash>
+
+namespace Etherwall {
+
+    CallCache::CallCache(NodeIPC& ipc) : QObject(0), fIpc(ipc), fBlockHash(), fResults(), fInFlight()
+    {
+        connect(&ipc, &NodeIPC::callDone, this, &CallCache::onCallDone);
+        connect(&ipc, &NodeIPC::callFailed, this, &CallCache::onCallFailed);
+        connect(&ipc, &NodeIPC::newBlock, this, &CallCache::onNewBlock);
+    }
+
+    void CallCache::call(const Ethereum::Tx& tx, int index, const QVariantMap& userData, bool immutable)
+    {
+        const QString key = callKey(tx, immutable);
+
+        if ( immutable ) {
+            QSettings settings;
+            settings.beginGroup("callcache" + getPostfix());
+            const QString stored = settings.value(key).toString();
+            settings.endGroup();
+
+            if ( !stored.isEmpty() ) {
+                return deliver(stored, index, userData);
+            }
+        } else if ( fResults.contains(key) ) {
+            return deliver(fResults.value(key), index, userData);
+        }
+
+        // same call already on its way for this block, just wait for it
+        const QString flight = flightKey(key, immutable);
+        if ( fInFlight.contains(flight) ) {
+            fInFlight[flight].append(CallWaiter(index, userData));
+            return;
+        }
+        fInFlight[flight] = QList<CallWaiter>();
+
+        QVariantMap taggedData = userData;
+        taggedData["cacheKey"] = key;
+        taggedData["cacheFlight"] = flight;
+        taggedData["cacheBlock"] = fBlockHash;
+        taggedData["cacheImmutable"] = immutable;
+        fIpc.call(tx, index, taggedData);
+    }
+
+    void CallCache::onCallDone(const QString& result, int index, const QVariantMap& userData)
+    {
+        if ( !userData.contains("cacheKey") ) { // not ours
+            emit callDone(result, index, userData);
+            return;
+        }
+
+        QVariantMap cleanData = userData;
+        const QString key = cleanData.take("cacheKey").toString();
+        const QString flight = cleanData.take("cacheFlight").toString();
+        const QString blockHash = cleanData.take("cacheBlock").toString();
+        const bool immutable = cleanData.take("cacheImmutable").toBool();
+
+        // an empty result means no code there (yet), e.g. while syncing. Don't remember that forever
+        const bool empty = result.isEmpty() || result == "0x" || result == "error";
+        if ( immutable && !empty ) {
+            QSettings settings;
+            settings.beginGroup("callcache" + getPostfix());
+            settings.setValue(key, result);
+            settings.endGroup();
+        } else if ( !immutable && result != "error" && blockHash == fBlockHash ) {
+            fResults[key] = result;
+        }
+
+        emit callDone(result, index, cleanData);
+
+        foreach ( const CallWaiter& waiter, fInFlight.take(flight) ) {
+            emit callDone(result, waiter.first, waiter.second);
+        }
+    }
+
+    void CallCache::onCallFailed(const QString& error, int index, const QVariantMap& userData)
+    {
+        if ( !userData.contains("cacheKey") ) { // not ours
+            emit callFailed(error, index, userData);
+            return;
+        }
+
+        QVariantMap cleanData = userData;
+        cleanData.remove("cacheKey");
+        cleanData.remove("cacheBlock");
+        cleanData.remove("cacheImmutable");
+        const QString flight = cleanData.take("cacheFlight").toString();
+
+        // nothing cached, the next call for it goes to the node again
+        emit callFailed(error, index, cleanData);
+        foreach ( const CallWaiter& waiter, fInFlight.take(flight) ) {
+            emit callFailed(error, waiter.first, waiter.second);
+        }
+    }
+
+    void CallCache::onNewBlock(const QJsonObject& block)
+    {
+        // new head or a reorg, either way results from the old one are stale
+        const QString hash = block.value("hash").toString();
+        if ( hash != fBlockHash ) {
+            fResults.clear();
+            fBlockHash = hash;
+        }
+    }
+
+    const QString CallCache::callKey(const Ethereum::Tx& tx, bool immutable) const
+    {
+        QString raw = tx.toStr() + "|" + tx.dataStr();
+        if ( !immutable ) { // state dependent calls can depend on sender and value too
+            raw += "|" + tx.fromStr() + "|" + tx.valueStr();
+        }
+
+        // md5 good enough here, not security related and keeps settings keys short
+        return QCryptographicHash::hash(raw.toLower().toUtf8(), QCryptographicHash::Md5).toHex();
+    }
+
+    const QString CallCache::flightKey(const QString& key, bool immutable) const
+    {
+        // a reply is only good for the block it was asked on, immutable ones for any
+        return immutable ? key : key + "@" + fBlockHash;
+    }
+
+    const QString CallCache::getPostfix() const
+    {
+        return fIpc.getNetworkPostfix();
+    }
+
+    void CallCache::deliver(const QString& result, int index, const QVariantMap& userData)
+    {
+        // keep the async contract callers expect from the node
+        QTimer::singleShot(0, this, [this, result, index, userData]() {
+            emit callDone(result, index, userData);
+        });
+    }
+
+}
@@ -0,0 +1,48 @@
+#ifndef CALLCACHE_H
+#define CALLCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QVariantMap>
+#include <QJsonObject>
+#include "nodeipc.h"
+#include "ethereum/tx.h"
+
+namespace Etherwall {
+
+    // eth_call front for the models, results are kept for the current block and
+    // identical calls in flight for the same block are only sent once. Immutable calls (e.g. token metadata)
+    // are persisted in settings and never hit the node again
+    class CallCache : public QObject
+    {
+        Q_OBJECT
+    public:
+        CallCache(NodeIPC& ipc);
+
+        void call(const Ethereum::Tx& tx, int index, const QVariantMap& userData, bool immutable = false);
+    signals:
+        void callDone(const QString& result, int index, const QVariantMap& userData) const;
+        void callFailed(const QString& error, int index, const QVariantMap& userData) const; // caller and every waiter get it
+    private slots:
+        void onCallDone(const QString& result, int index, const QVariantMap& userData);
+        void onCallFailed(const QString& error, int index, const QVariantMap& userData);
+        void onNewBlock(const QJsonObject& block);
+    private:
+        typedef QPair<int, QVariantMap> CallWaiter;
+
+        NodeIPC& fIpc;
+        QString fBlockHash;
+        QHash<QString, QString> fResults;
+        QHash<QString, QList<CallWaiter> > fInFlight; // flight key -> waiters besides the caller
+
+        const QString callKey(const Ethereum::Tx& tx, bool immutable) const;
+        const QString flightKey(const QString& key, bool immutable) const;
+        const QString getPostfix() const;
+        void deliver(const QString& result, int index, const QVariantMap& userData);
+    };
+
+}
+
+#endif // CALLCACHE_H
@@ -3,6 +3,8 @@
 #include <QDebug>
 #include "helpers.h"
 #include "etherlog.h"
+#include "abicache.h"
+#include "erc20codec.h"
 
 namespace Etherwall {
 
@@ -134,6 +136,18 @@ namespace Etherwall {
         }
     }
 
+    ContractArg::ContractArg(QDataStream& source) {
+        qint32 length, m, n;
+        source >> fName >> fType >> fBaseType >> m >> n >> length >> fIndexed;
+        fM = m;
+        fN = n;
+        fLength = length;
+    }
+
+    void ContractArg::serialize(QDataStream& target) const {
+        target << fName << fType << fBaseType << (qint32)fM << (qint32)fN << (qint32)fLength << fIndexed;
+    }
+
     int ContractArg::length() const {
         return fLength;
     }
@@ -492,6 +506,33 @@ namespace Etherwall {
         fMethodID = QString(Helpers::keccak256(fSignature.toUtf8()).left(4).toHex());
     }
 
+    ContractCallable::ContractCallable(QDataStream& source)
+    {
+        quint32 argCount, retCount;
+        source >> fName >> fSignature >> fMethodID >> argCount;
+        for ( quint32 i = 0; i < argCount && source.status() == QDataStream::Ok; i++ ) {
+            fArguments.append(ContractArg(source));
+        }
+
+        source >> retCount;
+        for ( quint32 i = 0; i < retCount && source.status() == QDataStream::Ok; i++ ) {
+            fReturns.append(ContractArg(source));
+        }
+    }
+
+    void ContractCallable::serialize(QDataStream& target) const
+    {
+        target << fName << fSignature << fMethodID << (quint32)fArguments.size();
+        foreach ( const ContractArg& arg, fArguments ) {
+            arg.serialize(target);
+        }
+
+        target << (quint32)fReturns.size();
+        foreach ( const ContractArg& ret, fReturns ) {
+            ret.serialize(target);
+        }
+    }
+
     const QString ContractCallable::getArgLiteral(const QJsonValue& arg) const {
         if ( !arg.isObject() ) {
             throw QString("Invalid argument");
@@ -583,6 +624,14 @@ namespace Etherwall {
 
     ContractEvent::ContractEvent(const QJsonObject &source) : ContractCallable(source) {
         fMethodID = QString(Helpers::keccak256(fSignature.toUtf8()).toHex());
+        buildArgModel();
+    }
+
+    ContractEvent::ContractEvent(QDataStream& source) : ContractCallable(source) {
+        buildArgModel(); // methodID is the full keccak already
+    }
+
+    void ContractEvent::buildArgModel() {
         fArgModel = QVariantList();
 
         foreach ( const ContractArg carg, fArguments ) {
@@ -646,8 +695,22 @@ namespace Etherwall {
     // ***************************** ContractFunction ***************************** //
 
     ContractFunction::ContractFunction(const QJsonObject &source) : ContractCallable(source) {
-        fArgModel = QVariantList();
         fConstant = source.value("constant").toBool(false);
+        buildArgModel();
+    }
+
+    ContractFunction::ContractFunction(QDataStream& source) : ContractCallable(source) {
+        source >> fConstant;
+        buildArgModel();
+    }
+
+    void ContractFunction::serialize(QDataStream& target) const {
+        ContractCallable::serialize(target);
+        target << fConstant;
+    }
+
+    void ContractFunction::buildArgModel() {
+        fArgModel = QVariantList();
 
         foreach ( const ContractArg carg, fArguments ) {
             fArgModel.append(carg.toVariantMap());
@@ -727,8 +790,9 @@ namespace Etherwall {
 
     EventInfo::EventInfo(const QJsonObject& source) : ResultInfo(source["data"].toString()) {
         fBlockNumber = Helpers::toQUInt64(source["blockNumber"]);
+        fLogIndex = Helpers::toQUInt64(source["logIndex"]);
         fBlockHash = source["blockHash"].toString();
-        fAddress = Helpers::vitalizeAddress(source["address"].toString());
+        fAddress = source["address"].toString(); // checksummed on first use
         fTransactionHash = source["transactionHash"].toString();
         const QVariantList topics = source["topics"].toArray().toVariantList();
         fTopics = QStringList();
@@ -750,12 +814,20 @@ namespace Etherwall {
     }
 
     const QString EventInfo::address() const {
+        if ( fChecksumAddress.isEmpty() ) {
+            fChecksumAddress = Helpers::vitalizeAddress(fAddress);
+        }
+
+        return fChecksumAddress;
+    }
+
+    const QString EventInfo::rawAddress() const {
         return fAddress;
     }
 
     const QString EventInfo::signature() const {
         QStringList vals;
-        foreach ( const QVariant param, fParams ) {
+        foreach ( const QVariant param, getParams() ) {
             vals.append(paramToStr(param));
         }
 
@@ -773,7 +845,7 @@ namespace Etherwall {
     const QVariant EventInfo::value(const int role) const {
         switch ( role ) {
             case EventNameRole: return fName;
-            case EventAddressRole: return fAddress;
+            case EventAddressRole: return address();
             case EventDataRole: return fData;
             case EventContractRole: return fContract;
             case EventBlockHashRole: return fBlockHash;
@@ -789,7 +861,24 @@ namespace Etherwall {
         return fBlockNumber;
     }
 
-    const QString EventInfo::getValue(const ContractArg arg, int &topicIndex, int &index, const QString &data)
+    quint64 EventInfo::logIndex() const {
+        return fLogIndex;
+    }
+
+    const QJsonObject EventInfo::toJson() const {
+        QJsonObject result;
+        result["blockNumber"] = "0x" + QString::number(fBlockNumber, 16);
+        result["logIndex"] = "0x" + QString::number(fLogIndex, 16);
+        result["blockHash"] = fBlockHash;
+        result["address"] = fAddress;
+        result["transactionHash"] = fTransactionHash;
+        result["data"] = fData;
+        result["topics"] = QJsonArray::fromStringList(fTopics);
+
+        return result;
+    }
+
+    const QString EventInfo::getValue(const ContractArg arg, int &topicIndex, int &index, const QString &data) const
     {
         QString val;
         if ( arg.indexed() ) {
@@ -803,20 +892,20 @@ namespace Etherwall {
 
     // ***************************** ContractInfo ***************************** //
 
-    ContractInfo::ContractInfo(const QString &name, const QString& address, const QJsonArray &abi) :
+    ContractInfo::ContractInfo(const QString &name, const QString& address, const QJsonArray &abi, AbiCache* cache) :
         fName(name), fAddress(Helpers::vitalizeAddress(address)), fABI(abi), fFunctions()
     {
-        parse();
+        parse(cache);
         fIsERC20 = checkERC20Compatibility();
     }
 
-    ContractInfo::ContractInfo(const QJsonObject &source) {
+    ContractInfo::ContractInfo(const QJsonObject &source, AbiCache* cache) {
         fName = source.value("name").toString();
         fAddress = Helpers::vitalizeAddress(source.value("address").toString());
         fABI = source.value("abi").toArray();
         fFunctions = ContractFunctionList();
 
-        parse();
+        parse(cache);
         if ( !source.contains("erc20") ) {
             fIsERC20 = checkERC20Compatibility();
         } else {
@@ -941,7 +1030,7 @@ namespace Etherwall {
     void ContractInfo::processEvent(EventInfo& info) const {
         foreach ( const ContractEvent event, fEvents ) {
             if ( event.getMethodID() == info.getMethodID() ) {
-                info.fillParams(*this, event);
+                info.bindParams(*this, event);
                 return;
             }
         }
@@ -973,7 +1062,12 @@ namespace Etherwall {
     void ContractInfo::loadSymbolData(const QString &data)
     {
         int i;
-        const QVariantList outputs = function("symbol", i).parseResponse(data);
+        const ContractFunction func = function("symbol", i);
+        if ( isStringResult(func) && ERC20::Codec<ERC20::Symbol>::decode(data, fToken) ) {
+            return;
+        }
+
+        const QVariantList outputs = func.parseResponse(data); // e.g. bytes32 symbols
         if ( outputs.size() != 1 ) {
             throw QString("Unexpected symbol result for token contract: " + fAddress);
         }
@@ -984,6 +1078,11 @@ namespace Etherwall {
 
     void ContractInfo::loadDecimalsData(const QString &data)
     {
+        if ( fIsERC20 ) {
+            fDecimals = ERC20::Codec<ERC20::Decimals>::decode(data);
+            return;
+        }
+
         int i;
         const QVariantList outputs = function("decimals", i).parseResponse(data);
         if ( outputs.size() != 1 ) {
@@ -1001,7 +1100,12 @@ namespace Etherwall {
     void ContractInfo::loadNameData(const QString &data)
     {
         int i;
-        const QVariantList outputs = function("name", i).parseResponse(data);
+        const ContractFunction func = function("name", i);
+        if ( isStringResult(func) && ERC20::Codec<ERC20::Name>::decode(data, fName) ) {
+            return;
+        }
+
+        const QVariantList outputs = func.parseResponse(data);
         if ( outputs.size() != 1 ) {
             throw QString("Unexpected name result for token contract: " + fAddress);
         }
@@ -1010,7 +1114,17 @@ namespace Etherwall {
         fName = row.value("value", "invalid").toString();
     }
 
-    void ContractInfo::parse() {
+    bool ContractInfo::isStringResult(const ContractFunction& func) const
+    {
+        return fIsERC20 && func.getReturnsCount() == 1 && func.getReturn(0).type() == "string";
+    }
+
+    void ContractInfo::parse(AbiCache* cache) {
+        const QByteArray cacheKey = cache != 0 ? AbiCache::key(fABI) : QByteArray();
+        if ( cache != 0 && cache->load(cacheKey, fFunctions, fEvents) ) {
+            return; // precompiled tables, no literal parsing or hashing needed
+        }
+
         const QJsonArray source = abiJson();
 
         foreach ( const QJsonValue val, source ) {
@@ -1028,6 +1142,10 @@ namespace Etherwall {
                 }
             }
         }
+
+        if ( cache != 0 ) {
+            cache->store(cacheKey, fFunctions, fEvents);
+        }
     }
 
     bool ContractInfo::checkERC20Compatibility()
@@ -1109,7 +1227,7 @@ namespace Etherwall {
 
     // ***************************** ResultInfo ***************************** //
 
-    ResultInfo::ResultInfo(const QString data) : fData(data)
+    ResultInfo::ResultInfo(const QString data) : fData(data), fDecoded(false)
     {
 
     }
@@ -1124,27 +1242,46 @@ namespace Etherwall {
     }
 
     void ResultInfo::fillParams(const ContractInfo &contract, const ContractCallable &source)
+    {
+        bindParams(contract, source);
+        decodeParams();
+    }
+
+    void ResultInfo::bindParams(const ContractInfo &contract, const ContractCallable &source)
     {
         fillContract(contract);
         fName = source.getName();
         fArguments = source.getArguments();
+        fParams.clear();
+        fDecoded = false;
+    }
+
+    void ResultInfo::decodeParams() const
+    {
+        if ( fDecoded ) {
+            return;
+        }
+        fDecoded = true;
 
         QString data = QString(fData);
         data.remove(0, 2); // remove the 0x
         int n = 0;
         int t = 1;
 
-        foreach ( const ContractArg arg, source.getArguments() ) {
+        // all or nothing, a throwing arg leaves no half decoded list behind
+        QVariantList params;
+        foreach ( const ContractArg arg, fArguments ) {
             QString val = getValue(arg, t, n, data);
 
             if ( arg.dynamic() ) { // value holds "pointer" to data in data
                 ulong ptr = arg.decodeInt(val, false).toUlong() * 2;
                 val = data.mid(ptr);
-                fParams.append(arg.decode(val));
+                params.append(arg.decode(val));
             } else { // value is direct
-                fParams.append(arg.decode(val));
+                params.append(arg.decode(val));
             }
         }
+        fParams = params;
     }
 
     const QString ResultInfo::contract() const
@@ -1152,7 +1289,7 @@ namespace Etherwall {
         return fContract;
     }
 
-    const QString ResultInfo::getValue(const ContractArg arg, int &topicIndex, int &index, const QString &data)
+    const QString ResultInfo::getValue(const ContractArg arg, int &topicIndex, int &index, const QString &data) const
     {
         Q_UNUSED(arg);
         Q_UNUSED(topicIndex);
@@ -1169,6 +1306,7 @@ namespace Etherwall {
     }
 
     const QVariantList ResultInfo::getParams() const {
+        decodeParams();
         return fParams;
     }
 
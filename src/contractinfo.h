@@ -8,6 +8,7 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QDataStream>
 #include "ethereum/bigint.h"
 
 #include <QDebug>
@@ -58,6 +59,7 @@ namespace Etherwall {
     {
     public:
         ContractArg(const QString& name, const QString& literal, bool indexed = false);
+        ContractArg(QDataStream& source);
 
         int length() const; // length for arrays, -1 otherwise
         int M() const; // size M for sized types, e.g. 256 for int256 or 128 for fixed128x256
@@ -74,6 +76,7 @@ namespace Etherwall {
         bool dynamic() const;
         const QVariant decode(const QString& data, bool inArray = false) const;
         static const BigInt::Rossi decodeInt(const QString& data, bool isSigned);
+        void serialize(QDataStream& target) const;
     private:
         const QString encode(const QString& text) const;
         const QString encode(const QByteArray& bytes) const;
@@ -98,6 +101,7 @@ namespace Etherwall {
     {
     public:
         ContractCallable(const QJsonObject& source);
+        ContractCallable(QDataStream& source);
 
         const QString getName() const;
         const ContractArg getArgument(int index) const;
@@ -107,6 +111,7 @@ namespace Etherwall {
         int getReturnsCount() const;
         const QString getMethodID() const;
         const QString getSignature() const;
+        void serialize(QDataStream& target) const;
     protected:
         const QString getArgLiteral(const QJsonValue& arg) const;
         const QString getArgName(const QJsonValue& arg) const;
@@ -123,11 +128,14 @@ namespace Etherwall {
     {
     public:
         ContractEvent(const QJsonObject& source);
+        ContractEvent(QDataStream& source);
 
         const QVariantList getArgModel(bool indexedOnly) const;
         const QJsonArray encodeTopics(const QVariantList& params) const;
     private:
         QVariantList fArgModel;
+
+        void buildArgModel();
     };
 
 
@@ -137,14 +145,18 @@ namespace Etherwall {
     {
     public:
         ContractFunction(const QJsonObject& source);
+        ContractFunction(QDataStream& source);
 
         const QVariantList getArgModel() const;
         const QString callData(const QVariantList& params) const;
         const QVariantList parseResponse(const QString& data) const;
         bool isConstant() const;
+        void serialize(QDataStream& target) const;
     private:
         QVariantList fArgModel;
         bool fConstant;
+
+        void buildArgModel();
     };
 
     typedef QList<ContractFunction> ContractFunctionList;
@@ -161,6 +173,7 @@ namespace Etherwall {
     };
 
     class ContractInfo;
+    class AbiCache;
 
     class ResultInfo
     {
@@ -169,6 +182,7 @@ namespace Etherwall {
         virtual ~ResultInfo();
         void fillContract(const ContractInfo& contract);
         void fillParams(const ContractInfo& contract, const ContractCallable& source);
+        void bindParams(const ContractInfo& contract, const ContractCallable& source); // params get decoded on first access
 
         const QString contract() const;
         const ContractArgs getArguments() const;
@@ -179,9 +193,11 @@ namespace Etherwall {
         QString fContract;
         QString fData;
         ContractArgs fArguments;
-        QVariantList fParams;
+        mutable QVariantList fParams;
+        mutable bool fDecoded;
 
-        virtual const QString getValue(const ContractArg arg, int &topicIndex, int &index, const QString &data);
+        void decodeParams() const;
+        virtual const QString getValue(const ContractArg arg, int &topicIndex, int &index, const QString &data) const;
     };
 
     class EventInfo : public ResultInfo
@@ -190,16 +206,21 @@ namespace Etherwall {
         EventInfo(const QJsonObject& source);
         virtual ~EventInfo();
         const QString address() const;
+        const QString rawAddress() const;
         const QString signature() const;
         const QString transactionHash() const;
         const QString getMethodID() const;
         const QVariant value(const int role) const;
         quint64 blockNumber() const;
+        quint64 logIndex() const;
+        const QJsonObject toJson() const; // raw log form, as received from the node
     protected:
-        virtual const QString getValue(const ContractArg arg, int &topicIndex, int &index, const QString &data);
+        virtual const QString getValue(const ContractArg arg, int &topicIndex, int &index, const QString &data) const;
     private:
         QString fAddress;
+        mutable QString fChecksumAddress;
         quint64 fBlockNumber;
+        quint64 fLogIndex;
         QString fTransactionHash;
         QString fBlockHash;
         QString fMethodID;
@@ -219,8 +240,8 @@ namespace Etherwall {
     class ContractInfo
     {
     public:
-        ContractInfo(const QString& name, const QString& address, const QJsonArray& abi);
-        ContractInfo(const QJsonObject& source);
+        ContractInfo(const QString& name, const QString& address, const QJsonArray& abi, AbiCache* cache = 0);
+        ContractInfo(const QJsonObject& source, AbiCache* cache = 0);
 
         const QVariant value(const int role) const;
         const QJsonObject toJson() const;
@@ -245,7 +266,7 @@ namespace Etherwall {
         void loadDecimalsData(const QString& data);
         void loadNameData(const QString& data);
     private:
-        void parse();
+        void parse(AbiCache* cache);
 
         QString fName;
         QString fAddress;
@@ -257,6 +278,7 @@ namespace Etherwall {
         bool fIsERC20;
 
         bool checkERC20Compatibility();
+        bool isStringResult(const ContractFunction& func) const;
     };
 
     typedef QList<ContractInfo> ContractList;
@@ -21,12 +21,17 @@
 #include "contractmodel.h"
 #include "etherlog.h"
 #include "helpers.h"
+#include "erc20codec.h"
+#include "address.h"
 #include <QSettings>
+#include <QStandardPaths>
 #include <QJsonDocument>
 #include <QDebug>
 
 namespace Etherwall {
 
+    static const int sMaxBalancePairs = 1000; // per aggregate balances call
+
     PendingContract::PendingContract() {
         fName = "invalid";
         fAbi = "invalid";
@@ -39,14 +44,30 @@ namespace Etherwall {
 
     // contract model
 
-    ContractModel::ContractModel(NodeIPC& ipc, AccountModel& accountModel) : QAbstractListModel(0),
-        fList(), fIpc(ipc), fNetManager(), fBusy(false), fPendingContracts(), fAccountModel(accountModel), fTokenBalanceTabs()
+    ContractModel::ContractModel(NodeIPC& ipc, CallCache& callCache, AccountModel& accountModel, RecordStore& store) : QAbstractListModel(0),
+        fList(), fIpc(ipc), fCallCache(callCache), fNetManager(), fBusy(false), fPendingContracts(), fAccountModel(accountModel), fStore(store), fTokenBalanceTabs(),
+        fPendingEvents(), fPendingEventsNew(false), fEventsTimer(),
+        fAbiCache(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/abi.cache"),
+        fPendingBalances(), fBalancesTimer()
     {
+        // events arrive one log at a time, batch everything received in one event loop pass
+        fEventsTimer.setSingleShot(true);
+        fEventsTimer.setInterval(0);
+        connect(&fEventsTimer, &QTimer::timeout, this, &ContractModel::flushEvents);
+
+        // token balance refreshes are collected the same way and sent together
+        fBalancesTimer.setSingleShot(true);
+        fBalancesTimer.setInterval(0);
+        connect(&fBalancesTimer, &QTimer::timeout, this, &ContractModel::flushTokenBalances);
+
         connect(&accountModel, &AccountModel::accountsReady, this, &ContractModel::reload);
         connect(&accountModel, &AccountModel::existingAccountImported, this, &ContractModel::onExistingAccountImported);
         connect(&ipc, &NodeIPC::newEvent, this, &ContractModel::onNewEvent);
-        connect(&ipc, &NodeIPC::callDone, this, &ContractModel::onCallDone);
+        connect(&callCache, &CallCache::callDone, this, &ContractModel::onCallDone);
+        connect(&callCache, &CallCache::callFailed, this, &ContractModel::onCallFailed);
         connect(&ipc, &NodeIPC::newAccountDone, this, &ContractModel::registerTokensFilter);
+        connect(&ipc, &NodeIPC::reloadNeeded, this, &ContractModel::onReloadNeeded);
+        connect(&ipc, &NodeIPC::connectToServerDone, this, &ContractModel::balanceCheckerChanged); // per network
         connect(&fNetManager, SIGNAL(finished(QNetworkReply*)), this, SLOT(httpRequestDone(QNetworkReply*)));
     }
 
@@ -84,16 +105,15 @@ namespace Etherwall {
             return false;
         }
 
-        const ContractInfo info(name, address, jsonDoc.array());
+        const ContractInfo info(name, address, jsonDoc.array(), &fAbiCache);
+        fAbiCache.save();
 
-        QSettings settings;
+        const QString table = "contracts" + fIpc.getNetworkPostfix();
         const QString lowerAddr = info.value(AddressRole).toString().toLower();
-        settings.beginGroup("contracts" + fIpc.getNetworkPostfix());
-        if ( settings.contains(info.value(AddressRole).toString()) ) { // we didn't lowercase before
-            settings.remove(info.value(AddressRole).toString());
+        if ( lowerAddr != info.value(AddressRole).toString() ) { // we didn't lowercase before
+            fStore.remove(table, info.value(AddressRole).toString());
         }
-        settings.setValue(lowerAddr, info.toJsonString());
-        settings.endGroup();
+        fStore.put(table, lowerAddr, info.toJsonString().toUtf8());
 
         int at = 0;
         foreach ( const ContractInfo li, fList ) {
@@ -159,11 +179,9 @@ namespace Etherwall {
             return false;
         }
 
-        QSettings settings;
-        settings.beginGroup("contracts" + fIpc.getNetworkPostfix());
-        settings.remove(fList.at(index).address()); // we didn't lowercase before
-        settings.remove(fList.at(index).address().toLower());
-        settings.endGroup();
+        const QString table = "contracts" + fIpc.getNetworkPostfix();
+        fStore.remove(table, fList.at(index).address()); // we didn't lowercase before
+        fStore.remove(table, fList.at(index).address().toLower());
 
         beginRemoveRows(QModelIndex(), index, index);
         if ( fList.at(index).isERC20() ) { // remove watch for token
@@ -350,9 +368,13 @@ namespace Etherwall {
             if ( index < 0 || index >= fList.size() ) {
                 throw QString("Invalid contract index");
             }
+            const QString valueBase = Helpers::fullStrToBaseStr(value, fList.at(index).decimals());
+            if ( fList.at(index).isERC20() ) {
+                return ERC20::Codec<ERC20::Transfer>::encode(toAddress, valueBase);
+            }
+
             int funcIndex = -1;
             const ContractFunction func = fList.at(index).function("transfer", funcIndex);
-            const QString valueBase = Helpers::fullStrToBaseStr(value, fList.at(index).decimals());
             QVariantList params;
             params.append(toAddress);
             params.append(valueBase);
@@ -439,7 +461,7 @@ namespace Etherwall {
             QVariantMap userData;
             userData["type"] = QVariant("nameCall");
             Ethereum::Tx txName(QString(), address, QString(), 0, QString(), QString(), "0x06fdde03"); // hardcoded method id for name
-            fIpc.call(txName, -1, userData);
+            fCallCache.call(txName, -1, userData, true); // names don't change
             return true;
         }
 
@@ -447,21 +469,19 @@ namespace Etherwall {
     }
 
     void ContractModel::reload() {
-        QSettings settings;
-        settings.beginGroup("contracts" + fIpc.getNetworkPostfix());
-        const QStringList list = settings.allKeys();
+        const QString table = "contracts" + fIpc.getNetworkPostfix();
+        const QStringList list = fStore.keys(table);
 
         beginResetModel();
         int index = 0;
         foreach ( const QString addr, list ) {
             QJsonParseError parseError;
-            const QString val = settings.value(addr).toString();
-            const QJsonDocument jsonDoc = QJsonDocument::fromJson(val.toUtf8(), &parseError);
+            const QJsonDocument jsonDoc = QJsonDocument::fromJson(fStore.value(table, addr), &parseError);
 
             if ( parseError.error != QJsonParseError::NoError ) {
                 EtherLog::logMsg("Error parsing stored contract: " + parseError.errorString(), LS_Error);
             } else {
-                const ContractInfo info(jsonDoc.object());
+                const ContractInfo info(jsonDoc.object(), &fAbiCache);
                 fList.append(info);
                 if ( info.needsERC20Init() ) {
                     loadERC20Data(info, index);
@@ -473,27 +493,40 @@ namespace Etherwall {
             }
         }
 
-        settings.endGroup();
         endResetModel();
+        fAbiCache.save(); // only writes if we compiled something new
 
         registerTokensFilter();
     }
 
-    void ContractModel::onNewEvent(const QJsonObject& event, bool isNew, const QString& internalFilterID) {
-        EventInfo info(event);
-        int contractIndex = 0;
-        bool found = false;
+    // token transfers in the blocks we skipped never reached us, refetch the balances
+    void ContractModel::onReloadNeeded() {
+        fTokenBalanceTabs.clear();
+        for ( int i = 0; i < fList.size(); i++ ) {
+            if ( fList.at(i).isERC20() ) {
+                onSelectedTokenContract(i, false);
+            }
+        }
+    }
+
+    int ContractModel::processEvent(EventInfo& info) const {
         // find the right contract and process/fill the params
-        foreach ( const ContractInfo ci, fList ) {
-            if ( ci.address() == info.address() ) {
+        for ( int i = 0; i < fList.size(); i++ ) {
+            const ContractInfo& ci = fList.at(i);
+            if ( QString::compare(ci.address(), info.rawAddress(), Qt::CaseInsensitive) == 0 ) {
                 ci.processEvent(info);
-                found = true;
-                break;
+                return i;
             }
-            contractIndex++;
         }
 
-        if ( !found ) {
+        return -1;
+    }
+
+    void ContractModel::onNewEvent(const QJsonObject& event, bool isNew, const QString& internalFilterID) {
+        EventInfo info(event);
+        const int contractIndex = processEvent(info);
+
+        if ( contractIndex < 0 ) {
             return EtherLog::logMsg("Contract for event not found", LS_Error);
         }
 
@@ -522,12 +555,33 @@ namespace Etherwall {
                 break;
             }
         } else if ( internalFilterID == "watchFilter" ) {
-            emit newEvent(info, isNew);
+            if ( !fPendingEvents.isEmpty() && fPendingEventsNew != isNew ) {
+                flushEvents(); // keep logs and live events in separate batches
+            }
+
+            fPendingEvents.append(info);
+            fPendingEventsNew = isNew;
+            if ( !fEventsTimer.isActive() ) {
+                fEventsTimer.start();
+            }
         } else {
             return EtherLog::logMsg("Unknown internal filterID: " + internalFilterID, LS_Error);
         }
     }
 
+    void ContractModel::flushEvents()
+    {
+        fEventsTimer.stop();
+        if ( fPendingEvents.isEmpty() ) {
+            return;
+        }
+
+        const EventList batch = fPendingEvents;
+        fPendingEvents.clear();
+
+        emit newEvents(batch, fPendingEventsNew);
+    }
+
     void ContractModel::httpRequestDone(QNetworkReply *reply) {
         QJsonObject resObj = Helpers::parseHTTPReply(reply);
         const bool success = resObj.value("success").toBool();
@@ -547,6 +601,20 @@ namespace Etherwall {
         emit abiResult(result);
     }
 
+    void ContractModel::onCallFailed(const QString& error, int index, const QVariantMap& userData)
+    {
+        Q_UNUSED(index);
+        const QString type = userData.value("type").toString();
+        if ( type.isEmpty() || type == "lightIngestCall" ) { // not ours or handled by LightIngest
+            return;
+        }
+
+        EtherLog::logMsg("Contract call " + type + " failed: " + error, LS_Warning);
+        if ( type == "balancesCall" ) {
+            fallbackTokenBalances(userData);
+        }
+    }
+
     void ContractModel::onCallDone(const QString &result, int index, const QVariantMap& userData)
     {
         if ( !userData.contains("type") ) {
@@ -555,6 +623,14 @@ namespace Etherwall {
         }
 
         const QString type = userData.value("type").toString();
+        if ( type == "balancesCall" ) { // indexes are in user data
+            return onTokenBalances(result, userData);
+        }
+
+        if ( type == "lightIngestCall" ) { // handled by LightIngest
+            return;
+        }
+
         if ( type != "nameCall" && (index < 0 || index >= fList.size()) ) {
             EtherLog::logMsg("Invalid contract index from call result", LS_Error);
             return;
@@ -593,11 +669,7 @@ namespace Etherwall {
         }
 
         const ContractInfo info = fList.at(index);
-        QSettings settings;
-        const QString lowerAddr = info.address().toLower();
-        settings.beginGroup("contracts" + fIpc.getNetworkPostfix());
-        settings.setValue(lowerAddr, info.toJsonString());
-        settings.endGroup();
+        fStore.put("contracts" + fIpc.getNetworkPostfix(), info.address().toLower(), info.toJsonString().toUtf8());
 
         emit dataChanged(QAbstractListModel::createIndex(index, 0), QAbstractListModel::createIndex(index, 0));
     }
@@ -664,24 +736,22 @@ namespace Etherwall {
 
     void ContractModel::loadERC20Data(const ContractInfo &contract, int index) const
     {
-        int i; // unused
-
         // symbol
         QVariantMap symbolData;
         symbolData["type"] = "symbolCall";
-        Ethereum::Tx txSymbol(QString(), contract.address(), QString(), 0, QString(), QString(), contract.function("symbol", i).getMethodID());
-        fIpc.call(txSymbol, index, symbolData);
+        Ethereum::Tx txSymbol(QString(), contract.address(), QString(), 0, QString(), QString(), ERC20::Codec<ERC20::Symbol>::encode());
+        fCallCache.call(txSymbol, index, symbolData, true); // token metadata is immutable
         // decimals
         QVariantMap decimalsData;
         decimalsData["type"] = "decimalsCall";
-        Ethereum::Tx txDecimals(QString(), contract.address(), QString(), 0, QString(), QString(), contract.function("decimals", i).getMethodID());
-        fIpc.call(txDecimals, index, decimalsData);
+        Ethereum::Tx txDecimals(QString(), contract.address(), QString(), 0, QString(), QString(), ERC20::Codec<ERC20::Decimals>::encode());
+        fCallCache.call(txDecimals, index, decimalsData, true);
         // name if required
         if ( contract.name().isEmpty() ) {
             QVariantMap nameData;
             nameData["type"] = "tokenNameCall";
-            Ethereum::Tx txName(QString(), contract.address(), QString(), 0, QString(), QString(), contract.function("name", i).getMethodID());
-            fIpc.call(txName, index, nameData);
+            Ethereum::Tx txName(QString(), contract.address(), QString(), 0, QString(), QString(), ERC20::Codec<ERC20::Name>::encode());
+            fCallCache.call(txName, index, nameData, true);
         }
     }
 
@@ -700,20 +770,189 @@ namespace Etherwall {
         emit callNameDone(decoded.toString());
     }
 
-    void ContractModel::refreshTokenBalance(const QString& accountAddress, int accountIndex, const ContractInfo& contract, int contractIndex) const
+    void ContractModel::refreshTokenBalance(const QString& accountAddress, int accountIndex, const ContractInfo& contract, int contractIndex)
     {
-        QVariantList params;
-        params.append(accountAddress);
+        if ( !contract.isERC20() ) {
+            return callTokenBalance(accountAddress, accountIndex, contract, contractIndex);
+        }
+
+        fPendingBalances[TokenBalancePair(contractIndex, accountIndex)] = accountAddress;
+        if ( !fBalancesTimer.isActive() ) {
+            fBalancesTimer.start();
+        }
+    }
+
+    const QString ContractModel::getBalanceChecker() const
+    {
+        const QSettings settings;
+        return settings.value("tokens/balancechecker" + fIpc.getNetworkPostfix()).toString();
+    }
+
+    void ContractModel::setBalanceChecker(const QString& address)
+    {
+        const QString checker = address.trimmed().isEmpty() ? QString() : Address::fromHex(address.trimmed()).toHex();
+        if ( !address.trimmed().isEmpty() && checker.isEmpty() ) {
+            return EtherLog::logMsg("Invalid balance checker address: " + address, LS_Error);
+        }
+
+        if ( checker == getBalanceChecker() ) {
+            return;
+        }
+
+        QSettings settings;
+        if ( checker.isEmpty() ) {
+            settings.remove("tokens/balancechecker" + fIpc.getNetworkPostfix());
+        } else {
+            settings.setValue("tokens/balancechecker" + fIpc.getNetworkPostfix(), checker);
+        }
 
-        int funcIndex = -1;
-        const ContractFunction func = contract.function("balanceOf", funcIndex);
-        const QString encoded = "0x" + func.callData(params);
+        emit balanceCheckerChanged();
+    }
+
+    void ContractModel::flushTokenBalances()
+    {
+        const PendingTokenBalances pending = fPendingBalances;
+        fPendingBalances.clear();
+
+        const QString checker = getBalanceChecker();
+
+        // tokens pending for the same accounts share calls, the checker returns the full
+        // accounts x tokens product so grouping this way encodes only the pairs we asked for
+        QMap<int, QMap<int, QString> > tokenAccounts; // contract index -> account index -> address
+        foreach ( const TokenBalancePair& pair, pending.keys() ) {
+            if ( pair.first < fList.size() ) {
+                tokenAccounts[pair.first][pair.second] = pending.value(pair);
+            }
+        }
+
+        QMap<QString, QList<int> > groups; // account indexes -> contract indexes
+        QMap<QString, QMap<int, QString> > groupAccounts;
+        foreach ( int contractIndex, tokenAccounts.keys() ) {
+            const QMap<int, QString>& accounts = tokenAccounts[contractIndex];
+            QStringList indexes;
+            foreach ( int accountIndex, accounts.keys() ) {
+                indexes.append(QString::number(accountIndex));
+            }
+
+            const QString key = indexes.join(',');
+            groups[key].append(contractIndex);
+            groupAccounts[key] = accounts;
+        }
+
+        foreach ( const QString& key, groups.keys() ) {
+            const QList<int>& contractIndexes = groups[key];
+            const QMap<int, QString>& accounts = groupAccounts[key];
+
+            if ( checker.isEmpty() || (contractIndexes.size() == 1 && accounts.size() == 1) ) {
+                foreach ( int contractIndex, contractIndexes ) {
+                    foreach ( int accountIndex, accounts.keys() ) {
+                        callTokenBalance(accounts.value(accountIndex), accountIndex, fList.at(contractIndex), contractIndex);
+                    }
+                }
+                continue;
+            }
+
+            const int tokensPerCall = qMax(1, sMaxBalancePairs / accounts.size());
+            for ( int i = 0; i < contractIndexes.size(); i += tokensPerCall ) {
+                callTokenBalances(checker, contractIndexes.mid(i, tokensPerCall), accounts);
+            }
+        }
+    }
+
+    void ContractModel::callTokenBalances(const QString& checker, const QList<int>& contractIndexes, const QMap<int, QString>& accounts) const
+    {
+        QStringList tokens;
+        QVariantList contractList;
+        foreach ( int contractIndex, contractIndexes ) {
+            tokens.append(fList.at(contractIndex).address());
+            contractList.append(contractIndex);
+        }
+
+        QVariantList accountList;
+        foreach ( int accountIndex, accounts.keys() ) {
+            accountList.append(accountIndex);
+        }
+
+        try {
+            QVariantMap userData;
+            userData["type"] = "balancesCall";
+            userData["contracts"] = contractList;
+            userData["accounts"] = accountList;
+
+            const QString encoded = ERC20::Codec<ERC20::Balances>::encode(accounts.values(), tokens);
+            Ethereum::Tx txBalances(QString(), checker, QString(), 0, QString(), QString(), encoded);
+            fCallCache.call(txBalances, -1, userData);
+        } catch ( QString err ) {
+            EtherLog::logMsg("Error encoding token balances call: " + err, LS_Error);
+        }
+    }
+
+    void ContractModel::onTokenBalances(const QString& result, const QVariantMap& userData) const
+    {
+        const QVariantList contracts = userData.value("contracts").toList();
+        const QVariantList accounts = userData.value("accounts").toList();
+
+        QStringList balances;
+        try {
+            balances = ERC20::Codec<ERC20::Balances>::decode(result);
+        } catch ( QString err ) {
+            EtherLog::logMsg("Error parsing token balances: " + err, LS_Error);
+            return fallbackTokenBalances(userData);
+        }
+
+        if ( balances.size() != contracts.size() * accounts.size() ) {
+            EtherLog::logMsg("Invalid response size for token balances call", LS_Error);
+            return fallbackTokenBalances(userData);
+        }
+
+        for ( int i = 0; i < accounts.size(); i++ ) {
+            for ( int j = 0; j < contracts.size(); j++ ) {
+                const int contractIndex = contracts.at(j).toInt();
+                if ( contractIndex >= fList.size() ) {
+                    continue; // contract removed in the meantime
+                }
+
+                const ContractInfo& contract = fList.at(contractIndex);
+                const QString balanceFull = Helpers::baseStrToFullStr(balances.at(j + contracts.size() * i), contract.decimals());
+                emit tokenBalanceDone(accounts.at(i).toInt(), contract.address(), balanceFull);
+            }
+        }
+    }
+
+    // checker call didn't work out, e.g. a wrong address in settings. Ask each token on its own
+    void ContractModel::fallbackTokenBalances(const QVariantMap& userData) const
+    {
+        const AccountList& accountList = fAccountModel.getAccounts();
+        foreach ( const QVariant& contractIndex, userData.value("contracts").toList() ) {
+            foreach ( const QVariant& accountIndex, userData.value("accounts").toList() ) {
+                const int i = contractIndex.toInt();
+                const int j = accountIndex.toInt();
+                if ( i < fList.size() && j < accountList.size() ) {
+                    callTokenBalance(accountList.at(j).hash(), j, fList.at(i), i);
+                }
+            }
+        }
+    }
+
+    void ContractModel::callTokenBalance(const QString& accountAddress, int accountIndex, const ContractInfo& contract, int contractIndex) const
+    {
+        QString encoded;
+        if ( contract.isERC20() ) {
+            encoded = ERC20::Codec<ERC20::BalanceOf>::encode(accountAddress);
+        } else {
+            QVariantList params;
+            params.append(accountAddress);
+
+            int funcIndex = -1;
+            const ContractFunction func = contract.function("balanceOf", funcIndex);
+            encoded = "0x" + func.callData(params);
+        }
         QVariantMap userData;
         userData["type"] = "balanceCall";
         userData["accountIndex"] = accountIndex;
 
         Ethereum::Tx txBalance(QString(), contract.address(), QString(), 0, QString(), QString(), encoded);
-        fIpc.call(txBalance, contractIndex, userData);
+        fCallCache.call(txBalance, contractIndex, userData);
     }
 
     void ContractModel::onTokenBalance(const QString &result, int contractIndex, int accountIndex) const
@@ -726,12 +965,21 @@ namespace Etherwall {
             return EtherLog::logMsg("Invalid account index on token balance call", LS_Error);
         }
 
-        int i;
-        QVariantList parsedSet = fList.at(contractIndex).function("balanceOf", i).parseResponse(result);
-        if ( parsedSet.size() != 1 ) {
-            return EtherLog::logMsg("Invalid response size for token balanceOf call", LS_Error);
+        QString balanceBase;
+        try {
+            if ( fList.at(contractIndex).isERC20() ) {
+                balanceBase = ERC20::Codec<ERC20::BalanceOf>::decode(result);
+            } else {
+                int i;
+                QVariantList parsedSet = fList.at(contractIndex).function("balanceOf", i).parseResponse(result);
+                if ( parsedSet.size() != 1 ) {
+                    return EtherLog::logMsg("Invalid response size for token balanceOf call", LS_Error);
+                }
+                balanceBase = parsedSet.at(0).toMap().value("value").toString();
+            }
+        } catch ( QString err ) {
+            return EtherLog::logMsg("Error parsing token balance: " + err, LS_Error);
         }
-        const QString balanceBase = parsedSet.at(0).toMap().value("value").toString();
         // we need to get decimals for contract/token and then get the "full" units
         const QString balanceFull = Helpers::baseStrToFullStr(balanceBase, fList.at(contractIndex).decimals());
 
@@ -740,11 +988,7 @@ namespace Etherwall {
 
     void ContractModel::registerTokensFilter()
     {
-        QVariantList params;
-        params.append(QVariant()); // from any
         const QVariantList accountAddresses = fAccountModel.getAccountAddresses();
-        params.insert(params.size(), accountAddresses); // to one of our addresses
-        int eventIndex; // out
         QJsonArray topics;
         QJsonArray contractAddresses;
 
@@ -754,14 +998,13 @@ namespace Etherwall {
             }
 
             contractAddresses.append(contract.address());
-            try {
-                const ContractEvent event = contract.event("Transfer", eventIndex);
-                const QJsonArray tmp = event.encodeTopics(params);
+        }
 
-                Helpers::mergeJsonArrays(topics, tmp);
-            } catch ( QString error ) {
-                return EtherLog::logMsg(error, LS_Error);
-            }
+        try {
+            // Transfer from any to one of our addresses, same topics for all tokens
+            topics = ERC20::Codec<ERC20::TransferEvent>::topics(accountAddresses);
+        } catch ( QString error ) {
+            return EtherLog::logMsg(error, LS_Error);
         }
 
         fIpc.uninstallFilter("tokensFilter");
@@ -26,9 +26,13 @@
 #include <QNetworkAccessManager>
 #include <QVariantList>
 #include <QVariantMap>
+#include <QTimer>
 #include "contractinfo.h"
+#include "abicache.h"
+#include "callcache.h"
 #include "nodeipc.h"
 #include "accountmodel.h"
+#include "recordstore.h"
 
 namespace Etherwall {
 
@@ -42,12 +46,16 @@ namespace Etherwall {
 
     typedef QMap<QString, PendingContract> PendingContracts;
 
+    typedef QPair<int, int> TokenBalancePair; // contract index, account index
+    typedef QMap<TokenBalancePair, QString> PendingTokenBalances; // pair -> account address
+
     class ContractModel : public QAbstractListModel
     {
         Q_OBJECT
         Q_PROPERTY(bool busy MEMBER fBusy NOTIFY busyChanged)
+        Q_PROPERTY(QString balanceChecker READ getBalanceChecker WRITE setBalanceChecker NOTIFY balanceCheckerChanged FINAL)
     public:
-        ContractModel(NodeIPC& ipc, AccountModel& accountModel);
+        ContractModel(NodeIPC& ipc, CallCache& callCache, AccountModel& accountModel, RecordStore& store);
 
         QHash<int, QByteArray> roleNames() const;
         int rowCount(const QModelIndex & parent = QModelIndex()) const;
@@ -73,38 +81,59 @@ namespace Etherwall {
         Q_INVOKABLE const QString encodeTopics(int index, const QString& eventName, const QVariantList& params);
         Q_INVOKABLE void requestAbi(const QString& address);
         Q_INVOKABLE bool callName(const QString& address, const QString& jsonAbi) const;
+        int processEvent(EventInfo& info) const;
+        const QString getBalanceChecker() const;
+        void setBalanceChecker(const QString& address); // empty to go back to one call per balance
     signals:
         void callError(const QString& err) const;
-        void newEvent(const EventInfo& info, bool isNew) const;
+        void newEvents(const EventList& list, bool isNew) const;
         void abiResult(const QString& abi) const;
         void busyChanged(bool busy) const;
         void callNameDone(const QString& name) const;
         void tokenBalanceDone(int accountIndex, const QString& tokenAddress, const QString& balance) const;
         void receivedTokens(const QString& value, const QString& token, const QString& sender) const;
+        void balanceCheckerChanged() const;
     public slots:
         void reload();
         void onNewEvent(const QJsonObject& event, bool isNew, const QString& internalFilterID);
         void httpRequestDone(QNetworkReply *reply);
         void onCallDone(const QString& result, int index, const QVariantMap& userData);
+        void onCallFailed(const QString& error, int index, const QVariantMap& userData);
         void onSelectedTokenContract(int index, bool forwardToAccounts = true);
         void onConfirmedTransaction(const QString &fromAddress, const QString& toAddress, const QString& hash);
         void onExistingAccountImported(const QString& address, int accountIndex);
+    private slots:
+        void flushEvents();
+        void flushTokenBalances();
+        void onReloadNeeded();
     private:
         const QString getPostfix() const;
         void loadERC20Data(const ContractInfo& contract, int index) const;
         void onCallName(const QString& result) const;
-        void refreshTokenBalance(const QString& accountAddress, int accountIndex, const ContractInfo& contract, int contractIndex) const;
+        void refreshTokenBalance(const QString& accountAddress, int accountIndex, const ContractInfo& contract, int contractIndex);
+        void callTokenBalance(const QString& accountAddress, int accountIndex, const ContractInfo& contract, int contractIndex) const;
+        void callTokenBalances(const QString& checker, const QList<int>& contractIndexes, const QMap<int, QString>& accounts) const;
         void onTokenBalance(const QString& result, int contractIndex, int accountIndex) const;
+        void onTokenBalances(const QString& result, const QVariantMap& userData) const;
+        void fallbackTokenBalances(const QVariantMap& userData) const;
         void registerTokensFilter();
         const ContractInfo& getContractByAddress(const QString& address, int& index) const;
 
         ContractList fList;
         NodeIPC& fIpc;
+        CallCache& fCallCache;
         QNetworkAccessManager fNetManager;
         bool fBusy;
         PendingContracts fPendingContracts;
         AccountModel& fAccountModel;
+        RecordStore& fStore;
         QMap<QString, bool> fTokenBalanceTabs;
+        EventList fPendingEvents;
+        bool fPendingEventsNew;
+        QTimer fEventsTimer;
+        AbiCache fAbiCache;
+        PendingTokenBalances fPendingBalances;
+        QTimer fBalancesTimer;
     };
 
 }
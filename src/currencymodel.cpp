@@ -20,7 +20,6 @@
 
 #include "currencymodel.h"
 #include <QDebug>
-#include <QSettings>
 #include <QJsonArray>
 #include <QJsonValue>
 #include <QJsonObject>
@@ -28,7 +27,7 @@
 
 namespace Etherwall {
 
-    CurrencyModel::CurrencyModel() : QAbstractListModel(0), fIndex(0), fTimer()
+    CurrencyModel::CurrencyModel(SettingsCache& settingsCache) : QAbstractListModel(0), fIndex(0), fTimer(), fSettingsCache(settingsCache), fStale(false)
     {
         connect(&fNetManager, SIGNAL(finished(QNetworkReply*)), this, SLOT(loadCurrenciesDone(QNetworkReply*)));
         loadCurrencies();
@@ -90,6 +89,45 @@ namespace Etherwall {
         return fCurrencies.size();
     }
 
+    bool CurrencyModel::getStale() const {
+        return fStale;
+    }
+
+    void CurrencyModel::saveState(QDataStream& stream) const {
+        stream << (quint32)fCurrencies.size();
+        foreach ( const CurrencyInfo& info, fCurrencies ) {
+            stream << info.name() << info.recalculate(1.0);
+        }
+    }
+
+    void CurrencyModel::loadState(QDataStream& stream) {
+        quint32 count;
+        stream >> count;
+
+        CurrencyInfos restored;
+        restored.append(CurrencyInfo("ETH", 1.0));
+        for ( quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++ ) {
+            QString name;
+            double price;
+            stream >> name >> price;
+            if ( name != "ETH" ) {
+                restored.append(CurrencyInfo(name, price));
+            }
+        }
+
+        if ( stream.status() != QDataStream::Ok || fCurrencies.size() > 1 || restored.size() <= 1 ) {
+            return; // broken, or the download was faster
+        }
+
+        beginResetModel();
+        fCurrencies = restored;
+        fStale = true;
+        endResetModel();
+
+        emit currencyChanged();
+        emit helperIndexChanged(getHelperIndex());
+    }
+
     void CurrencyModel::loadCurrencies() {
         fCurrencies.clear();
         fCurrencies.append(CurrencyInfo("ETH", 1.0));
@@ -141,6 +179,13 @@ namespace Etherwall {
         const QJsonObject c = resObj.value("currencies").toObject();
         const QJsonArray d = c.value("Data").toArray();
 
+        if ( fStale ) { // drop the snapshot prices
+            while ( fCurrencies.size() > 1 ) {
+                fCurrencies.removeLast();
+            }
+            fStale = false;
+        }
+
         foreach ( const QJsonValue p, d ) {
             const QString key = p.toObject().value("Symbol").toString("bogus");
             const float value = p.toObject().value("Price").toVariant().toFloat(0);
@@ -156,9 +201,7 @@ namespace Etherwall {
 
     int CurrencyModel::getHelperIndex() const
     {
-        const QSettings settings;
-
-        const QString currencyName = settings.value("currencies/helper", "USD").toString();
+        const QString currencyName = fSettingsCache.value("currencies/helper", "USD").toString();
         int index = 0;
 
         foreach ( const CurrencyInfo& info, fCurrencies ) {
@@ -195,8 +238,7 @@ namespace Etherwall {
         }
 
         const QString name = fCurrencies.at(index).name();
-        QSettings settings;
-        settings.setValue("currencies/helper", name);
+        fSettingsCache.setValue("currencies/helper", name);
     }
 
     int CurrencyModel::getCurrencyIndex() const {
@@ -27,8 +27,10 @@
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QTimer>
+#include <QDataStream>
 #include "etherlog.h"
 #include "types.h"
+#include "settingscache.h"
 
 namespace Etherwall {
 
@@ -39,12 +41,16 @@ namespace Etherwall {
         Q_PROPERTY(int count READ getCount NOTIFY currencyChanged FINAL)
         Q_PROPERTY(int helperIndex READ getHelperIndex NOTIFY helperIndexChanged)
         Q_PROPERTY(QString helperName READ getHelperName NOTIFY helperIndexChanged)
+        Q_PROPERTY(bool stale READ getStale NOTIFY currencyChanged)
     public:
-        CurrencyModel();
+        CurrencyModel(SettingsCache& settingsCache);
         QHash<int, QByteArray> roleNames() const;
         int rowCount(const QModelIndex & parent = QModelIndex()) const;
         QVariant data(const QModelIndex & index, int role = Qt::DisplayRole) const;
         QVariant recalculate(const QVariant& ether) const;
+        bool getStale() const;
+        void saveState(QDataStream& stream) const;
+        void loadState(QDataStream& stream); // last known prices, replaced by the next download
         int getCount() const;
         Q_INVOKABLE QString getCurrencyName(int index = -1) const;
         Q_INVOKABLE void loadCurrencies();
@@ -63,6 +69,8 @@ namespace Etherwall {
         QNetworkAccessManager fNetManager;
         int fIndex;
         QTimer fTimer;
+        SettingsCache& fSettingsCache;
+        bool fStale;
 
         int getHelperIndex() const;
         const QString getHelperName() const;
@@ -0,0 +1,24 @@
+#include "decodedblock.h"
+#include "helpers.h"
+
+namespace Etherwall {
+
+    DecodedTransaction::DecodedTransaction() : fHash(), fFrom(), fTo(), fNonce(0), fGasPrice(0), fJson()
+    {
+    }
+
+    DecodedTransaction::DecodedTransaction(const QJsonObject& json) :
+        fHash(QByteArray::fromHex(Helpers::clearHexPrefix(json.value("hash").toString()).toLatin1())),
+        fFrom(Address::fromHex(json.value("from").toString())),
+        fTo(Address::fromHex(json.value("to").toString())),
+        fNonce(Helpers::toQUInt64(json.value("nonce"))),
+        fGasPrice(Helpers::toQUInt64(json.value("gasPrice"))),
+        fJson(json)
+    {
+    }
+
+    DecodedBlock::DecodedBlock() : fNumber(0), fHash(), fMiner(), fFull(true), fRefetch(false), fTransactions(), fOurs(), fMinerOurs(false)
+    {
+    }
+
+}
@@ -0,0 +1,47 @@
+#ifndef DECODEDBLOCK_H
+#define DECODEDBLOCK_H
+
+#include <QByteArray>
+#include <QBitArray>
+#include <QVector>
+#include <QMetaType>
+#include <QJsonObject>
+#include "address.h"
+
+namespace Etherwall {
+
+    class DecodedTransaction
+    {
+    public:
+        DecodedTransaction();
+        DecodedTransaction(const QJsonObject& json);
+
+        QByteArray fHash; // 32 bytes
+        Address fFrom;
+        Address fTo; // null for contract creation
+        quint64 fNonce;
+        quint64 fGasPrice; // wei
+        QJsonObject fJson; // original, for TransactionInfo where needed
+    };
+
+    // block as the models need it, decoded once for all of them
+    class DecodedBlock
+    {
+    public:
+        DecodedBlock();
+
+        quint64 fNumber; // 0 for pending blocks
+        QString fHash;
+        Address fMiner;
+        bool fFull; // false for hash only blocks (light ingest)
+        bool fRefetch; // full body of a block already delivered hash only, per block work is done
+        QVector<DecodedTransaction> fTransactions;
+        QBitArray fOurs; // fTransactions[i] is from or to one of our accounts
+        bool fMinerOurs;
+    };
+
+}
+
+Q_DECLARE_METATYPE(Etherwall::DecodedBlock)
+
+#endif // DECODEDBLOCK_H
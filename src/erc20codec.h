@@ -0,0 +1,337 @@
+#ifndef ERC20CODEC_H
+#define ERC20CODEC_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QJsonArray>
+#include <QVariantList>
+#include "contractinfo.h"
+#include "helpers.h"
+
+namespace Etherwall {
+
+    namespace ERC20 {
+
+        // keccak256 usable in constant expressions so selectors and topics are baked in at compile time
+        namespace Keccak {
+
+            struct Hash {
+                quint8 bytes[32];
+            };
+
+            struct State {
+                quint64 lanes[25];
+            };
+
+            constexpr quint64 sRoundConstants[24] = {
+                0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+                0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+                0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+                0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+                0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+                0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+            };
+
+            constexpr int sRotations[24] = {
+                1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44
+            };
+
+            constexpr int sPiLanes[24] = {
+                10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1
+            };
+
+            constexpr int sRate = 136; // bytes absorbed per block for 256 bit output
+
+            constexpr quint64 rotl(quint64 x, int n) {
+                return (x << n) | (x >> (64 - n));
+            }
+
+            constexpr State permute(State s) {
+                for ( int round = 0; round < 24; round++ ) {
+                    // theta
+                    quint64 c[5] = {};
+                    for ( int x = 0; x < 5; x++ ) {
+                        c[x] = s.lanes[x] ^ s.lanes[x + 5] ^ s.lanes[x + 10] ^ s.lanes[x + 15] ^ s.lanes[x + 20];
+                    }
+                    for ( int x = 0; x < 5; x++ ) {
+                        const quint64 d = c[(x + 4) % 5] ^ rotl(c[(x + 1) % 5], 1);
+                        for ( int y = 0; y < 25; y += 5 ) {
+                            s.lanes[y + x] ^= d;
+                        }
+                    }
+
+                    // rho and pi
+                    quint64 t = s.lanes[1];
+                    for ( int i = 0; i < 24; i++ ) {
+                        const int j = sPiLanes[i];
+                        const quint64 tmp = s.lanes[j];
+                        s.lanes[j] = rotl(t, sRotations[i]);
+                        t = tmp;
+                    }
+
+                    // chi
+                    for ( int y = 0; y < 25; y += 5 ) {
+                        quint64 b[5] = {};
+                        for ( int x = 0; x < 5; x++ ) {
+                            b[x] = s.lanes[y + x];
+                        }
+                        for ( int x = 0; x < 5; x++ ) {
+                            s.lanes[y + x] = b[x] ^ (~b[(x + 1) % 5] & b[(x + 2) % 5]);
+                        }
+                    }
+
+                    // iota
+                    s.lanes[0] ^= sRoundConstants[round];
+                }
+
+                return s;
+            }
+
+            constexpr State absorb(State s, const char* data, int size) {
+                for ( int i = 0; i < size; i++ ) {
+                    s.lanes[i / 8] ^= quint64(quint8(data[i])) << (8 * (i % 8));
+                }
+
+                return s;
+            }
+
+            template <int N>
+            constexpr Hash hash(const char (&text)[N]) {
+                const int size = N - 1; // no terminating zero
+                State s = {};
+                int offset = 0;
+                for ( ; size - offset >= sRate; offset += sRate ) {
+                    s = permute(absorb(s, text + offset, sRate));
+                }
+
+                // last block with original keccak padding (0x01 ... 0x80)
+                const int rest = size - offset;
+                s = absorb(s, text + offset, rest);
+                s.lanes[rest / 8] ^= quint64(0x01) << (8 * (rest % 8));
+                s.lanes[(sRate - 1) / 8] ^= quint64(0x80) << (8 * ((sRate - 1) % 8));
+                s = permute(s);
+
+                Hash result = {};
+                for ( int i = 0; i < 32; i++ ) {
+                    result.bytes[i] = quint8(s.lanes[i / 8] >> (8 * (i % 8)));
+                }
+
+                return result;
+            }
+
+            template <int N>
+            constexpr quint32 selector(const char (&signature)[N]) {
+                const Hash h = hash(signature);
+                return (quint32(h.bytes[0]) << 24) | (quint32(h.bytes[1]) << 16) | (quint32(h.bytes[2]) << 8) | quint32(h.bytes[3]);
+            }
+
+        }
+
+        constexpr quint32 sBalanceOfSelector = Keccak::selector("balanceOf(address)");
+        constexpr quint32 sTransferSelector = Keccak::selector("transfer(address,uint256)");
+        constexpr quint32 sSymbolSelector = Keccak::selector("symbol()");
+        constexpr quint32 sDecimalsSelector = Keccak::selector("decimals()");
+        constexpr quint32 sNameSelector = Keccak::selector("name()");
+        constexpr Keccak::Hash sTransferTopic = Keccak::hash("Transfer(address,address,uint256)");
+        // balance checker helper contract, returns balances for every user x token pair, token 0x0 is ETH
+        constexpr quint32 sBalancesSelector = Keccak::selector("balances(address[],address[])");
+
+        static_assert(sBalanceOfSelector == 0x70a08231, "balanceOf selector mismatch");
+        static_assert(sTransferSelector == 0xa9059cbb, "transfer selector mismatch");
+        static_assert(sSymbolSelector == 0x95d89b41, "symbol selector mismatch");
+        static_assert(sDecimalsSelector == 0x313ce567, "decimals selector mismatch");
+        static_assert(sNameSelector == 0x06fdde03, "name selector mismatch");
+        static_assert(sTransferTopic.bytes[0] == 0xdd && sTransferTopic.bytes[31] == 0xef, "Transfer topic mismatch");
+
+        inline const QString selectorHex(quint32 selector) {
+            return QString("%1").arg(selector, 8, 16, QChar('0'));
+        }
+
+        inline const QString topicHex(const Keccak::Hash& topic) {
+            return "0x" + QString(QByteArray((const char*)topic.bytes, 32).toHex());
+        }
+
+        // 32 byte word for an address, with the same checks as ContractArg
+        inline const QString encodeAddress(const QString& address) {
+            QString hexStr = address;
+            if ( hexStr.startsWith("0x") ) {
+                hexStr.remove(0, 2);
+            }
+
+            if ( hexStr.length() != 40 || QByteArray::fromHex(hexStr.toUtf8()).size() != 20 ) {
+                throw QString("Invalid address: " + address);
+            }
+            if ( Helpers::vitalizeAddress("0x" + hexStr) != "0x" + hexStr ) {
+                throw QString("Address checksum mismatch: " + address);
+            }
+
+            return QString(24, QChar('0')) + hexStr.toLower();
+        }
+
+        inline const QString word(const QString& data, int index) {
+            const int start = (data.startsWith("0x") ? 2 : 0) + index * 64;
+            if ( data.length() < start + 64 ) {
+                throw QString("ERC20 result too short: " + data);
+            }
+
+            return data.mid(start, 64);
+        }
+
+        struct BalanceOf;
+        struct Transfer;
+        struct Symbol;
+        struct Decimals;
+        struct Name;
+        struct TransferEvent;
+        struct Balances;
+
+        // fixed layout encoders/decoders for the calls we do all the time
+        template <typename Call>
+        struct Codec;
+
+        template <>
+        struct Codec<BalanceOf> {
+            static const QString encode(const QString& owner) {
+                return "0x" + selectorHex(sBalanceOfSelector) + encodeAddress(owner);
+            }
+
+            // base units as decimal string
+            static const QString decode(const QString& result) {
+                return QString(ContractArg::decodeInt(word(result, 0), false).toStrDec().c_str());
+            }
+        };
+
+        template <>
+        struct Codec<Transfer> {
+            static const QString encode(const QString& to, const QString& valueBase) {
+                const BigInt::Rossi value(valueBase.toStdString(), 10);
+                return "0x" + selectorHex(sTransferSelector) + encodeAddress(to) + ContractArg::encodeInt(value);
+            }
+
+            // recipient of a transfer call's input, empty if it isn't one
+            static const QString recipient(const QString& input) {
+                const QString prefix = "0x" + selectorHex(sTransferSelector);
+                if ( input.length() < prefix.length() + 128 || !input.startsWith(prefix, Qt::CaseInsensitive) ) {
+                    return QString();
+                }
+
+                return "0x" + input.mid(prefix.length() + 24, 40).toLower();
+            }
+        };
+
+        template <>
+        struct Codec<Decimals> {
+            static const QString encode() {
+                return "0x" + selectorHex(sDecimalsSelector);
+            }
+
+            static quint8 decode(const QString& result) {
+                bool ok = false;
+                const uint decimals = word(result, 0).right(2).toUInt(&ok, 16); // uint8
+                if ( !ok ) {
+                    throw QString("Invalid decimals result: " + result);
+                }
+
+                return decimals;
+            }
+        };
+
+        // symbol and name are strings per standard, older tokens return bytes32 which the caller
+        // should handle via the generic ABI path when decode returns false
+        template <typename Call, quint32 Selector>
+        struct StringCodec {
+            static const QString encode() {
+                return "0x" + selectorHex(Selector);
+            }
+
+            static bool decode(const QString& result, QString& value) {
+                const QString prepared = result.startsWith("0x") ? result.mid(2) : result;
+                if ( prepared.length() < 128 ) {
+                    return false;
+                }
+
+                bool ok = false;
+                const int offset = word(prepared, 0).right(8).toInt(&ok, 16) * 2; // way below 2^32 for sane results
+                if ( !ok || offset + 64 > prepared.length() ) {
+                    return false;
+                }
+
+                const int size = prepared.mid(offset, 64).right(8).toInt(&ok, 16) * 2;
+                if ( !ok || offset + 64 + size > prepared.length() ) {
+                    return false;
+                }
+
+                value = QString::fromUtf8(QByteArray::fromHex(prepared.mid(offset + 64, size).toUtf8()));
+                return true;
+            }
+        };
+
+        template <>
+        struct Codec<Symbol> : public StringCodec<Symbol, sSymbolSelector> {};
+
+        template <>
+        struct Codec<Name> : public StringCodec<Name, sNameSelector> {};
+
+        template <>
+        struct Codec<TransferEvent> {
+            static const QString topic() {
+                return topicHex(sTransferTopic);
+            }
+
+            // Transfer(any, one of recipients, any)
+            static const QJsonArray topics(const QVariantList& recipients) {
+                QJsonArray to;
+                foreach ( const QVariant& recipient, recipients ) {
+                    to.append("0x" + encodeAddress(recipient.toString()));
+                }
+
+                QJsonArray result;
+                result.append(topic());
+                result.append(QJsonValue(QJsonValue::Null));
+                result.append(to);
+
+                return result;
+            }
+        };
+
+        template <>
+        struct Codec<Balances> {
+            static const QString encode(const QStringList& users, const QStringList& tokens) {
+                QString result = "0x" + selectorHex(sBalancesSelector);
+                result += ContractArg::encodeInt(64); // offset of users
+                result += ContractArg::encodeInt(64 + 32 * (1 + users.size())); // offset of tokens
+
+                result += ContractArg::encodeInt(users.size());
+                foreach ( const QString& user, users ) {
+                    result += encodeAddress(user);
+                }
+
+                result += ContractArg::encodeInt(tokens.size());
+                foreach ( const QString& token, tokens ) {
+                    result += encodeAddress(token);
+                }
+
+                return result;
+            }
+
+            // base unit balances as decimal strings, balance of users[i] in tokens[j] is at j + tokens.size() * i
+            static const QStringList decode(const QString& result) {
+                const int offset = word(result, 0).right(8).toInt(0, 16) / 32;
+                const int count = word(result, offset).right(8).toInt(0, 16);
+
+                QStringList balances;
+                for ( int i = 0; i < count; i++ ) {
+                    balances.append(QString(ContractArg::decodeInt(word(result, offset + 1 + i), false).toStrDec().c_str()));
+                }
+
+                return balances;
+            }
+        };
+
+    }
+
+}
+
+#endif // ERC20CODEC_H
@@ -0,0 +1,131 @@
+#include "eventarchive.h"
+#include "etherlog.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+
+namespace Etherwall {
+
+    EventArchive::EventArchive(const QString& fileName) : fFileName(fileName), fPageOffsets()
+    {
+        QDir().mkpath(QFileInfo(fileName).absolutePath());
+        clear(); // contents from previous runs are reloaded from the node
+    }
+
+    void EventArchive::clear() {
+        fPageOffsets.clear();
+        QFile file(fFileName);
+        if ( file.exists() && !file.resize(0) ) {
+            EtherLog::logMsg("Unable to truncate event archive: " + file.errorString(), LS_Error);
+        }
+    }
+
+    bool EventArchive::storePage(const EventList& list) {
+        if ( list.isEmpty() ) {
+            return true;
+        }
+
+        QFile file(fFileName);
+        if ( !file.open(QIODevice::WriteOnly | QIODevice::Append) ) {
+            EtherLog::logMsg("Unable to open event archive: " + file.errorString(), LS_Error);
+            return false;
+        }
+
+        const qint64 offset = file.size();
+        QByteArray page;
+        foreach ( const EventInfo& info, list ) {
+            page.append(QJsonDocument(info.toJson()).toJson(QJsonDocument::Compact));
+            page.append('\n');
+        }
+
+        if ( file.write(page) != page.size() ) {
+            EtherLog::logMsg("Unable to write event archive: " + file.errorString(), LS_Error);
+            file.close();
+            file.resize(offset);
+            return false;
+        }
+
+        fPageOffsets.append(offset);
+        return true;
+    }
+
+    const QList<QJsonObject> EventArchive::takePage() {
+        QList<QJsonObject> result;
+        if ( fPageOffsets.isEmpty() ) {
+            return result;
+        }
+
+        const qint64 offset = fPageOffsets.takeLast();
+        QFile file(fFileName);
+        if ( !file.open(QIODevice::ReadWrite) ) {
+            EtherLog::logMsg("Unable to open event archive: " + file.errorString(), LS_Error);
+            return result;
+        }
+
+        if ( !file.seek(offset) ) {
+            EtherLog::logMsg("Invalid event archive offset: " + QString::number(offset), LS_Error);
+            return result;
+        }
+
+        while ( !file.atEnd() ) {
+            const QByteArray line = file.readLine().trimmed();
+            if ( line.isEmpty() ) {
+                continue;
+            }
+
+            const QJsonDocument doc = QJsonDocument::fromJson(line);
+            if ( !doc.isObject() ) {
+                EtherLog::logMsg("Invalid event archive entry", LS_Error);
+                continue;
+            }
+            result.append(doc.object());
+        }
+
+        file.resize(offset); // page is back in memory, drop it from the stack
+
+        return result;
+    }
+
+    const QList<QJsonObject> EventArchive::readAll() const {
+        QList<QJsonObject> result;
+        if ( fPageOffsets.isEmpty() ) {
+            return result;
+        }
+
+        QFile file(fFileName);
+        if ( !file.open(QIODevice::ReadOnly) ) {
+            EtherLog::logMsg("Unable to open event archive: " + file.errorString(), LS_Error);
+            return result;
+        }
+
+        qint64 end = file.size();
+        for ( int i = fPageOffsets.size() - 1; i >= 0; i-- ) {
+            const qint64 offset = fPageOffsets.at(i);
+            if ( !file.seek(offset) ) {
+                EtherLog::logMsg("Invalid event archive offset: " + QString::number(offset), LS_Error);
+                return result;
+            }
+
+            const QList<QByteArray> lines = file.read(end - offset).split('\n');
+            foreach ( const QByteArray& line, lines ) {
+                const QJsonDocument doc = QJsonDocument::fromJson(line);
+                if ( doc.isObject() ) {
+                    result.append(doc.object());
+                }
+            }
+            end = offset;
+        }
+
+        return result;
+    }
+
+    bool EventArchive::hasPages() const {
+        return !fPageOffsets.isEmpty();
+    }
+
+    int EventArchive::pageCount() const {
+        return fPageOffsets.size();
+    }
+
+}
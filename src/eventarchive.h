@@ -0,0 +1,31 @@
+#ifndef EVENTARCHIVE_H
+#define EVENTARCHIVE_H
+
+#include <QString>
+#include <QList>
+#include <QJsonObject>
+#include "contractinfo.h"
+
+namespace Etherwall {
+
+    // append-only on-disk stack of event pages spilled from EventModel
+    // each page is stored as json lines of raw logs, the last stored page is read back first
+    class EventArchive
+    {
+    public:
+        EventArchive(const QString& fileName);
+
+        void clear();
+        bool storePage(const EventList& list);
+        const QList<QJsonObject> takePage();
+        const QList<QJsonObject> readAll() const; // newest page first, leaves the archive intact
+        bool hasPages() const;
+        int pageCount() const;
+    private:
+        QString fFileName;
+        QList<qint64> fPageOffsets;
+    };
+
+}
+
+#endif // EVENTARCHIVE_H
@@ -1,14 +1,30 @@
 #include "eventmodel.h"
+#include <algorithm>
+#include <iterator>
+#include "etherlog.h"
+#include <QSettings>
+#include <QStandardPaths>
+#include <QFile>
+#include <QTextStream>
+#include <QtConcurrent/QtConcurrent>
 
 namespace Etherwall {
 
     EventModel::EventModel(const ContractModel& contractModel, const FilterModel& filterModel) :
-        QAbstractListModel(0), fContractModel(contractModel), fList()
+        QAbstractListModel(0), fContractModel(contractModel), fList(),
+        fArchive(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/events.log"), fSeen(),
+        fExportList(), fExportFileName(), fExportWatcher(), fExportFailures(0)
     {
-        connect(&contractModel, &ContractModel::newEvent, this, &EventModel::onNewEvent);
+        connect(&fExportWatcher, &QFutureWatcher<void>::finished, this, &EventModel::onExportDecoded);
+        connect(&contractModel, &ContractModel::newEvents, this, &EventModel::onNewEvents);
         connect(&filterModel, &FilterModel::beforeLoadLogs, this, &EventModel::onBeforeLoadLogs);
     }
 
+    EventModel::~EventModel()
+    {
+        fExportWatcher.waitForFinished(); // workers decode into fExportList
+    }
+
     QHash<int, QByteArray> EventModel::roleNames() const {
         QHash<int, QByteArray> roles;
         roles[EventNameRole] = "name";
@@ -27,10 +43,42 @@ namespace Etherwall {
         return fList.size();
     }
 
+    // decodes on the row itself so the result is cached there, bad data gets logged once and shows empty
+    static const QVariantList eventParams(const EventInfo& info) {
+        try {
+            return info.getParams();
+        } catch ( QString err ) {
+            EtherLog::logMsg("Unable to decode event " + info.value(EventNameRole).toString() + ": " + err, LS_Warning);
+        }
+
+        return QVariantList();
+    }
+
     QVariant EventModel::data(const QModelIndex & index, int role) const {
         return fList.at(index.row()).value(role);
     }
 
+    bool EventModel::canFetchMore(const QModelIndex & parent) const {
+        return !parent.isValid() && fArchive.hasPages();
+    }
+
+    void EventModel::fetchMore(const QModelIndex & parent) {
+        if ( parent.isValid() ) {
+            return;
+        }
+
+        // bring back the newest spilled page, it continues right below our last row
+        const QList<QJsonObject> page = fArchive.takePage();
+        EventList list;
+        foreach ( const QJsonObject& log, page ) {
+            EventInfo info(log);
+            fContractModel.processEvent(info);
+            list.append(info);
+        }
+
+        insertEvents(list);
+    }
+
     const QString EventModel::getName(int index) const {
         if ( index < 0 || index >= fList.length() ) {
             return QString();
@@ -101,7 +149,7 @@ namespace Etherwall {
         }
 
         const ContractArgs args = fList.at(index).getArguments();
-        const QVariantList params = fList.at(index).getParams();
+        const QVariantList params = eventParams(fList.at(index));
         QVariantList result;
         QVariantMap map;
 
@@ -109,7 +157,8 @@ namespace Etherwall {
         foreach ( const ContractArg arg, args ) {
             map["name"] = arg.name();
             map["type"] = arg.type();
-            QString strVal = fList.at(index).paramToStr(params.at(i++));
+            QString strVal = i < params.size() ? fList.at(index).paramToStr(params.at(i)) : QString();
+            i++;
             map["value"] = strVal;
             result.append(map);
         }
@@ -122,24 +171,130 @@ namespace Etherwall {
             return QString();
         }
 
-        const QVariant value = fList.at(index).getParams().at(index);
+        const QVariantList params = eventParams(fList.at(index));
+        if ( index >= params.size() ) {
+            return QString();
+        }
+
+        const QVariant value = params.at(index);
         QString strVal = fList.at(index).paramToStr(value);
 
         return strVal;
     }
 
-    void EventModel::onNewEvent(const EventInfo& info, bool isNew) {
-        // sort by block number descending
-        int index = 0;
-        while ( index < fList.length() && fList.at(index).blockNumber() > info.blockNumber() ) {
-            index++;
+    static const int sSpillPageSize = 500;
+
+    static bool decodeEvent(EventInfo& info) {
+        try {
+            info.getParams(); // decodes and caches on the instance
+        } catch ( QString err ) {
+            Q_UNUSED(err); // runs on a pool thread, the caller counts it and the event is exported without values
+            return false;
+        }
+
+        return true;
+    }
+
+    static const QString csvField(const QString& value) {
+        QString result = value;
+        return "\"" + result.replace("\"", "\"\"") + "\"";
+    }
+
+    static bool eventBlockDescending(const EventInfo& a, const EventInfo& b) {
+        return a.blockNumber() > b.blockNumber();
+    }
+
+    bool EventModel::exportEvents(const QUrl& fileName) {
+        if ( fExportWatcher.isRunning() ) {
+            EtherLog::logMsg("Events export already in progress", LS_Warning);
+            return false;
+        }
+
+        fExportFileName = fileName.toLocalFile();
+        QFile file(fExportFileName);
+        if ( !file.open(QFile::WriteOnly | QFile::Truncate) ) {
+            EtherLog::logMsg("Events export file error: " + file.errorString(), LS_Error);
+            return false;
+        }
+        file.close();
+
+        // archived pages are only decoded for the export itself
+        fExportList = fList;
+        foreach ( const QJsonObject& log, fArchive.readAll() ) {
+            EventInfo info(log);
+            fContractModel.processEvent(info);
+            fExportList.append(info);
+        }
+
+        // split decoding across the global thread pool, each event owns its own copy
+        // of the ABI arguments so workers share no decoder state, order is kept in place
+        fExportFailures.store(0);
+        fExportWatcher.setFuture(QtConcurrent::map(fExportList, [this](EventInfo& info) {
+            if ( !decodeEvent(info) ) {
+                fExportFailures.ref();
+            }
+        }));
+        return true;
+    }
+
+    void EventModel::onExportDecoded() {
+        QFile file(fExportFileName);
+        if ( !file.open(QFile::WriteOnly | QFile::Truncate) ) {
+            EtherLog::logMsg("Events export file error: " + file.errorString(), LS_Error);
+            fExportList.clear();
+            emit eventsExported(fExportFileName, false);
+            return;
+        }
+
+        QTextStream stream(&file);
+        stream << "block,transaction,contract,address,event\n";
+        foreach ( const EventInfo& info, fExportList ) {
+            stream << info.blockNumber() << ','
+                   << info.transactionHash() << ','
+                   << csvField(info.contract()) << ','
+                   << info.address() << ','
+                   << csvField(info.signature()) << '\n';
+        }
+        file.close();
+        fExportList.clear();
+
+        const int failures = fExportFailures.load();
+        if ( failures > 0 ) {
+            EtherLog::logMsg("Events export: " + QString::number(failures) + " events couldn't be decoded, exported without values", LS_Warning);
+        }
+
+        emit eventsExported(fExportFileName, true);
+    }
+
+    static const QString eventKey(const EventInfo& info) {
+        return info.transactionHash() + "_" + QString::number(info.logIndex());
+    }
+
+    void EventModel::onNewEvents(const EventList& received, bool isNew) {
+        EventList list;
+        foreach ( const EventInfo& info, received ) {
+            const QString key = eventKey(info);
+            if ( !fSeen.contains(key) ) {
+                fSeen.insert(key);
+                list.append(info);
+            }
         }
 
-        beginInsertRows(QModelIndex(), index, index);
-        fList.insert(index, info);
-        endInsertRows();
+        if ( !isNew ) { // history, rows decode when first shown
+            insertEvents(list);
+            spillEvents();
+            return;
+        }
+
+        // the notification needs the values anyhow, decode once before the rows get stored
+        // so they keep the result, the signatures below then come from the cache
+        for ( int i = 0; i < list.size(); i++ ) {
+            eventParams(list.at(i));
+        }
+        insertEvents(list);
+        spillEvents();
 
-        if ( isNew ) {
+        foreach ( const EventInfo& info, list ) {
             emit receivedEvent(info.contract(), info.signature());
         }
     }
@@ -147,7 +302,57 @@ namespace Etherwall {
     void EventModel::onBeforeLoadLogs() {
         beginResetModel();
         fList.clear();
+        fArchive.clear();
+        fSeen.clear();
         endResetModel();
     }
 
+    void EventModel::insertEvents(const EventList& list) {
+        if ( list.isEmpty() ) {
+            return;
+        }
+
+        // sort by block number descending
+        EventList batch = list;
+        std::stable_sort(batch.begin(), batch.end(), eventBlockDescending);
+
+        if ( fList.isEmpty() || batch.last().blockNumber() >= fList.first().blockNumber() ) {
+            beginInsertRows(QModelIndex(), 0, batch.size() - 1);
+            fList = batch + fList;
+            endInsertRows();
+        } else if ( batch.first().blockNumber() < fList.last().blockNumber() ) {
+            beginInsertRows(QModelIndex(), fList.size(), fList.size() + batch.size() - 1);
+            fList.append(batch);
+            endInsertRows();
+        } else {
+            // interleaved with existing rows, merge in one pass, new events go before same block ones
+            EventList merged;
+            merged.reserve(fList.size() + batch.size());
+            std::merge(batch.begin(), batch.end(), fList.begin(), fList.end(), std::back_inserter(merged), eventBlockDescending);
+
+            beginResetModel();
+            fList = merged;
+            endResetModel();
+        }
+    }
+
+    void EventModel::spillEvents() {
+        QSettings settings;
+        const int limit = settings.value("events/memorylimit", 10000).toInt();
+        if ( limit <= 0 || fList.size() <= limit ) { // 0 means unlimited
+            return;
+        }
+
+        // spill a whole page at once so we don't hit the disk for every new event
+        const int keep = limit - qMin(limit / 2, sSpillPageSize);
+        const EventList page = fList.mid(keep);
+        if ( !fArchive.storePage(page) ) {
+            return; // keep everything in memory rather than lose events
+        }
+
+        beginRemoveRows(QModelIndex(), keep, fList.size() - 1);
+        fList.erase(fList.begin() + keep, fList.end());
+        endRemoveRows();
+    }
+
 }
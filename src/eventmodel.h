@@ -3,9 +3,14 @@
 
 #include <QObject>
 #include <QAbstractListModel>
+#include <QUrl>
+#include <QSet>
+#include <QFutureWatcher>
+#include <QAtomicInt>
 #include "contractinfo.h"
 #include "contractmodel.h"
 #include "filtermodel.h"
+#include "eventarchive.h"
 
 namespace Etherwall {
 
@@ -14,10 +19,13 @@ namespace Etherwall {
         Q_OBJECT
     public:
         EventModel(const ContractModel& contractModel, const FilterModel& filterModel);
+        virtual ~EventModel();
 
         QHash<int, QByteArray> roleNames() const;
         int rowCount(const QModelIndex & parent __attribute__ ((unused))) const;
         QVariant data(const QModelIndex & index, int role) const;
+        bool canFetchMore(const QModelIndex & parent) const;
+        void fetchMore(const QModelIndex & parent);
         Q_INVOKABLE const QString getName(int index) const;
         Q_INVOKABLE const QString getContract(int index) const;
         Q_INVOKABLE const QString getAddress(int index) const;
@@ -28,14 +36,27 @@ namespace Etherwall {
         Q_INVOKABLE const QString getTopics(int index) const;
         Q_INVOKABLE const QVariantList getArgModel(int index) const;
         Q_INVOKABLE const QString getParamValue(int index) const;
+        Q_INVOKABLE bool exportEvents(const QUrl& fileName); // false if it can't start, eventsExported when done
     public slots:
-        void onNewEvent(const EventInfo& info, bool isNew);
+        void onNewEvents(const EventList& list, bool isNew);
         void onBeforeLoadLogs();
+    private slots:
+        void onExportDecoded();
     signals:
         void receivedEvent(const QString& contract, const QString& signature);
+        void eventsExported(const QString& fileName, bool success);
     private:
         const ContractModel& fContractModel;
         EventList fList;
+        EventArchive fArchive;
+        QSet<QString> fSeen; // every row and archived event, back-filled logs can overlap what a filter delivered
+        EventList fExportList; // decoded off the GUI thread, copies so the model can change meanwhile
+        QString fExportFileName;
+        QFutureWatcher<void> fExportWatcher;
+        QAtomicInt fExportFailures; // events the pool couldn't decode, logged once the export is written
+
+        void insertEvents(const EventList& list);
+        void spillEvents();
     };
 
 }
@@ -4,7 +4,7 @@
 
 namespace Etherwall {
 
-    FilterModel::FilterModel(NodeIPC& ipc) : QAbstractListModel(0), fIpc(ipc), fList()
+    FilterModel::FilterModel(NodeIPC& ipc, RecordStore& store) : QAbstractListModel(0), fIpc(ipc), fStore(store), fList()
     {
     }
 
@@ -71,10 +71,7 @@ namespace Etherwall {
 
         const QJsonArray topicArray = doc.array();
         const FilterInfo info(name, address, contract, topicArray, active);
-        QSettings settings;
-        settings.beginGroup("filters" + fIpc.getNetworkPostfix());
-        settings.setValue(info.getHandle(), info.toJsonString());
-        settings.endGroup();
+        fStore.put("filters" + fIpc.getNetworkPostfix(), info.getHandle(), info.toJsonString().toUtf8());
 
         // check if it's an update
         for ( int i = 0; i < fList.length(); i++ ) {
@@ -103,10 +100,7 @@ namespace Etherwall {
         fList[index].setActive(active);
         const FilterInfo info = fList.at(index);
 
-        QSettings settings;
-        settings.beginGroup("filters" + fIpc.getNetworkPostfix());
-        settings.setValue(info.getHandle(), info.toJsonString());
-        settings.endGroup();
+        fStore.put("filters" + fIpc.getNetworkPostfix(), info.getHandle(), info.toJsonString().toUtf8());
 
         update(index);
     }
@@ -118,10 +112,7 @@ namespace Etherwall {
 
         const FilterInfo info = fList.at(index);
         registerFilters();
-        QSettings settings;
-        settings.beginGroup("filters" + fIpc.getNetworkPostfix());
-        settings.remove(info.getHandle());
-        settings.endGroup();
+        fStore.remove("filters" + fIpc.getNetworkPostfix(), info.getHandle());
 
         beginRemoveRows(QModelIndex(), index, index);
         fList.removeAt(index);
@@ -196,15 +187,12 @@ namespace Etherwall {
     }
 
     void FilterModel::reload() {
-        QSettings settings;
-        settings.beginGroup("filters" + fIpc.getNetworkPostfix());
-
-        const QStringList list = settings.allKeys();
+        const QString table = "filters" + fIpc.getNetworkPostfix();
+        const QStringList list = fStore.keys(table);
 
         foreach ( const QString addr, list ) {
             QJsonParseError parseError;
-            const QString val = settings.value(addr).toString();
-            const QJsonDocument jsonDoc = QJsonDocument::fromJson(val.toUtf8(), &parseError);
+            const QJsonDocument jsonDoc = QJsonDocument::fromJson(fStore.value(table, addr), &parseError);
 
             if ( parseError.error != QJsonParseError::NoError ) {
                 EtherLog::logMsg("Error parsing stored filter: " + parseError.errorString(), LS_Error);
@@ -214,8 +202,6 @@ namespace Etherwall {
             }
         }
 
-        settings.endGroup();
-
         registerFilters();
         loadLogs();
     }
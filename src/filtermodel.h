@@ -5,6 +5,7 @@
 #include <QAbstractListModel>
 #include "contractinfo.h"
 #include "nodeipc.h"
+#include "recordstore.h"
 
 namespace Etherwall {
 
@@ -12,7 +13,7 @@ namespace Etherwall {
     {
         Q_OBJECT
     public:
-        FilterModel(NodeIPC& ipc);
+        FilterModel(NodeIPC& ipc, RecordStore& store);
 
         QHash<int, QByteArray> roleNames() const;
         int rowCount(const QModelIndex & parent = QModelIndex()) const;
@@ -35,6 +36,7 @@ namespace Etherwall {
         void update(int index);
         void registerFilters() const;
         NodeIPC& fIpc;
+        RecordStore& fStore;
         EventFilters fList;
 
         int getActiveCount() const;
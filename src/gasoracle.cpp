@@ -0,0 +1,179 @@
+#include "gasoracle.h"
+#include "helpers.h"
+#include <QJsonValue>
+
+namespace Etherwall {
+
+    static const int sBucketCount = 16384; // power of two for the fenwick descent, ~1638 gwei top
+    static const quint64 sBucketWei = 100000000; // 0.1 gwei
+    static const int sWindowBlocks = 50;
+    static const int sSlowPercentile = 30;
+    static const int sStandardPercentile = 60;
+    static const int sFastPercentile = 90;
+
+    GasOracle::BlockPrices::BlockPrices() : fNumber(0), fBuckets()
+    {
+    }
+
+    GasOracle::BlockPrices::BlockPrices(quint64 number) : fNumber(number), fBuckets()
+    {
+    }
+
+    GasOracle::GasOracle(NodeIPC& ipc) : QObject(0), fTree(sBucketCount + 1, 0), fWindow(), fSamples(0),
+        fSlow(), fStandard(), fFast(), fStale(false)
+    {
+        connect(&ipc, &NodeIPC::connectToServerDone, this, &GasOracle::onConnectToServerDone);
+    }
+
+    const QString GasOracle::getSlow() const {
+        return fSlow;
+    }
+
+    const QString GasOracle::getStandard() const {
+        return fStandard;
+    }
+
+    const QString GasOracle::getFast() const {
+        return fFast;
+    }
+
+    int GasOracle::getSamples() const {
+        return fSamples;
+    }
+
+    bool GasOracle::isEmpty() const {
+        return fSamples == 0;
+    }
+
+    bool GasOracle::getStale() const {
+        return fStale;
+    }
+
+    void GasOracle::saveState(QDataStream& stream) const {
+        stream << fSlow << fStandard << fFast;
+    }
+
+    void GasOracle::loadState(QDataStream& stream) {
+        QString slow, standard, fast;
+        stream >> slow >> standard >> fast;
+        if ( stream.status() != QDataStream::Ok || fSamples > 0 || standard.isEmpty() ) {
+            return;
+        }
+
+        fSlow = slow;
+        fStandard = standard;
+        fFast = fast;
+        fStale = true;
+        emit pricesChanged();
+    }
+
+    void GasOracle::onNewBlock(const DecodedBlock& block) {
+        const quint64 blockNum = block.fNumber;
+        if ( blockNum == 0 ) {
+            return; // pending block
+        }
+
+        if ( !block.fFull ) {
+            return; // hashes only (light ingest), keep sampling the blocks we got in full
+        }
+
+        // reorg or re-delivery, replace what we had from this height up
+        while ( !fWindow.isEmpty() && fWindow.last().fNumber >= blockNum ) {
+            removeLast();
+        }
+
+        BlockPrices prices(blockNum);
+        foreach ( const DecodedTransaction& tx, block.fTransactions ) {
+            const quint64 wei = tx.fGasPrice;
+            if ( wei == 0 ) {
+                continue; // miner's own txs, would skew the low end
+            }
+
+            const int bucket = (int)qMin<quint64>(wei / sBucketWei, sBucketCount - 1);
+            prices.fBuckets.append(bucket);
+            addBucket(bucket, 1);
+        }
+
+        fSamples += prices.fBuckets.size();
+        fWindow.append(prices);
+
+        while ( fWindow.size() > sWindowBlocks ) {
+            removeFirst();
+        }
+
+        update();
+    }
+
+    void GasOracle::onConnectToServerDone() {
+        // might be a different chain now
+        while ( !fWindow.isEmpty() ) {
+            removeLast();
+        }
+
+        update();
+    }
+
+    void GasOracle::addBucket(int bucket, int delta) {
+        for ( int i = bucket + 1; i <= sBucketCount; i += i & -i ) {
+            fTree[i] += delta;
+        }
+    }
+
+    // smallest bucket with cumulative count >= rank
+    int GasOracle::findBucket(int rank) const {
+        int pos = 0;
+        for ( int step = sBucketCount; step > 0; step >>= 1 ) {
+            if ( pos + step <= sBucketCount && fTree.at(pos + step) < rank ) {
+                pos += step;
+                rank -= fTree.at(pos);
+            }
+        }
+
+        return pos; // 1-based pos + 1 -> 0-based bucket
+    }
+
+    const QString GasOracle::percentile(int percent) const {
+        if ( fSamples == 0 ) {
+            return QString();
+        }
+
+        const int rank = qMax(1, (fSamples * percent + 99) / 100);
+        const quint64 wei = (quint64)(findBucket(rank) + 1) * sBucketWei; // top of bucket so we're never under
+        return Helpers::weiStrToEtherStr(QString::number(wei));
+    }
+
+    void GasOracle::removeFirst() {
+        const BlockPrices prices = fWindow.takeFirst();
+        foreach ( int bucket, prices.fBuckets ) {
+            addBucket(bucket, -1);
+        }
+        fSamples -= prices.fBuckets.size();
+    }
+
+    void GasOracle::removeLast() {
+        const BlockPrices prices = fWindow.takeLast();
+        foreach ( int bucket, prices.fBuckets ) {
+            addBucket(bucket, -1);
+        }
+        fSamples -= prices.fBuckets.size();
+    }
+
+    void GasOracle::update() {
+        if ( fSamples == 0 && fStale ) {
+            return; // keep the snapshot prices until real ones come in
+        }
+
+        const QString slow = percentile(sSlowPercentile);
+        const QString standard = percentile(sStandardPercentile);
+        const QString fast = percentile(sFastPercentile);
+
+        if ( fStale || slow != fSlow || standard != fStandard || fast != fFast ) {
+            fSlow = slow;
+            fStandard = standard;
+            fFast = fast;
+            fStale = false;
+            emit pricesChanged();
+        }
+    }
+
+}
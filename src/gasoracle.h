@@ -0,0 +1,69 @@
+#ifndef GASORACLE_H
+#define GASORACLE_H
+
+#include <QObject>
+#include <QList>
+#include <QVector>
+#include <QJsonObject>
+#include <QDataStream>
+#include "nodeipc.h"
+#include "decodedblock.h"
+
+namespace Etherwall {
+
+    // gas price suggestions from the transactions of the last few blocks. Prices are kept in
+    // 0.1 gwei buckets of a fenwick tree so adding/removing a block and finding a percentile
+    // are both logarithmic, no sorting on every block
+    class GasOracle : public QObject
+    {
+        Q_OBJECT
+        Q_PROPERTY(QString slow READ getSlow NOTIFY pricesChanged FINAL)
+        Q_PROPERTY(QString standard READ getStandard NOTIFY pricesChanged FINAL)
+        Q_PROPERTY(QString fast READ getFast NOTIFY pricesChanged FINAL)
+        Q_PROPERTY(int samples READ getSamples NOTIFY pricesChanged FINAL)
+        Q_PROPERTY(bool stale READ getStale NOTIFY pricesChanged FINAL)
+    public:
+        GasOracle(NodeIPC& ipc);
+
+        const QString getSlow() const;
+        const QString getStandard() const;
+        const QString getFast() const;
+        int getSamples() const;
+        bool isEmpty() const;
+        bool getStale() const;
+        void saveState(QDataStream& stream) const;
+        void loadState(QDataStream& stream); // last run's prices, shown until we've seen blocks
+    public slots:
+        void onNewBlock(const DecodedBlock& block);
+    signals:
+        void pricesChanged() const;
+    private slots:
+        void onConnectToServerDone();
+    private:
+        class BlockPrices {
+        public:
+            BlockPrices();
+            BlockPrices(quint64 number);
+            quint64 fNumber;
+            QVector<int> fBuckets;
+        };
+
+        QVector<int> fTree; // 1-based fenwick tree of bucket counts
+        QList<BlockPrices> fWindow;
+        int fSamples;
+        QString fSlow;
+        QString fStandard;
+        QString fFast;
+        bool fStale;
+
+        void addBucket(int bucket, int delta);
+        int findBucket(int rank) const;
+        const QString percentile(int percent) const;
+        void removeFirst();
+        void removeLast();
+        void update();
+    };
+
+}
+
+#endif // GASORACLE_H
@@ -0,0 +1,198 @@
+#include "ipcsession.h"
+#include <QDateTime>
+#include <QMutexLocker>
+
+namespace Etherwall {
+
+    IpcSession::EventFilter::EventFilter() : fAddresses(), fTopics()
+    {
+    }
+
+    IpcSession::EventFilter::EventFilter(const QJsonArray& addresses, const QJsonArray& topics) : fAddresses(addresses), fTopics(topics)
+    {
+    }
+
+    IpcSession::IpcSession(QObject* parent) : QObject(parent), fFilters(), fPolledAt(), fPolledBlock(), fBackfills(), fReplay(), fCatchUpBlock(0), fResuming(false), fMutex()
+    {
+    }
+
+    void IpcSession::rememberFilter(const QString& internalID, const QJsonArray& addresses, const QJsonArray& topics) {
+        QMutexLocker locker(&fMutex);
+
+        fFilters[internalID] = EventFilter(addresses, topics);
+        fPolledAt[internalID] = QDateTime::currentMSecsSinceEpoch();
+    }
+
+    void IpcSession::forgetFilter(const QString& internalID) {
+        QMutexLocker locker(&fMutex);
+
+        fFilters.remove(internalID);
+        fPolledAt.remove(internalID);
+        fPolledBlock.remove(internalID);
+        fBackfills.remove(internalID);
+    }
+
+    const QStringList IpcSession::filterIDs() const {
+        QMutexLocker locker(&fMutex);
+
+        return fFilters.keys();
+    }
+
+    const QStringList IpcSession::filterAddresses(const QString& internalID) const {
+        QMutexLocker locker(&fMutex);
+
+        QStringList result;
+        foreach ( const QJsonValue& address, fFilters.value(internalID).fAddresses ) {
+            result.append(address.toString());
+        }
+
+        return result;
+    }
+
+    const QJsonArray IpcSession::filterTopics(const QString& internalID) const {
+        QMutexLocker locker(&fMutex);
+
+        return fFilters.value(internalID).fTopics;
+    }
+
+    void IpcSession::filterPolled(const QString& internalID, quint64 block) {
+        QMutexLocker locker(&fMutex);
+
+        fPolledAt[internalID] = QDateTime::currentMSecsSinceEpoch();
+        fPolledBlock[internalID] = block;
+    }
+
+    qint64 IpcSession::filterIdle(const QString& internalID) const {
+        QMutexLocker locker(&fMutex);
+
+        if ( !fPolledAt.contains(internalID) ) {
+            return 0;
+        }
+
+        return QDateTime::currentMSecsSinceEpoch() - fPolledAt.value(internalID);
+    }
+
+    quint64 IpcSession::filterLastBlock(const QString& internalID, quint64 fallback) const {
+        QMutexLocker locker(&fMutex);
+
+        return fPolledBlock.value(internalID, fallback);
+    }
+
+    void IpcSession::backfill(const QString& internalID, quint64 fromBlock) {
+        QMutexLocker locker(&fMutex);
+
+        if ( !fBackfills.contains(internalID) || fromBlock < fBackfills.value(internalID) ) {
+            fBackfills[internalID] = fromBlock;
+        }
+    }
+
+    const QMap<QString, quint64> IpcSession::takeBackfills() {
+        QMutexLocker locker(&fMutex);
+
+        const QMap<QString, quint64> result = fBackfills;
+        fBackfills.clear();
+
+        return result;
+    }
+
+    bool IpcSession::suspend(const NodeRequest& active, const QQueue<NodeRequest>& queue, quint64 lastBlock) {
+        QMutexLocker locker(&fMutex);
+
+        bool kept = true;
+        if ( !fResuming ) { // dropped again while reconnecting keeps the first batch
+            fReplay.clear();
+            fCatchUpBlock = lastBlock;
+        }
+        fResuming = true;
+
+        if ( active.burden() != None ) {
+            if ( isIdempotent(active) ) {
+                if ( !isBackfill(active) ) {
+                    fReplay.append(active);
+                }
+            } else {
+                kept = (active.getType() == NoRequest);
+            }
+        }
+
+        foreach ( const NodeRequest& request, queue ) {
+            if ( isIdempotent(request) && !isBackfill(request) ) {
+                fReplay.append(request);
+            }
+        }
+
+        return kept;
+    }
+
+    bool IpcSession::isResuming() const {
+        QMutexLocker locker(&fMutex);
+
+        return fResuming;
+    }
+
+    const QList<NodeRequest> IpcSession::resume() {
+        QMutexLocker locker(&fMutex);
+
+        fResuming = false;
+        const QList<NodeRequest> result = fReplay;
+        fReplay.clear();
+
+        return result;
+    }
+
+    quint64 IpcSession::takeCatchUpBlock() {
+        QMutexLocker locker(&fMutex);
+
+        const quint64 result = fCatchUpBlock;
+        fCatchUpBlock = 0;
+
+        return result;
+    }
+
+    void IpcSession::catchUpFrom(quint64 block) {
+        QMutexLocker locker(&fMutex);
+
+        if ( fCatchUpBlock == 0 || block < fCatchUpBlock ) {
+            fCatchUpBlock = block;
+        }
+    }
+
+    void IpcSession::reset() {
+        QMutexLocker locker(&fMutex);
+
+        fFilters.clear();
+        fPolledAt.clear();
+        fPolledBlock.clear();
+        fBackfills.clear();
+        fReplay.clear();
+        fCatchUpBlock = 0;
+        fResuming = false;
+    }
+
+    // the reinstalled filter back-fills from its last poll again, replaying this too would deliver the logs twice
+    bool IpcSession::isBackfill(const NodeRequest& request) {
+        return request.getType() == GetLogs && request.getUserData().value("backfill").toBool();
+    }
+
+    bool IpcSession::isIdempotent(const NodeRequest& request) {
+        switch ( request.getType() ) {
+            case GetBlockNumber:
+            case GetAccountRefs:
+            case GetBalance:
+            case GetTransactionCount:
+            case GetPeerCount:
+            case Call:
+            case GetGasPrice:
+            case EstimateGas:
+            case GetTransactionByHash:
+            case GetBlock:
+            case GetClientVersion:
+            case GetNetVersion:
+            case GetSyncing:
+            case GetLogs:
+            case GetTransactionReceipt: return true;
+            default: return false; // sends and unlocks must not repeat, filters get reinstalled instead
+        }
+    }
+
+}
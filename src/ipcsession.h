@@ -0,0 +1,72 @@
+#ifndef IPCSESSION_H
+#define IPCSESSION_H
+
+#include <QObject>
+#include <QMap>
+#include <QHash>
+#include <QList>
+#include <QQueue>
+#include <QStringList>
+#include <QJsonArray>
+#include <QMutex>
+#include "nodeipc.h"
+
+namespace Etherwall {
+
+    // what the IPC client needs to pick up where it left off after losing the node: event filter
+    // definitions (their node side ids die with the connection), requests that are safe to send
+    // again and the last block we saw so the gap can be fetched instead of reloading everything
+    // Reply handlers run on the thread pool while the timer and socket slots run on the GUI thread,
+    // so every call takes the lock
+    class IpcSession : public QObject
+    {
+        Q_OBJECT
+    public:
+        IpcSession(QObject* parent);
+
+        void rememberFilter(const QString& internalID, const QJsonArray& addresses, const QJsonArray& topics);
+        void forgetFilter(const QString& internalID);
+        const QStringList filterIDs() const;
+        const QStringList filterAddresses(const QString& internalID) const;
+        const QJsonArray filterTopics(const QString& internalID) const;
+
+        // polling bookkeeping, empty internalID is the block filter
+        void filterPolled(const QString& internalID, quint64 block);
+        qint64 filterIdle(const QString& internalID) const; // ms since installed or last polled
+        quint64 filterLastBlock(const QString& internalID, quint64 fallback) const;
+        void backfill(const QString& internalID, quint64 fromBlock); // logs to fetch once the current block is known
+        const QMap<QString, quint64> takeBackfills();
+
+        // returns false if the active request couldn't be kept (e.g. a send), caller should report it
+        bool suspend(const NodeRequest& active, const QQueue<NodeRequest>& queue, quint64 lastBlock);
+        bool isResuming() const;
+        const QList<NodeRequest> resume(); // requests to replay
+        quint64 takeCatchUpBlock(); // last block seen before the drop, 0 if none pending
+        void catchUpFrom(quint64 block); // fetch blocks after this on the next block number
+        void reset(); // gave up, next connection starts cold
+
+        static bool isIdempotent(const NodeRequest& request);
+    private:
+        static bool isBackfill(const NodeRequest& request);
+
+        class EventFilter {
+        public:
+            EventFilter();
+            EventFilter(const QJsonArray& addresses, const QJsonArray& topics);
+            QJsonArray fAddresses;
+            QJsonArray fTopics;
+        };
+
+        QMap<QString, EventFilter> fFilters; // internalID -> definition
+        QHash<QString, qint64> fPolledAt; // wall clock, a suspended machine still ages the node's filters
+        QHash<QString, quint64> fPolledBlock;
+        QMap<QString, quint64> fBackfills; // internalID -> first block to fetch
+        QList<NodeRequest> fReplay;
+        quint64 fCatchUpBlock;
+        bool fResuming;
+        mutable QMutex fMutex;
+    };
+
+}
+
+#endif // IPCSESSION_H
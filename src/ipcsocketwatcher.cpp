@@ -0,0 +1,63 @@
+#include "ipcsocketwatcher.h"
+#include <QFileInfo>
+#include <QDir>
+
+namespace Etherwall {
+
+    static const int sMinInterval = 250; // ms
+    static const int sMaxInterval = 4000;
+
+    IpcSocketWatcher::IpcSocketWatcher(QObject* parent) : QObject(parent), fWatcher(), fTimer(), fClock(), fPath(), fInterval(sMinInterval), fSeen(false)
+    {
+        fTimer.setSingleShot(true);
+        connect(&fTimer, &QTimer::timeout, this, &IpcSocketWatcher::onTimer);
+        connect(&fWatcher, &QFileSystemWatcher::directoryChanged, this, &IpcSocketWatcher::onDirectoryChanged);
+    }
+
+    void IpcSocketWatcher::watch(const QString& path) {
+        stop();
+
+        fPath = path;
+        fSeen = exists();
+        fInterval = sMinInterval;
+        fClock.start();
+
+        const QString dir = QFileInfo(path).absolutePath();
+        if ( QDir(dir).exists() ) { // named pipes on windows don't live anywhere we can watch
+            fWatcher.addPath(dir);
+        }
+
+        fTimer.start(fInterval);
+    }
+
+    void IpcSocketWatcher::stop() {
+        fTimer.stop();
+        if ( !fWatcher.directories().isEmpty() ) {
+            fWatcher.removePaths(fWatcher.directories());
+        }
+    }
+
+    qint64 IpcSocketWatcher::elapsed() const {
+        return fClock.isValid() ? fClock.elapsed() : 0;
+    }
+
+    bool IpcSocketWatcher::exists() const {
+        return QFileInfo::exists(fPath);
+    }
+
+    void IpcSocketWatcher::onDirectoryChanged() {
+        if ( fSeen || !exists() ) {
+            return;
+        }
+
+        fSeen = true;
+        emit retry(); // right away, no need to wait for the timer
+    }
+
+    void IpcSocketWatcher::onTimer() {
+        fInterval = qMin(fInterval * 2, sMaxInterval);
+        fTimer.start(fInterval);
+        emit retry();
+    }
+
+}
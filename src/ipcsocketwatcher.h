@@ -0,0 +1,40 @@
+#ifndef IPCSOCKETWATCHER_H
+#define IPCSOCKETWATCHER_H
+
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QElapsedTimer>
+
+namespace Etherwall {
+
+    // tells the IPC client when to try connecting again. Watches the socket's directory so we know
+    // the moment geth creates it, with an exponential backoff timer as fallback (windows pipes,
+    // missing datadir, socket there but not listening yet)
+    class IpcSocketWatcher : public QObject
+    {
+        Q_OBJECT
+    public:
+        IpcSocketWatcher(QObject* parent);
+
+        void watch(const QString& path); // restarts the clock and the backoff
+        void stop();
+        qint64 elapsed() const; // ms since watch()
+        bool exists() const;
+    signals:
+        void retry() const;
+    private slots:
+        void onDirectoryChanged();
+        void onTimer();
+    private:
+        QFileSystemWatcher fWatcher;
+        QTimer fTimer;
+        QElapsedTimer fClock;
+        QString fPath;
+        int fInterval;
+        bool fSeen;
+    };
+
+}
+
+#endif // IPCSOCKETWATCHER_H
@@ -0,0 +1,182 @@
+#include "lightingest.h"
+#include "erc20codec.h"
+#include "helpers.h"
+#include "etherlog.h"
+#include <QSettings>
+#include <QJsonArray>
+
+namespace Etherwall {
+
+    static const QString sEtherToken = "0x0000000000000000000000000000000000000000"; // balance checker's ETH
+
+    LightIngest::LightIngest(NodeIPC& ipc, CallCache& callCache, const AccountModel& accountModel) :
+        QObject(0), fIpc(ipc), fCallCache(callCache), fAccountModel(accountModel), fBalances(), fNonces(),
+        fCountBlock(0), fFetchedBlock(0), fEnabled(false), fFetchNext(false)
+    {
+        const QSettings settings;
+        fEnabled = settings.value("geth/lightingest", false).toBool();
+
+        connect(&ipc, &NodeIPC::newBlock, this, &LightIngest::onNewBlock);
+        connect(&ipc, &NodeIPC::connectToServerDone, this, &LightIngest::onConnectToServerDone);
+        connect(&ipc, &NodeIPC::accountSentTransChanged, this, &LightIngest::onAccountSentTransChanged);
+        connect(&callCache, &CallCache::callDone, this, &LightIngest::onCallDone);
+        connect(&callCache, &CallCache::callFailed, this, &LightIngest::onCallFailed);
+    }
+
+    bool LightIngest::getEnabled() const {
+        return fEnabled;
+    }
+
+    void LightIngest::setEnabled(bool enabled) {
+        if ( enabled == fEnabled || (enabled && !getAvailable()) ) {
+            return;
+        }
+
+        fEnabled = enabled;
+        QSettings settings;
+        settings.setValue("geth/lightingest", enabled); // the node asks for hash only blocks while set
+        fBalances.clear();
+        fNonces.clear();
+        fCountBlock = 0;
+
+        emit enabledChanged(enabled);
+    }
+
+    bool LightIngest::getAvailable() const {
+        const QSettings settings;
+        return !settings.value("tokens/balancechecker" + fIpc.getNetworkPostfix()).toString().isEmpty();
+    }
+
+    void LightIngest::onNewBlock(const QJsonObject& block) {
+        const quint64 blockNum = Helpers::toQUInt64(block.value("number"));
+        const QJsonArray transactions = block.value("transactions").toArray();
+        if ( !fEnabled || blockNum == 0 || transactions.isEmpty() || transactions.first().isObject() ) {
+            return; // full block, nothing for us to decide
+        }
+
+        const AccountList& accounts = fAccountModel.getAccounts();
+        if ( accounts.isEmpty() ) {
+            return;
+        }
+
+        // outgoing token transfers and 0 value calls don't have to move the ETH balance, the nonce always does
+        fCountBlock = blockNum;
+        for ( int i = 0; i < accounts.size(); i++ ) {
+            fIpc.getTransactionCount(accounts.at(i).hash(), i);
+        }
+
+        if ( fFetchNext ) { // last check might have seen this block's state already
+            fFetchNext = false;
+            return fetchBlock(blockNum);
+        }
+
+        const QSettings settings;
+        const QString checker = settings.value("tokens/balancechecker" + fIpc.getNetworkPostfix()).toString();
+
+        if ( checker.isEmpty() ) { // removed since the node was asked for this one, blocks come in full from now on
+            return fetchBlock(blockNum);
+        }
+
+        QStringList users;
+        foreach ( const AccountInfo& info, accounts ) {
+            users.append(info.hash());
+        }
+
+        try {
+            QVariantMap userData;
+            userData["type"] = "lightIngestCall";
+            userData["block"] = blockNum;
+            userData["users"] = users;
+
+            const QString encoded = ERC20::Codec<ERC20::Balances>::encode(users, QStringList(sEtherToken));
+            Ethereum::Tx txBalances(QString(), checker, QString(), 0, QString(), QString(), encoded);
+            fCallCache.call(txBalances, -1, userData);
+        } catch ( QString err ) {
+            EtherLog::logMsg("Error encoding light ingest balances call: " + err, LS_Error);
+            fetchBlock(blockNum);
+        }
+    }
+
+    void LightIngest::onCallDone(const QString& result, int index, const QVariantMap& userData) {
+        Q_UNUSED(index);
+        if ( userData.value("type").toString() != "lightIngestCall" ) {
+            return;
+        }
+
+        const quint64 blockNum = userData.value("block").toULongLong();
+        const QStringList users = userData.value("users").toStringList();
+        QStringList balances;
+        try {
+            balances = ERC20::Codec<ERC20::Balances>::decode(result);
+        } catch ( QString err ) {
+            EtherLog::logMsg("Error parsing light ingest balances: " + err, LS_Error);
+            return fetchBlock(blockNum);
+        }
+
+        if ( balances.size() != users.size() ) {
+            EtherLog::logMsg("Invalid response size for light ingest balances", LS_Error);
+            return fetchBlock(blockNum);
+        }
+
+        bool changed = false;
+        for ( int i = 0; i < users.size(); i++ ) {
+            const QString address = users.at(i).toLower();
+            // first sight is a change too, we don't know what happened before
+            if ( fBalances.value(address) != balances.at(i) ) {
+                fBalances[address] = balances.at(i);
+                changed = true;
+            }
+        }
+
+        if ( changed ) {
+            fetchBlock(blockNum);
+            fFetchNext = true; // the call runs on latest which can already be the next block
+        }
+    }
+
+    void LightIngest::onCallFailed(const QString& error, int index, const QVariantMap& userData) {
+        Q_UNUSED(index);
+        if ( userData.value("type").toString() != "lightIngestCall" ) {
+            return;
+        }
+
+        EtherLog::logMsg("Light ingest balances call failed: " + error, LS_Warning);
+        fetchBlock(userData.value("block").toULongLong()); // can't tell, better download it
+    }
+
+    void LightIngest::onAccountSentTransChanged(int index, quint64 count) {
+        const AccountList& accounts = fAccountModel.getAccounts();
+        if ( !fEnabled || fCountBlock == 0 || index < 0 || index >= accounts.size() ) {
+            return;
+        }
+
+        // counts asked for elsewhere are just as current, any move means we sent something
+        const QString address = accounts.at(index).hash().toLower();
+        const bool changed = fNonces.contains(address) && fNonces.value(address) != count;
+        fNonces[address] = count;
+
+        if ( changed ) {
+            fetchBlock(fCountBlock);
+            fFetchNext = true; // same as balances, latest can already be the next block
+        }
+    }
+
+    void LightIngest::onConnectToServerDone() {
+        fBalances.clear();
+        fNonces.clear();
+        fCountBlock = 0;
+        fFetchedBlock = 0;
+        fFetchNext = false;
+        emit availableChanged(); // checker is per network
+    }
+
+    void LightIngest::fetchBlock(quint64 blockNum) {
+        if ( blockNum == fFetchedBlock ) {
+            return; // balance and nonce can both point at the same one
+        }
+
+        fFetchedBlock = blockNum;
+        fIpc.getBlockByNumber(blockNum); // bodies included, models pick it up from newBlock
+    }
+
+}
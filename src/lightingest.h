@@ -0,0 +1,54 @@
+#ifndef LIGHTINGEST_H
+#define LIGHTINGEST_H
+
+#include <QObject>
+#include <QHash>
+#include <QVariantMap>
+#include <QJsonObject>
+#include "nodeipc.h"
+#include "callcache.h"
+#include "accountmodel.h"
+
+namespace Etherwall {
+
+    // light block processing, the node only hands us block headers with transaction hashes and
+    // we check all our account balances in one balance checker call plus each account's nonce.
+    // Full bodies are requested only when some balance or nonce moved, busy mainnet blocks are
+    // otherwise never downloaded or decoded
+    class LightIngest : public QObject
+    {
+        Q_OBJECT
+        Q_PROPERTY(bool enabled READ getEnabled WRITE setEnabled NOTIFY enabledChanged FINAL)
+        Q_PROPERTY(bool available READ getAvailable NOTIFY availableChanged FINAL)
+    public:
+        LightIngest(NodeIPC& ipc, CallCache& callCache, const AccountModel& accountModel);
+
+        bool getEnabled() const;
+        void setEnabled(bool enabled);
+        bool getAvailable() const; // needs a balance checker on the current network
+    signals:
+        void enabledChanged(bool enabled) const;
+        void availableChanged() const;
+    private slots:
+        void onNewBlock(const QJsonObject& block);
+        void onCallDone(const QString& result, int index, const QVariantMap& userData);
+        void onCallFailed(const QString& error, int index, const QVariantMap& userData);
+        void onAccountSentTransChanged(int index, quint64 count);
+        void onConnectToServerDone();
+    private:
+        NodeIPC& fIpc;
+        CallCache& fCallCache;
+        const AccountModel& fAccountModel;
+        QHash<QString, QString> fBalances; // address -> wei as of the last check
+        QHash<QString, quint64> fNonces; // address -> sent count as of the last check
+        quint64 fCountBlock; // block the last nonce checks were queued for
+        quint64 fFetchedBlock;
+        bool fEnabled;
+        bool fFetchNext;
+
+        void fetchBlock(quint64 blockNum);
+    };
+
+}
+
+#endif // LIGHTINGEST_H
@@ -27,16 +27,28 @@
 #include <QIcon>
 #include <QPixmap>
 #include <QFile>
+#include <QStandardPaths>
 #include <QDebug>
 #include "etherlogapp.h"
 #include "gethlogapp.h"
 #include "settings.h"
+#include "settingscache.h"
+#include "recordstore.h"
 #include "clipboard.h"
 #include "initializer.h"
+#include "startupsequence.h"
 #include "accountmodel.h"
 #include "accountproxymodel.h"
+#include "callcache.h"
+#include "gasoracle.h"
 #include "transactionmodel.h"
 #include "contractmodel.h"
+#include "batchsendmodel.h"
+#include "pendingtracker.h"
+#include "pendingfeed.h"
+#include "lightingest.h"
+#include "blockdecoder.h"
+#include "statesnapshot.h"
 #include "eventmodel.h"
 #include "currencymodel.h"
 #include "filtermodel.h"
@@ -90,25 +102,47 @@ int main(int argc, char *argv[])
     Trezor::TrezorDevice trezor;
     DeviceManager deviceManager(app);
     NodeWS ipc(gethLog);
-    CurrencyModel currencyModel;
-    AccountModel accountModel(ipc, currencyModel, trezor);
-    TransactionModel transactionModel(ipc, accountModel);
-    ContractModel contractModel(ipc, accountModel);
-    FilterModel filterModel(ipc);
+    RecordStore recordStore(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/store");
+    recordStore.migrateSettings(); // before the settings cache loads what's left
+    SettingsCache settingsCache;
+    CurrencyModel currencyModel(settingsCache);
+    CallCache callCache(ipc);
+    AccountModel accountModel(ipc, currencyModel, trezor, settingsCache, recordStore);
+    BlockDecoder blockDecoder(ipc, accountModel);
+    GasOracle gasOracle(ipc);
+    TransactionModel transactionModel(ipc, callCache, gasOracle, accountModel, recordStore);
+    ContractModel contractModel(ipc, callCache, accountModel, recordStore);
+    BatchSendModel batchSendModel(transactionModel, accountModel, contractModel);
+    PendingTracker pendingTracker(ipc, transactionModel, accountModel, gasOracle);
+    PendingFeed pendingFeed(ipc, accountModel);
+    LightIngest lightIngest(ipc, callCache, accountModel);
+    FilterModel filterModel(ipc, recordStore);
     EventModel eventModel(contractModel, filterModel);
 
     TokenModel tokenModel(&contractModel);
+    StartupSequence startup(gethPath, initializer, ipc, accountModel);
+
+    startup.begin("snapshot");
+    StateSnapshot stateSnapshot(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/state.snapshot",
+                                accountModel, transactionModel, gasOracle, currencyModel);
+    startup.end("snapshot");
 
     // main connections
-    QObject::connect(&initializer, &Initializer::initDone, &ipc, &NodeWS::start);
+    QObject::connect(&startup, &StartupSequence::startNode, &ipc, &NodeWS::start);
     QObject::connect(&accountModel, &AccountModel::accountsReady, &deviceManager, &DeviceManager::startProbe);
     QObject::connect(&contractModel, &ContractModel::tokenBalanceDone, &accountModel, &AccountModel::onTokenBalanceDone);
+    QObject::connect(&contractModel, &ContractModel::balanceCheckerChanged, &lightIngest, &LightIngest::availableChanged);
     QObject::connect(&transactionModel, &TransactionModel::confirmedTransaction, &contractModel, &ContractModel::onConfirmedTransaction);
     QObject::connect(&accountModel, &AccountModel::accountsReady, &filterModel, &FilterModel::reload);
     QObject::connect(&tokenModel, &TokenModel::selectedTokenContract, &contractModel, &ContractModel::onSelectedTokenContract);
     QObject::connect(&deviceManager, &DeviceManager::deviceInserted, &trezor, &Trezor::TrezorDevice::onDeviceInserted);
     QObject::connect(&deviceManager, &DeviceManager::deviceRemoved, &trezor, &Trezor::TrezorDevice::onDeviceRemoved);
     QObject::connect(&trezor, &Trezor::TrezorDevice::transactionReady, &transactionModel, &TransactionModel::onRawTransaction);
+    QObject::connect(&pendingFeed, &PendingFeed::incomingTransaction, &transactionModel, &TransactionModel::onPendingIncoming);
+    QObject::connect(&blockDecoder, &BlockDecoder::blockDecoded, &accountModel, &AccountModel::newBlock);
+    QObject::connect(&blockDecoder, &BlockDecoder::blockDecoded, &transactionModel, &TransactionModel::newBlock);
+    QObject::connect(&blockDecoder, &BlockDecoder::blockDecoded, &gasOracle, &GasOracle::onNewBlock);
+    QObject::connect(&blockDecoder, &BlockDecoder::blockDecoded, &pendingTracker, &PendingTracker::onNewBlock);
 
     // for QML only
     QmlHelpers qmlHelpers;
@@ -117,11 +151,18 @@ int main(int argc, char *argv[])
 
     engine.rootContext()->setContextProperty("settings", &settings);
     engine.rootContext()->setContextProperty("initializer", &initializer);
+    engine.rootContext()->setContextProperty("startup", &startup);
     engine.rootContext()->setContextProperty("ipc", &ipc);
+    engine.rootContext()->setContextProperty("callCache", &callCache);
+    engine.rootContext()->setContextProperty("gasOracle", &gasOracle);
     engine.rootContext()->setContextProperty("trezor", &trezor);
     engine.rootContext()->setContextProperty("accountModel", &accountModel);
     engine.rootContext()->setContextProperty("transactionModel", &transactionModel);
     engine.rootContext()->setContextProperty("contractModel", &contractModel);
+    engine.rootContext()->setContextProperty("batchSendModel", &batchSendModel);
+    engine.rootContext()->setContextProperty("pendingTracker", &pendingTracker);
+    engine.rootContext()->setContextProperty("pendingFeed", &pendingFeed);
+    engine.rootContext()->setContextProperty("lightIngest", &lightIngest);
     engine.rootContext()->setContextProperty("filterModel", &filterModel);
     engine.rootContext()->setContextProperty("eventModel", &eventModel);
     engine.rootContext()->setContextProperty("currencyModel", &currencyModel);
@@ -132,10 +173,12 @@ int main(int argc, char *argv[])
 
     engine.rootContext()->setContextProperty("tokenModel", &tokenModel);
 
+    startup.begin("ui");
     engine.load(QUrl(QStringLiteral("qrc:///main.qml")));
+    startup.end("ui");
 
     if ( settings.contains("program/v2firstrun") ) {
-        initializer.start();
+        startup.start();
     }
 
     return app.exec();
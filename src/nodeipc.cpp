@@ -20,8 +20,14 @@
 
 #include "nodeipc.h"
 #include "helpers.h"
+#include "ipcsocketwatcher.h"
+#include "ipcsession.h"
 #include <QSettings>
 #include <QFileInfo>
+#include <QDir>
+#include <QStandardPaths>
+#include <QApplication>
+#include <QRegExp>
 #include <QtConcurrent/QtConcurrent>
 
 // windblows hacks coz windblows sucks
@@ -85,6 +91,23 @@ namespace Etherwall {
 
 // *************************** NodeIPC **************************** //
 
+    static const qint64 sConnectTimeout = 40000; // ms, give up connecting after this
+
+    static const quint64 sMaxCatchUpBlocks = 128; // more than this missed and the models reload instead
+    static const qint64 sFilterExpiry = 240000; // ms, geth drops filters not polled for 5 minutes
+
+    // ties a send's reply back to the nonce that was reserved for it
+    static const QVariantMap sendUserData(const QString& from, quint64 nonce) {
+        QVariantMap result;
+        result["from"] = from.toLower();
+        result["nonce"] = nonce;
+        return result;
+    }
+
+    static const QVariantMap sendUserData(const Ethereum::Tx& tx) {
+        return sendUserData(tx.fromStr(), Helpers::clearHexPrefix(tx.nonceHex()).toULongLong(0, 16));
+    }
+
 #ifdef Q_OS_WIN32
     const QString NodeIPC::sDefaultDataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/Ethereum";
 #else
@@ -97,11 +120,12 @@ namespace Etherwall {
     const QString NodeIPC::sDefaultGethArgs = "--syncmode=fast --cache 512";
 
     NodeIPC::NodeIPC(GethLog& gethLog) :
-        fPath(), fBlockFilterID(), fClosingApp(false), fPeerCount(0), fActiveRequest(None),
+        fPath(), fGethPath(), fBlockFilterID(), fClosingApp(false), fPeerCount(0), fActiveRequest(None),
         fGeth(), fStarting(0), fGethLog(gethLog),
         fSyncing(false), fCurrentBlock(0), fHighestBlock(0), fStartingBlock(0),
         fConnectAttempts(0), fKillTime(), fExternal(false), fEventFilterIDs(),
-        fReceivedMsg()
+        fReceivedMsg(), fReadBuffer(), fError(), fCode(0), fNetVersion(0), fBlockNumber(0), fClientVersion(),
+        fErrorHandlers(), fSocketWatcher(new IpcSocketWatcher(this)), fSession(new IpcSession(this))
     {
         connect(&fSocket, (void (QLocalSocket::*)(QLocalSocket::LocalSocketError))&QLocalSocket::error, this, &NodeIPC::onSocketError);
         connect(&fSocket, &QLocalSocket::readyRead, this, &NodeIPC::onSocketReadyRead);
@@ -111,6 +135,7 @@ namespace Etherwall {
         connect(this, &NodeIPC::ipcReady, this, &NodeIPC::onIpcReady);
         connect(this, &NodeIPC::requestDone, this, &NodeIPC::onRequestDone);
         connect(this, &NodeIPC::stopTimer, this, &NodeIPC::onStopTimer);
+        connect(fSocketWatcher, &IpcSocketWatcher::retry, this, &NodeIPC::waitConnect);
 
         const QSettings settings;
 
@@ -121,12 +146,18 @@ namespace Etherwall {
         fGeth.kill();
     }
 
-    void NodeIPC::start(const QString &version, const QString &endpoint, const QString &warning)
+    void NodeIPC::registerIpcErrorHandler(int code, IpcErrorHandler handler)
+    {
+        fErrorHandlers[code] = handler;
+    }
+
+    void NodeIPC::start(const QString& gethPath, const QString &version, const QString &endpoint, const QString &warning)
     {
         Q_UNUSED(version); // TODO
         Q_UNUSED(endpoint);
         Q_UNUSED(warning);
 
+        fGethPath = gethPath;
         buildGethArgs(); // has to run first
 
         fConnectAttempts = 0;
@@ -143,7 +174,7 @@ namespace Etherwall {
     void NodeIPC::init() {
         QSettings settings;       
         QStringList args = buildGethArgs(); // has to run first
-        const QString progStr = settings.value("geth/path", defaultGethPath()).toString();
+        const QString progStr = settings.value("geth/path", fGethPath.isEmpty() ? defaultGethPath() : fGethPath).toString();
 
         QFileInfo info(progStr);
         if ( !info.exists() || !info.isExecutable() ) {
@@ -169,6 +200,7 @@ namespace Etherwall {
         // didn't connect to geth in time, run it now
         if ( fStarting == 1 ) {
             fSocket.abort(); // ensure we don't get connected called later
+            fSocketWatcher->stop(); // geth starting calls connectToServer again
             return init();
         }
 
@@ -176,7 +208,8 @@ namespace Etherwall {
             return connectionTimeout();
         }
 
-        if ( ++fConnectAttempts < 20 ) {
+        if ( fSocketWatcher->elapsed() < sConnectTimeout ) {
+            fConnectAttempts++;
             if ( fSocket.state() == QLocalSocket::ConnectingState ) {
                 fSocket.abort();
             }
@@ -190,12 +223,10 @@ namespace Etherwall {
     void NodeIPC::connectToServer() {
         fActiveRequest = NodeRequest(Full);
         emit busyChanged(getBusy());
-        if ( fSocket.state() != QLocalSocket::UnconnectedState ) {
-            return QTimer::singleShot(2000, this, SLOT(waitConnect()));
-        }
 
-        fSocket.connectToServer(fPath);
+        // retries come from the watcher, as soon as the socket shows up or on backoff
         if ( fConnectAttempts == 0 ) {
+            fSocketWatcher->watch(fPath);
             if ( fStarting == 1 ) {
                 EtherLog::logMsg("Checking to see if there is an already running geth...");
             } else {
@@ -203,10 +234,47 @@ namespace Etherwall {
             }
         }
 
-        QTimer::singleShot(2000, this, SLOT(waitConnect()));
+        if ( fSocket.state() != QLocalSocket::UnconnectedState ) {
+            return;
+        }
+
+#ifndef Q_OS_WIN32
+        if ( !fSocketWatcher->exists() ) {
+            if ( fStarting == 1 ) { // nothing running, don't wait to find out
+                return waitConnect();
+            }
+            return; // geth hasn't created it yet
+        }
+#endif
+
+        fSocket.connectToServer(fPath);
     }
 
     void NodeIPC::connectedToServer() {
+        fSocketWatcher->stop();
+        EtherLog::logMsg("IPC connected after " + QString::number(fSocketWatcher->elapsed()) + "ms, " + QString::number(fConnectAttempts + 1) + " attempt(s)", LS_Info);
+
+        if ( fSession->isResuming() ) { // pick up where we left off, no full init
+            fStarting = 3;
+            done();
+
+            newBlockFilter();
+            foreach ( const QString& internalID, fSession->filterIDs() ) {
+                reinstallEventFilter(internalID);
+            }
+            foreach ( const NodeRequest& request, fSession->resume() ) {
+                if ( !queueRequest(request) ) {
+                    return bail();
+                }
+            }
+            getBlockNumber(); // catches up on blocks we missed and back-fills the filters' logs
+
+            fTimer.start();
+            emit startingChanged(fStarting);
+            emit connectionStateChanged();
+            return;
+        }
+
         done();
 
         if ( fStarting == 1 ) {
@@ -221,6 +289,8 @@ namespace Etherwall {
     }
 
     void NodeIPC::connectionTimeout() {
+        fSocketWatcher->stop();
+        fSession->reset();
         fSocket.abort();
         fStarting = -1;
         emit startingChanged(fStarting);
@@ -252,6 +322,14 @@ namespace Etherwall {
         return fCode;
     }
 
+    const QString& NodeIPC::ipcPath() const {
+        return fPath;
+    }
+
+    const QString& NodeIPC::clientVersion() const {
+        return fClientVersion;
+    }
+
 
     void NodeIPC::setInterval(int interval) {
         QSettings settings;
@@ -335,19 +413,50 @@ namespace Etherwall {
         return killGeth();
     }
 
-    void NodeIPC::loadLogs(const QStringList& addresses, const QJsonArray& topics, quint64 fromBlock, const QString& internalID) {
+    void NodeIPC::loadLogs(const QStringList& addresses, const QJsonArray& topics, quint64 fromBlock, const QString& internalID, quint64 toBlock) {
         if ( addresses.length() > 0 ) {
-            getLogs(addresses, topics, fromBlock, internalID);
+            getLogs(addresses, topics, fromBlock, internalID, toBlock);
         }
     }
 
+    // the new filter only reports logs after it's installed, the ones after the last poll up to
+    // that point get fetched once the next block number tells us where it was put back
+    void NodeIPC::reinstallEventFilter(const QString& internalID) {
+        const QStringList addresses = fSession->filterAddresses(internalID);
+        const QJsonArray topics = fSession->filterTopics(internalID);
+        fEventFilterIDs.remove(internalID);
+        newEventFilter(QJsonArray::fromStringList(addresses), topics, internalID);
+        fSession->backfill(internalID, fSession->filterLastBlock(internalID, fBlockNumber) + 1);
+    }
+
     void NodeIPC::disconnectedFromServer() {
         if ( fClosingApp ) { // expected
             return;
         }
 
         fError = fSocket.errorString();
-        bail();
+        if ( fStarting != 3 ) { // never got going, nothing to resume
+            return bail();
+        }
+
+        // geth restarted or the socket hiccuped, keep what's safe to ask again and reconnect
+        EtherLog::logMsg("IPC connection lost: " + fError + ", reconnecting", LS_Warning);
+        if ( !fSession->suspend(fActiveRequest, fRequestQueue, fBlockNumber) ) {
+            setError("Connection to geth lost during " + fActiveRequest.getMethod() + ", please try again");
+            emit error();
+        }
+
+        emit stopTimer();
+        fRequestQueue.clear();
+        fActiveRequest = NodeRequest(None);
+        fReadBuffer.clear();
+        fBlockFilterID.clear();
+        fEventFilterIDs.clear(); // node side ids are gone, definitions are kept in the session
+        fStarting = 2;
+        fConnectAttempts = 0;
+        emit connectionStateChanged();
+
+        connectToServer();
     }
 
     void NodeIPC::getAccounts() {
@@ -393,11 +502,18 @@ namespace Etherwall {
         return true;
     }
 
-    bool NodeIPC::getTransactionCount(const QString& hash, int index) {
+    bool NodeIPC::getTransactionCount(const QString& hash, int index, bool pending) {
         QJsonArray params;
         params.append(hash);
-        params.append(QString("latest"));
-        if ( !queueRequest(NodeRequest(GetTransactionCount, "eth_getTransactionCount", params, index)) ) {
+        params.append(pending ? QString("pending") : QString("latest"));
+        NodeRequest request(GetTransactionCount, "eth_getTransactionCount", params, index);
+        if ( pending ) {
+            QVariantMap userData;
+            userData["pending"] = true;
+            request.setUserData(userData);
+        }
+
+        if ( !queueRequest(request) ) {
             bail();
             return false;
         }
@@ -430,7 +546,11 @@ namespace Etherwall {
         quint64 count = bv.toUlong();
         const int index = fActiveRequest.getIndex();
 
-        emit accountSentTransChanged(index, count);
+        if ( fActiveRequest.getUserData().value("pending").toBool() ) {
+            emit pendingTransactionCountDone(fActiveRequest.getParams().at(0).toString(), count);
+        } else {
+            emit accountSentTransChanged(index, count);
+        }
         done();
     }
 
@@ -465,8 +585,30 @@ namespace Etherwall {
              return bail();
         }
 
+        const quint64 lastSeen = fSession->takeCatchUpBlock();
         fBlockNumber = result;
         emit getBlockNumberDone(result);
+
+        if ( lastSeen > 0 && result > lastSeen ) { // back after a reconnect or expired filter, fetch what we missed
+            if ( result - lastSeen > sMaxCatchUpBlocks ) {
+                EtherLog::logMsg("Missed " + QString::number(result - lastSeen) + " blocks while disconnected, reloading", LS_Info);
+                emit reloadNeeded();
+            } else {
+                for ( quint64 num = lastSeen + 1; num <= result; num++ ) {
+                    getBlockByNumber(num);
+                }
+            }
+        }
+
+        // reinstalled filters were put in before this request, so they report what comes after result
+        QMapIterator<QString, quint64> backfills(fSession->takeBackfills());
+        while ( backfills.hasNext() ) {
+            backfills.next();
+            if ( backfills.value() <= result ) {
+                loadLogs(fSession->filterAddresses(backfills.key()), fSession->filterTopics(backfills.key()), backfills.value(), backfills.key(), result);
+            }
+        }
+
         done();
     }
 
@@ -523,11 +665,14 @@ namespace Etherwall {
         if ( tx.hasData() ) {
             p["data"] = tx.dataHex();
         }
+        p["nonce"] = tx.nonceHex(); // the one reserved for us, not geth's own count
 
         params.append(p);
         params.append(password);
 
-        if ( !queueRequest(NodeRequest(SendTransaction, "personal_signAndSendTransaction", params)) ) {
+        NodeRequest request(SendTransaction, "personal_signAndSendTransaction", params);
+        request.setUserData(sendUserData(tx));
+        if ( !queueRequest(request) ) {
             return bail(true); // softbail
         }
     }
@@ -562,22 +707,29 @@ namespace Etherwall {
 
         params.append(p);
 
-        if ( !queueRequest(NodeRequest(SignTransaction, "eth_signTransaction", params)) ) {
+        NodeRequest request(SignTransaction, "eth_signTransaction", params);
+        request.setUserData(sendUserData(tx));
+        if ( !queueRequest(request) ) {
             return bail(true); // softbail
         }
     }
 
     void NodeIPC::sendRawTransaction(const Ethereum::Tx &tx)
     {
-        sendRawTransaction(Helpers::hexPrefix(tx.encodeRLP(true)));
+        const QVariantMap userData = sendUserData(tx);
+        sendRawTransaction(Helpers::hexPrefix(tx.encodeRLP(true)), userData.value("from").toString(), userData.value("nonce").toULongLong());
     }
 
-    void NodeIPC::sendRawTransaction(const QString &rlp)
+    void NodeIPC::sendRawTransaction(const QString &rlp, const QString& from, quint64 nonce)
     {
         QJsonArray params;
         params.append(rlp);
 
-        if ( !queueRequest(NodeRequest(SendRawTransaction, "eth_sendRawTransaction", params)) ) {
+        NodeRequest request(SendRawTransaction, "eth_sendRawTransaction", params);
+        if ( !from.isEmpty() ) {
+            request.setUserData(sendUserData(from, nonce));
+        }
+        if ( !queueRequest(request) ) {
             return bail(true); // softbail
         }
     }
@@ -617,32 +769,46 @@ namespace Etherwall {
     }
 
     void NodeIPC::handleSendTransaction() {
+        const QVariantMap userData = fActiveRequest.getUserData();
         QJsonValue jv;
         if ( !readReply(jv) ) {
+            failSend(fActiveRequest);
             return bail(true); // softbail
         }
 
         const QString hash = jv.toString();
-        emit sendTransactionDone(hash);
+        emit sendTransactionDone(hash, userData.value("from").toString(), userData.value("nonce").toULongLong());
         done();
     }
 
     void NodeIPC::handleSignTransaction()
     {
+        const QVariantMap userData = fActiveRequest.getUserData();
         QJsonValue jv;
         if ( !readReply(jv) ) {
+            failSend(fActiveRequest);
             return bail(true); // softbail
         }
 
-        const QString hash = jv.toObject().value("raw").toString();
-        emit signTransactionDone(hash);
+        const QString raw = jv.toObject().value("raw").toString();
+        emit signTransactionDone(raw, userData.value("from").toString(), userData.value("nonce").toULongLong());
         done();
     }
 
+    void NodeIPC::failSend(const NodeRequest& request) {
+        const QVariantMap userData = request.getUserData();
+        if ( !userData.contains("nonce") ) {
+            return; // not one of ours, e.g. a raw send from elsewhere
+        }
+
+        emit sendTransactionFailed(userData.value("from").toString(), userData.value("nonce").toULongLong(), fError);
+    }
+
     void NodeIPC::handleCall()
     {
         QJsonValue jv;
         if ( !readReply(jv) ) {
+            emit callFailed(fError, fActiveRequest.getIndex(), fActiveRequest.getUserData());
             return bail(true); // softbail
         }
 
@@ -762,7 +928,7 @@ namespace Etherwall {
     }
 
     void NodeIPC::estimateGas(const QString& from, const QString& to, const QString& valStr,
-                                   const QString& gas, const QString& gasPrice, const QString& data) {
+                                   const QString& gas, const QString& gasPrice, const QString& data, const QVariantMap& userData) {
         const QString valHex = Helpers::toHexWeiStr(valStr);
         QJsonArray params;
         QJsonObject p;
@@ -784,7 +950,9 @@ namespace Etherwall {
         }
 
         params.append(p);
-        if ( !queueRequest(NodeRequest(Full, EstimateGas, "eth_estimateGas", params)) ) {
+        NodeRequest request(Full, EstimateGas, "eth_estimateGas", params);
+        request.setUserData(userData);
+        if ( !queueRequest(request) ) {
             return bail();
         }
     }
@@ -792,12 +960,13 @@ namespace Etherwall {
     void NodeIPC::handleEstimateGas() {
         QJsonValue jv;
         if ( !readReply(jv) ) {
+            emit estimateGasFailed(fActiveRequest.getUserData());
             return bail(true); // probably gas too low
         }
 
         const QString price = Helpers::toDecStr(jv);
 
-        emit estimateGasDone(price);
+        emit estimateGasDone(price, fActiveRequest.getUserData());
 
         done();
     }
@@ -822,6 +991,7 @@ namespace Etherwall {
         }
         params.append(o);
 
+        fSession->rememberFilter(internalID, addresses, topics);
         NodeRequest request(NewEventFilter, "eth_newFilter", params);
         QVariantMap userData;
         userData["internalID"] = internalID;
@@ -843,6 +1013,7 @@ namespace Etherwall {
             setError("Block filter ID invalid");
             return bail();
         }
+        fSession->filterPolled(QString(), fBlockNumber);
 
         done();
     }
@@ -868,6 +1039,16 @@ namespace Etherwall {
         getPeerCount();
         getSyncing();
 
+        // not polled for too long (suspended machine, long interval), geth has most likely dropped
+        // our filters so put them back right away instead of waiting for "filter not found".
+        // The old ids aren't uninstalled, that would fail hard if they're gone and geth expires them anyway
+        if ( !fBlockFilterID.isEmpty() && !fSyncing && fSession->filterIdle(QString()) > sFilterExpiry ) {
+            EtherLog::logMsg("Block filter idle too long, reinstalling", LS_Info);
+            fBlockFilterID.clear();
+            newBlockFilter();
+            fSession->catchUpFrom(fBlockNumber);
+        }
+
         if ( !fBlockFilterID.isEmpty() && !fSyncing ) {
             getFilterChanges(fBlockFilterID, QString());
         } else {
@@ -875,10 +1056,21 @@ namespace Etherwall {
         }
 
         if ( !fEventFilterIDs.isEmpty() ) {
-            QMapIterator<QString, QString> i(fEventFilterIDs);
+            bool reinstalled = false;
+            QMapIterator<QString, QString> i(fEventFilterIDs); // iterates a copy, safe to reinstall
             while ( i.hasNext() ) {
                 i.next();
-                getFilterChanges(i.value(), i.key());
+                if ( fSession->filterIdle(i.key()) > sFilterExpiry ) {
+                    EtherLog::logMsg("Event filter " + i.key() + " idle too long, reinstalling", LS_Info);
+                    reinstallEventFilter(i.key());
+                    reinstalled = true;
+                } else {
+                    getFilterChanges(i.value(), i.key());
+                }
+            }
+
+            if ( reinstalled ) {
+                getBlockNumber(); // back-fills up to where the filters were put back
             }
         }
     }
@@ -935,9 +1127,32 @@ namespace Etherwall {
     }
 
     void NodeIPC::handleGetFilterChanges() {
+        const QString internalFilterID = fActiveRequest.getUserData().value("internalFilterID").toString();
         QJsonValue jv;
         if ( !readReply(jv) ) {
-            return bail();
+            if ( fActiveRequest.getType() != GetFilterChanges || !fError.contains("filter not found", Qt::CaseInsensitive) ) {
+                return bail();
+            }
+
+            // geth expired it, put it back and back-fill the gap
+            const QString filterID = fActiveRequest.getParams().at(0).toString();
+            if ( internalFilterID.isEmpty() && filterID == fBlockFilterID ) {
+                EtherLog::logMsg("Block filter expired on node, reinstalling", LS_Warning);
+                fBlockFilterID.clear();
+                newBlockFilter();
+                fSession->catchUpFrom(fBlockNumber);
+                getBlockNumber();
+            } else if ( !internalFilterID.isEmpty() && filterID == fEventFilterIDs.value(internalFilterID) ) {
+                EtherLog::logMsg("Event filter " + internalFilterID + " expired on node, reinstalling", LS_Warning);
+                reinstallEventFilter(internalFilterID);
+                getBlockNumber();
+            } // else a poll queued before we already reinstalled it
+
+            return done();
+        }
+
+        if ( fActiveRequest.getType() == GetFilterChanges ) {
+            fSession->filterPolled(internalFilterID, fBlockNumber);
         }
 
         QJsonArray ar = jv.toArray();
@@ -945,7 +1160,6 @@ namespace Etherwall {
         foreach( const QJsonValue v, ar ) {
             if ( v.isObject() ) { // event filter result
                 const QJsonObject logs = v.toObject();
-                const QString internalFilterID = fActiveRequest.getUserData().value("internalFilterID").toString();
                 emit newEvent(logs, fActiveRequest.getType() == GetFilterChanges, internalFilterID); // get logs is not "new"
             } else { // block filter (we don't use transaction filters yet)
                 const QString hash = v.toString("bogus");
@@ -980,10 +1194,13 @@ namespace Etherwall {
         }
     }
 
-    void NodeIPC::getLogs(const QStringList& addresses, const QJsonArray& topics, quint64 fromBlock, const QString& internalID) {
+    void NodeIPC::getLogs(const QStringList& addresses, const QJsonArray& topics, quint64 fromBlock, const QString& internalID, quint64 toBlock) {
         QJsonArray params;
         QJsonObject o;
         o["fromBlock"] = fromBlock == 0 ? "latest" : Helpers::toHexStr(fromBlock);
+        if ( toBlock > 0 ) {
+            o["toBlock"] = Helpers::toHexStr(toBlock);
+        }
         o["address"] = QJsonArray::fromStringList(addresses);
         if ( topics.size() > 0 && !topics.at(0).toString().isEmpty() ) {
             o["topics"] = topics;
@@ -994,6 +1211,7 @@ namespace Etherwall {
         NodeRequest request(NonVisual, GetLogs, "eth_getLogs", params);
         QVariantMap userData;
         userData["internalFilterID"] = internalID;
+        userData["backfill"] = (toBlock > 0); // redone from the filter's last poll if the connection drops
         request.setUserData(userData);
         if ( !queueRequest(request) ) {
             return bail();
@@ -1014,6 +1232,7 @@ namespace Etherwall {
         if ( fActiveRequest.getUserData().contains("internalID") ) {
             const QString internalID = fActiveRequest.getUserData().value("internalID").toString();
             fEventFilterIDs.remove(internalID);
+            fSession->forgetFilter(internalID);
             // qDebug() << "removed event filter: " << internalID << "\n";
         }
 
@@ -1052,7 +1271,11 @@ namespace Etherwall {
         QJsonArray params;
         params.append(hash);
 
-        if ( !queueRequest(NodeRequest(NonVisual, GetTransactionByHash, "eth_getTransactionByHash", params)) ) {
+        NodeRequest request(NonVisual, GetTransactionByHash, "eth_getTransactionByHash", params);
+        QVariantMap userData;
+        userData["hash"] = hash; // a null reply doesn't say which one it was
+        request.setUserData(userData);
+        if ( !queueRequest(request) ) {
             return bail();
         }
     }
@@ -1064,13 +1287,19 @@ namespace Etherwall {
         }
 
         emit newTransaction(jv.toObject());
+        emit transactionLookupDone(fActiveRequest.getUserData().value("hash").toString(), jv.toObject());
         done();
     }
 
     void NodeIPC::getBlockByHash(const QString& hash) {
         QJsonArray params;
         params.append(hash);
-        params.append(true); // get transaction bodies
+        // light ingest only wants hashes, bodies are asked for by number when our balances change.
+        // Without a balance checker it would have to ask for every body anyway
+        const QSettings settings;
+        const bool light = settings.value("geth/lightingest", false).toBool() &&
+                           !settings.value("tokens/balancechecker" + getNetworkPostfix()).toString().isEmpty();
+        params.append(!light);
 
         if ( !queueRequest(NodeRequest(NonVisual ,GetBlock, "eth_getBlockByHash", params)) ) {
             return bail();
@@ -1095,6 +1324,7 @@ namespace Etherwall {
 
         const QJsonObject block = jv.toObject();
         const quint64 num = Helpers::toQUInt64(block.value("number"));
+        fBlockNumber = qMax(fBlockNumber, num); // what filters and reconnects catch up from
         emit getBlockNumberDone(num);
         emit newBlock(block);
         done();
@@ -1226,6 +1456,9 @@ namespace Etherwall {
         QJsonValue jv;
         if ( !readReply(jv) ) {
             // special case, we def. need to remove all subrequests, but not stop timer
+            foreach ( const NodeRequest& request, fRequestQueue ) {
+                failSend(request); // e.g. the sign behind it, dropped sends won't reply
+            }
             fRequestQueue.clear();
             return bail(true);
         }
@@ -1365,6 +1598,7 @@ namespace Etherwall {
 
         if ( result.isUndefined() || result.isNull() ) {
             if ( obj.contains("error") ) {
+                fCode = 0;
                 if ( obj["error"].toObject().contains("message") ) {
                     fError = obj["error"].toObject()["message"].toString();
                 }
@@ -1373,6 +1607,13 @@ namespace Etherwall {
                     fCode = obj["error"].toObject()["code"].toInt();
                 }
 
+                if ( fErrorHandlers.contains(fCode) && fErrorHandlers.value(fCode)(fCode, fError, fActiveRequest.getType(), result) ) {
+                    QVariantMap userData = fActiveRequest.getUserData();
+                    userData["errorHandled"] = true; // a stand-in, not the node's answer
+                    fActiveRequest.setUserData(userData);
+                    return true; // consumer turned it into a result
+                }
+
                 return false;
             }
 
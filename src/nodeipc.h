@@ -0,0 +1,315 @@
+#ifndef NODEIPC_H
+#define NODEIPC_H
+
+#include <QObject>
+#include <QLocalSocket>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QJsonDocument>
+#include <QVariantMap>
+#include <QStringList>
+#include <QProcess>
+#include <QTimer>
+#include <QTime>
+#include <QQueue>
+#include <QMap>
+#include "types.h"
+#include "gethlog.h"
+#include "etherlog.h"
+#include "ethereum/bigint.h"
+#include "ethereum/tx.h"
+
+namespace Etherwall {
+
+    class IpcSocketWatcher;
+    class IpcSession;
+
+    enum NodeRequestTypes {
+        NoRequest,
+        NewAccount,
+        UnlockAccount,
+        GetBlockNumber,
+        GetAccountRefs,
+        GetBalance,
+        GetTransactionCount,
+        GetPeerCount,
+        SendTransaction,
+        SignTransaction,
+        SendRawTransaction,
+        Call,
+        GetGasPrice,
+        EstimateGas,
+        NewBlockFilter,
+        NewEventFilter,
+        GetFilterChanges,
+        UninstallFilter,
+        GetTransactionByHash,
+        GetBlock,
+        GetClientVersion,
+        GetNetVersion,
+        GetSyncing,
+        GetLogs,
+        GetTransactionReceipt
+    };
+
+    enum NodeRequestBurden {
+        Full,
+        NonVisual,
+        None
+    };
+
+    class NodeRequest
+    {
+    public:
+        NodeRequest(NodeRequestBurden burden, NodeRequestTypes type, const QString method, const QJsonArray params = QJsonArray(), int index = -1);
+        NodeRequest(NodeRequestTypes type, const QString method, const QJsonArray params = QJsonArray(), int index = -1);
+        NodeRequest(NodeRequestBurden burden);
+
+        NodeRequestTypes getType() const;
+        const QString& getMethod() const;
+        const QJsonArray& getParams() const;
+        int getIndex() const;
+        const QVariantMap getUserData() const;
+        void setUserData(const QVariantMap& data);
+        int getCallID() const;
+        NodeRequestBurden burden() const;
+    private:
+        static int sCallID;
+
+        int fCallID;
+        NodeRequestTypes fType;
+        QString fMethod;
+        QJsonArray fParams;
+        int fIndex;
+        NodeRequestBurden fBurden;
+        QVariantMap fUserData;
+    };
+
+    // lets a consumer turn a node error into a result, e.g. a default for a known failing call.
+    // Return true if result was filled in
+    typedef bool (*IpcErrorHandler)(int code, const QString& error, NodeRequestTypes requestType, QJsonValue& result);
+
+    // the app's node client, kept in src/ in place of the ew-node submodule's copy so it can own
+    // the socket watcher, session resume and filter reinstall (see Etherwall.pro)
+    class NodeIPC: public QObject
+    {
+        Q_OBJECT
+        Q_PROPERTY(bool closing READ getClosing NOTIFY closingChanged)
+        Q_PROPERTY(bool busy READ getBusy NOTIFY busyChanged)
+        Q_PROPERTY(bool starting READ getStarting NOTIFY startingChanged)
+        Q_PROPERTY(bool external READ getExternal NOTIFY externalChanged)
+        Q_PROPERTY(bool thinClient READ isThinClient NOTIFY startingChanged)
+        Q_PROPERTY(QString error READ getError NOTIFY error)
+        Q_PROPERTY(int code READ getCode NOTIFY error)
+        Q_PROPERTY(int connectionState READ getConnectionState NOTIFY connectionStateChanged)
+        Q_PROPERTY(quint64 peerCount READ peerCount NOTIFY peerCountChanged)
+        Q_PROPERTY(bool testnet READ getTestnet NOTIFY netVersionChanged)
+        Q_PROPERTY(QString clientVersion READ clientVersion NOTIFY clientVersionChanged)
+        Q_PROPERTY(QString activeRequestName READ getActiveRequestName NOTIFY requestChanged)
+        Q_PROPERTY(bool syncing READ getSyncingVal NOTIFY syncingChanged)
+        Q_PROPERTY(quint64 currentBlock READ getCurrentBlock NOTIFY syncingChanged)
+        Q_PROPERTY(quint64 highestBlock READ getHighestBlock NOTIFY syncingChanged)
+        Q_PROPERTY(quint64 startingBlock READ getStartingBlock NOTIFY syncingChanged)
+    public:
+        static const QString sDefaultDataDir;
+        static const QString sDefaultGethArgs;
+
+        NodeIPC(GethLog& gethLog);
+        virtual ~NodeIPC();
+
+        void registerIpcErrorHandler(int code, IpcErrorHandler handler);
+        bool getBusy() const;
+        bool getExternal() const;
+        bool getStarting() const;
+        bool getClosing() const;
+        const QString& getError() const;
+        int getCode() const;
+        bool getTestnet() const;
+        const QString getNetworkPostfix() const;
+        const QString& clientVersion() const;
+        const QString& ipcPath() const;
+        virtual int getConnectionState() const;
+        virtual bool isThinClient() const;
+        const QString getActiveRequestName() const;
+        quint64 peerCount() const;
+        quint64 blockNumber() const;
+        int network() const;
+        quint64 nonceStart() const;
+        bool getSyncingVal() const;
+        quint64 getCurrentBlock() const;
+        quint64 getHighestBlock() const;
+        quint64 getStartingBlock() const;
+
+        Q_INVOKABLE void setInterval(int interval);
+        Q_INVOKABLE bool closeApp();
+        Q_INVOKABLE void getTransactionReceipt(const QString& hash);
+
+        static const QString defaultIPCPath(const QString& dataDir, bool testnet);
+        static const QString defaultGethPath();
+    public slots:
+        virtual void start(const QString& gethPath, const QString& version, const QString& endpoint, const QString& warning);
+        void getAccounts();
+        bool refreshAccount(const QString& hash, int index);
+        bool getBalance(const QString& hash, int index);
+        bool getTransactionCount(const QString& hash, int index, bool pending = false);
+        void newAccount(const QString& password, int index);
+        void sendTransaction(const Ethereum::Tx& tx, const QString& password);
+        void signTransaction(const Ethereum::Tx& tx, const QString& password);
+        void signTransaction(const Ethereum::Tx& tx);
+        void sendRawTransaction(const Ethereum::Tx& tx);
+        void sendRawTransaction(const QString& rlp, const QString& from = QString(), quint64 nonce = 0);
+        void call(const Ethereum::Tx& tx, int index, const QVariantMap& userData = QVariantMap());
+        void unlockAccount(const QString& hash, const QString& password, int duration, int index);
+        void getGasPrice();
+        void estimateGas(const QString& from, const QString& to, const QString& valStr,
+                         const QString& gas, const QString& gasPrice, const QString& data, const QVariantMap& userData = QVariantMap());
+        void getBlockNumber();
+        void getPeerCount();
+        void newBlockFilter();
+        void newEventFilter(const QJsonArray& addresses, const QJsonArray& topics, const QString& internalID);
+        void getFilterChanges(const QString& filterID, const QString& internalFilterID);
+        void uninstallFilter(const QString& internalID);
+        void getLogs(const QStringList& addresses, const QJsonArray& topics, quint64 fromBlock, const QString& internalID, quint64 toBlock = 0);
+        void loadLogs(const QStringList& addresses, const QJsonArray& topics, quint64 fromBlock, const QString& internalID, quint64 toBlock = 0);
+        void getTransactionByHash(const QString& hash);
+        void getBlockByHash(const QString& hash);
+        void getBlockByNumber(quint64 blockNum);
+        void getClientVersion();
+        void getNetVersion();
+        void getSyncing();
+    protected slots:
+        virtual void connectToServer();
+        void connectedToServer();
+        void disconnectedFromServer();
+        void waitConnect();
+        void onSocketReadyRead();
+        void onSocketError(QLocalSocket::LocalSocketError err);
+        void onTimer();
+        void onIpcReady();
+        void onRequestDone();
+        void onStopTimer();
+    signals:
+        void connectToServerDone() const;
+        void reloadNeeded() const; // too many blocks missed to fetch them one by one, session itself is fine
+        void getAccountsDone(const QStringList& list) const;
+        void newAccountDone(const QString& result, int index) const;
+        void unlockAccountDone(bool result, int index) const;
+        void getBlockNumberDone(quint64 num) const;
+        void sendTransactionDone(const QString& hash, const QString& from, quint64 nonce) const;
+        void sendTransactionFailed(const QString& from, quint64 nonce, const QString& error) const;
+        void signTransactionDone(const QString& raw, const QString& from, quint64 nonce) const;
+        void callDone(const QString& result, int index, const QVariantMap& userData) const;
+        void callFailed(const QString& error, int index, const QVariantMap& userData) const;
+        void getGasPriceDone(const QString& price) const;
+        void estimateGasDone(const QString& price, const QVariantMap& userData) const;
+        void estimateGasFailed(const QVariantMap& userData) const;
+        void getTransactionReceiptDone(const QJsonObject& receipt) const;
+        void accountBalanceChanged(int index, const QString& balanceStr) const;
+        void accountSentTransChanged(int index, quint64 count) const;
+        void pendingTransactionCountDone(const QString& hash, quint64 count) const;
+        void newTransaction(const QJsonObject& info) const;
+        void transactionLookupDone(const QString& hash, const QJsonObject& info) const; // info empty if unknown to the node
+        void newBlock(const QJsonObject& block) const;
+        void newEvent(const QJsonObject& event, bool isNew, const QString& internalFilterID) const;
+
+        void peerCountChanged(quint64 num) const;
+        void busyChanged(bool busy) const;
+        void startingChanged(int starting) const;
+        void externalChanged(bool external) const;
+        void closingChanged(bool closing) const;
+        void connectionStateChanged() const;
+        void syncingChanged(bool syncing) const;
+        void clientVersionChanged(const QString& ver) const;
+        void netVersionChanged(int ver) const;
+        void requestChanged() const;
+        void requestDone() const;
+        void ipcReady() const;
+        void stopTimer() const;
+        void error() const;
+    protected:
+        QString fPath;
+        QString fGethPath;
+        QString fBlockFilterID;
+        bool fClosingApp;
+        quint64 fPeerCount;
+        NodeRequest fActiveRequest;
+        QProcess fGeth;
+        int fStarting;
+        GethLog& fGethLog;
+        bool fSyncing;
+        quint64 fCurrentBlock;
+        quint64 fHighestBlock;
+        quint64 fStartingBlock;
+        int fConnectAttempts;
+        QTime fKillTime;
+        bool fExternal;
+        QMap<QString, QString> fEventFilterIDs; // internalID -> node filter ID
+        QString fReceivedMsg;
+        QString fReadBuffer;
+        QString fError;
+        int fCode;
+        int fNetVersion;
+        quint64 fBlockNumber;
+        QString fClientVersion;
+        QLocalSocket fSocket;
+        QTimer fTimer;
+        QQueue<NodeRequest> fRequestQueue;
+        QMap<int, IpcErrorHandler> fErrorHandlers;
+        IpcSocketWatcher* fSocketWatcher;
+        IpcSession* fSession; // filters and requests to restore after a reconnect
+
+        void init();
+        void finishInit();
+        void connectionTimeout();
+        bool killGeth();
+        const QStringList buildGethArgs();
+        int parseVersionNum() const;
+        void reinstallEventFilter(const QString& internalID);
+
+        void handleNewAccount();
+        void handleUnlockAccount();
+        void handleGetBlockNumber();
+        void handleGetAccounts();
+        void handleAccountBalance();
+        void handleAccountTransactionCount();
+        void handleGetPeerCount();
+        void handleSendTransaction();
+        void handleSignTransaction();
+        void handleCall();
+        void handleGetGasPrice();
+        void handleEstimateGas();
+        void handleNewBlockFilter();
+        void handleNewEventFilter();
+        void handleGetFilterChanges();
+        void handleUninstallFilter();
+        void handleGetTransactionByHash();
+        void handleGetBlock();
+        void handleGetClientVersion();
+        void handleGetNetVersion();
+        void handleGetSyncing();
+        void handleGetTransactionReceipt();
+        void handleRequest();
+
+        void bail(bool soft = false);
+        void failSend(const NodeRequest& request);
+        void setError(const QString& error);
+        void errorOut();
+        void done();
+
+        QJsonObject methodToJSON(const NodeRequest& request);
+        bool queueRequest(const NodeRequest& request);
+        bool writeRequest(const NodeRequest& request);
+        bool readData();
+        bool readReply(QJsonValue& result);
+        bool readVin(BigInt::Vin& result);
+        bool readNumber(quint64& result);
+
+        virtual bool endpointWritable();
+        virtual qint64 endpointWrite(const QByteArray& data);
+        virtual const QByteArray endpointRead();
+    };
+
+}
+
+#endif // NODEIPC_H
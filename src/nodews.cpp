@@ -0,0 +1,143 @@
+#include "nodews.h"
+#include "helpers.h"
+#include "ipcsession.h"
+#include <QSettings>
+#include <QCoreApplication>
+
+namespace Etherwall {
+
+    NodeWS::NodeWS(GethLog& gethLog) : NodeIPC(gethLog),
+        fWebSocket(), fEndpoint(), fReceivedWS(), fThinClient(false)
+    {
+        connect(&fWebSocket, &QWebSocket::connected, this, &NodeWS::onConnectedWS);
+        connect(&fWebSocket, &QWebSocket::disconnected, this, &NodeWS::onDisconnectedWS);
+        connect(&fWebSocket, (void (QWebSocket::*)(QAbstractSocket::SocketError))&QWebSocket::error, this, &NodeWS::onErrorWS);
+        connect(&fWebSocket, &QWebSocket::textMessageReceived, this, &NodeWS::onTextMessageReceivedWS);
+    }
+
+    int NodeWS::getConnectionState() const
+    {
+        if ( !fThinClient ) {
+            return NodeIPC::getConnectionState();
+        }
+
+        return fWebSocket.state() == QAbstractSocket::ConnectedState ? 1 : 0;
+    }
+
+    bool NodeWS::isThinClient() const
+    {
+        return fThinClient;
+    }
+
+    void NodeWS::start(const QString& gethPath, const QString& version, const QString& endpoint, const QString& warning)
+    {
+        const QSettings settings;
+        fThinClient = settings.value("geth/thinclient", false).toBool();
+
+        if ( !fThinClient ) {
+            return NodeIPC::start(gethPath, version, endpoint, warning);
+        }
+
+        if ( !warning.isEmpty() ) {
+            EtherLog::logMsg("Server warning: " + warning, LS_Warning);
+        }
+
+        if ( endpoint.isEmpty() ) {
+            fStarting = -1;
+            emit startingChanged(fStarting);
+            setError("Thin client endpoint unavailable, unable to connect to Etherwall server");
+            return bail();
+        }
+
+        if ( Helpers::parseAppVersion(QCoreApplication::applicationVersion()) < Helpers::parseAppVersion(version) ) {
+            fStarting = -1;
+            emit startingChanged(fStarting);
+            setError("Etherwall " + version + " or newer is required for thin client mode, please update");
+            return bail();
+        }
+
+        EtherLog::logMsg("Etherwall starting in thin client mode", LS_Info);
+        fEndpoint = endpoint;
+        fStarting = 2;
+        fConnectAttempts = 0;
+        emit startingChanged(fStarting);
+        connectToServer();
+    }
+
+    void NodeWS::connectToServer()
+    {
+        if ( !fThinClient ) {
+            return NodeIPC::connectToServer();
+        }
+
+        fActiveRequest = NodeRequest(Full);
+        emit busyChanged(getBusy());
+
+        EtherLog::logMsg("Connecting to thin client endpoint " + fEndpoint);
+        fWebSocket.open(QUrl(fEndpoint));
+    }
+
+    void NodeWS::onConnectedWS()
+    {
+        connectedToServer();
+    }
+
+    void NodeWS::onDisconnectedWS()
+    {
+        if ( fStarting != 3 ) {
+            return; // didn't get going, onErrorWS reports it
+        }
+
+        disconnectedFromServer();
+    }
+
+    void NodeWS::onErrorWS(QAbstractSocket::SocketError error)
+    {
+        fError = fWebSocket.errorString();
+        fCode = error;
+
+        if ( fStarting == 2 ) {
+            fSession->reset(); // a failed reconnect starts cold next time
+            fStarting = -1;
+            emit startingChanged(fStarting);
+            setError("Unable to connect to thin client endpoint: " + fWebSocket.errorString());
+            bail();
+        }
+    }
+
+    void NodeWS::onTextMessageReceivedWS(const QString& message)
+    {
+        fReceivedWS = message.toUtf8();
+        onSocketReadyRead();
+    }
+
+    bool NodeWS::endpointWritable()
+    {
+        if ( !fThinClient ) {
+            return NodeIPC::endpointWritable();
+        }
+
+        return fWebSocket.isValid();
+    }
+
+    qint64 NodeWS::endpointWrite(const QByteArray& data)
+    {
+        if ( !fThinClient ) {
+            return NodeIPC::endpointWrite(data);
+        }
+
+        return fWebSocket.sendTextMessage(QString::fromUtf8(data));
+    }
+
+    const QByteArray NodeWS::endpointRead()
+    {
+        if ( !fThinClient ) {
+            return NodeIPC::endpointRead();
+        }
+
+        const QByteArray result = fReceivedWS;
+        fReceivedWS.clear();
+        return result;
+    }
+
+}
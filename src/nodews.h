@@ -0,0 +1,41 @@
+#ifndef NODEWS_H
+#define NODEWS_H
+
+#include <QWebSocket>
+#include "nodeipc.h"
+
+namespace Etherwall {
+
+    // thin client mode, same requests as NodeIPC but over a websocket to the Etherwall server
+    // instead of the local geth socket. Plain NodeIPC unless geth/thinclient is set
+    class NodeWS : public NodeIPC
+    {
+        Q_OBJECT
+    public:
+        NodeWS(GethLog& gethLog);
+
+        virtual int getConnectionState() const;
+        virtual bool isThinClient() const;
+    public slots:
+        virtual void start(const QString& gethPath, const QString& version, const QString& endpoint, const QString& warning);
+    protected slots:
+        virtual void connectToServer();
+    private slots:
+        void onConnectedWS();
+        void onDisconnectedWS();
+        void onErrorWS(QAbstractSocket::SocketError error);
+        void onTextMessageReceivedWS(const QString& message);
+    protected:
+        virtual bool endpointWritable();
+        virtual qint64 endpointWrite(const QByteArray& data);
+        virtual const QByteArray endpointRead();
+    private:
+        QWebSocket fWebSocket;
+        QString fEndpoint;
+        QByteArray fReceivedWS;
+        bool fThinClient;
+    };
+
+}
+
+#endif // NODEWS_H
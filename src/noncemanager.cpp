@@ -0,0 +1,142 @@
+#include "noncemanager.h"
+#include "etherlog.h"
+
+namespace Etherwall {
+
+    // how long a sent transaction may stay unconfirmed before we assume the node dropped it
+    static const quint64 sDropBlocks = 40;
+
+    NonceManager::Reservation::Reservation() : fNonce(0), fBlockNumber(0), fSubmitted(false)
+    {
+    }
+
+    NonceManager::Reservation::Reservation(quint64 nonce, quint64 blockNumber) : fNonce(nonce), fBlockNumber(blockNumber), fSubmitted(false)
+    {
+    }
+
+    NonceManager::AccountNonces::AccountNonces() : fConfirmed(0), fReserved()
+    {
+    }
+
+    NonceManager::NonceManager() : fAccounts()
+    {
+    }
+
+    quint64 NonceManager::next(const QString& address, quint64 confirmed) const {
+        const AccountNonces nonces = fAccounts.value(address.toLower());
+        quint64 result = qMax(confirmed, nonces.fConfirmed);
+
+        // lowest free nonce, fills gaps left by failed sends first
+        foreach ( const Reservation& r, nonces.fReserved ) {
+            if ( r.fNonce > result ) {
+                break;
+            }
+
+            if ( r.fNonce == result ) {
+                result++;
+            }
+        }
+
+        return result;
+    }
+
+    quint64 NonceManager::reserve(const QString& address, quint64 confirmed, quint64 blockNumber) {
+        const QString key = address.toLower();
+        const quint64 nonce = next(key, confirmed);
+        AccountNonces& nonces = fAccounts[key];
+        nonces.fConfirmed = qMax(confirmed, nonces.fConfirmed);
+
+        int i = 0;
+        while ( i < nonces.fReserved.size() && nonces.fReserved.at(i).fNonce < nonce ) {
+            i++;
+        }
+        nonces.fReserved.insert(i, Reservation(nonce, blockNumber));
+
+        return nonce;
+    }
+
+    void NonceManager::submitted(const QString& address, quint64 nonce) {
+        const QString key = address.toLower();
+        const int i = find(key, nonce);
+        if ( i >= 0 ) {
+            fAccounts[key].fReserved[i].fSubmitted = true;
+        }
+    }
+
+    void NonceManager::rollback(const QString& address, quint64 nonce) {
+        const QString key = address.toLower();
+        const int i = find(key, nonce);
+
+        // the ones after it may still go through, a resend of a submitted one failing changes nothing
+        if ( i >= 0 && !fAccounts.value(key).fReserved.at(i).fSubmitted ) {
+            fAccounts[key].fReserved.removeAt(i);
+        }
+    }
+
+    void NonceManager::confirm(const QString& address, quint64 count) {
+        const QString key = address.toLower();
+        if ( !fAccounts.contains(key) ) {
+            return; // nothing reserved, node count is authoritative
+        }
+
+        AccountNonces& nonces = fAccounts[key];
+        nonces.fConfirmed = qMax(count, nonces.fConfirmed);
+        while ( !nonces.fReserved.isEmpty() && nonces.fReserved.first().fNonce < nonces.fConfirmed ) {
+            nonces.fReserved.removeFirst();
+        }
+    }
+
+    const QStringList NonceManager::expired(quint64 blockNumber) const {
+        QStringList result;
+        QHashIterator<QString, AccountNonces> it(fAccounts);
+        while ( it.hasNext() ) {
+            it.next();
+            foreach ( const Reservation& r, it.value().fReserved ) {
+                if ( r.fSubmitted && r.fBlockNumber + sDropBlocks < blockNumber ) {
+                    result.append(it.key());
+                    break;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    void NonceManager::confirmPending(const QString& address, quint64 pendingCount, quint64 blockNumber) {
+        const QString key = address.toLower();
+        if ( !fAccounts.contains(key) ) {
+            return;
+        }
+
+        // everything below the pending count is in the node's pool or mined, it's taken either way
+        confirm(key, pendingCount);
+
+        // the node doesn't know the next one although we sent it long ago, so it got dropped.
+        // Ones after it may still sit in the node's queue waiting for the gap, leave them be
+        const int i = find(key, pendingCount);
+        if ( i >= 0 ) {
+            const Reservation r = fAccounts.value(key).fReserved.at(i);
+            if ( r.fSubmitted && r.fBlockNumber + sDropBlocks < blockNumber ) {
+                EtherLog::logMsg("Transaction with nonce " + QString::number(r.fNonce) + " from " + key +
+                                 " unknown to the node after " + QString::number(sDropBlocks) + " blocks, assuming dropped", LS_Warning);
+                fAccounts[key].fReserved.removeAt(i);
+            }
+        }
+    }
+
+    void NonceManager::clear() {
+        fAccounts.clear();
+    }
+
+    int NonceManager::find(const QString& key, quint64 nonce) const {
+        const QList<Reservation> reserved = fAccounts.value(key).fReserved;
+        for ( int i = 0; i < reserved.size(); i++ ) {
+            if ( reserved.at(i).fNonce == nonce ) {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+}
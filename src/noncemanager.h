@@ -0,0 +1,52 @@
+#ifndef NONCEMANAGER_H
+#define NONCEMANAGER_H
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QStringList>
+
+namespace Etherwall {
+
+    // locally assigned nonces per account so we can send many transactions per block without
+    // waiting for the node's count to catch up. Reservations are confirmed by the node's count
+    // and by our transactions showing up in blocks, long unconfirmed ones are checked against
+    // the node's pending count and only freed if the node doesn't know them
+    class NonceManager
+    {
+    public:
+        NonceManager();
+
+        quint64 next(const QString& address, quint64 confirmed) const;
+        quint64 reserve(const QString& address, quint64 confirmed, quint64 blockNumber);
+        void submitted(const QString& address, quint64 nonce); // the send reached the node
+        void rollback(const QString& address, quint64 nonce); // the send failed, its nonce is free again
+        void confirm(const QString& address, quint64 count);
+        const QStringList expired(quint64 blockNumber) const; // accounts to check the pending count of
+        void confirmPending(const QString& address, quint64 pendingCount, quint64 blockNumber);
+        void clear();
+    private:
+        class Reservation {
+        public:
+            Reservation();
+            Reservation(quint64 nonce, quint64 blockNumber);
+            quint64 fNonce;
+            quint64 fBlockNumber;
+            bool fSubmitted;
+        };
+
+        class AccountNonces {
+        public:
+            AccountNonces();
+            quint64 fConfirmed;
+            QList<Reservation> fReserved; // sorted by nonce
+        };
+
+        QHash<QString, AccountNonces> fAccounts;
+
+        int find(const QString& key, quint64 nonce) const;
+    };
+
+}
+
+#endif // NONCEMANAGER_H
@@ -0,0 +1,214 @@
+#include "pendingfeed.h"
+#include "erc20codec.h"
+#include "etherlog.h"
+#include <QSettings>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonValue>
+
+namespace Etherwall {
+
+    static const int sFlushInterval = 250; // ms, lookups are batched
+    static const int sMaxBatch = 500;
+    static const int sSubscribeID = 1;
+
+    PendingFeed::PendingFeed(NodeIPC& ipc, const AccountModel& accountModel) :
+        QObject(0), fIpc(ipc), fAccountModel(accountModel), fSocket(), fFlushTimer(), fReadBuffer(),
+        fAddresses(), fHashes(), fEnabled(false), fNextID(sSubscribeID + 1)
+    {
+        const QSettings settings;
+        fEnabled = settings.value("transactions/pendingfeed", false).toBool();
+
+        fFlushTimer.setSingleShot(true);
+        fFlushTimer.setInterval(sFlushInterval);
+
+        connect(&fFlushTimer, &QTimer::timeout, this, &PendingFeed::flushHashes);
+        connect(&fSocket, &QLocalSocket::connected, this, &PendingFeed::onConnected);
+        connect(&fSocket, &QLocalSocket::readyRead, this, &PendingFeed::onReadyRead);
+        connect(&fSocket, (void (QLocalSocket::*)(QLocalSocket::LocalSocketError))&QLocalSocket::error, this, &PendingFeed::onError);
+        connect(&ipc, &NodeIPC::connectToServerDone, this, &PendingFeed::onConnectToServerDone);
+        connect(&accountModel, &AccountModel::accountsReady, this, &PendingFeed::onAccountsChanged);
+        connect(&accountModel, &AccountModel::rowsInserted, this, &PendingFeed::onAccountsChanged);
+        connect(&accountModel, &AccountModel::rowsRemoved, this, &PendingFeed::onAccountsChanged);
+        connect(&accountModel, &AccountModel::modelReset, this, &PendingFeed::onAccountsChanged);
+    }
+
+    bool PendingFeed::getEnabled() const {
+        return fEnabled;
+    }
+
+    void PendingFeed::setEnabled(bool enabled) {
+        if ( enabled == fEnabled ) {
+            return;
+        }
+
+        fEnabled = enabled;
+        QSettings settings;
+        settings.setValue("transactions/pendingfeed", enabled);
+
+        if ( enabled ) {
+            start();
+        } else {
+            stop();
+        }
+
+        emit enabledChanged(enabled);
+    }
+
+    void PendingFeed::onConnectToServerDone() {
+        stop(); // node (re)started, subscriptions are gone anyhow
+        start();
+    }
+
+    void PendingFeed::onAccountsChanged() {
+        buildAddresses();
+    }
+
+    void PendingFeed::onConnected() {
+        EtherLog::logMsg("Pending transaction feed connected", LS_Info);
+
+        QJsonArray params;
+        params.append(QString("newPendingTransactions"));
+
+        QJsonObject request;
+        request["jsonrpc"] = QString("2.0");
+        request["id"] = sSubscribeID;
+        request["method"] = QString("eth_subscribe");
+        request["params"] = params;
+        write(QJsonDocument(request));
+    }
+
+    void PendingFeed::onReadyRead() {
+        fReadBuffer += fSocket.readAll();
+
+        // geth sends one message per line
+        int end = fReadBuffer.indexOf('\n');
+        while ( end >= 0 ) {
+            const QByteArray line = fReadBuffer.left(end).trimmed();
+            fReadBuffer.remove(0, end + 1);
+            end = fReadBuffer.indexOf('\n');
+
+            if ( line.isEmpty() ) {
+                continue;
+            }
+
+            QJsonParseError parseError;
+            const QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+            if ( parseError.error != QJsonParseError::NoError ) {
+                EtherLog::logMsg("Pending feed parse error: " + parseError.errorString(), LS_Warning);
+                continue;
+            }
+
+            if ( doc.isArray() ) { // batched lookup replies
+                foreach ( const QJsonValue& reply, doc.array() ) {
+                    handleMessage(reply.toObject());
+                }
+            } else {
+                handleMessage(doc.object());
+            }
+        }
+    }
+
+    void PendingFeed::onError(QLocalSocket::LocalSocketError error) {
+        Q_UNUSED(error);
+        EtherLog::logMsg("Pending transaction feed error: " + fSocket.errorString(), LS_Warning);
+    }
+
+    void PendingFeed::flushHashes() {
+        if ( fHashes.isEmpty() || fSocket.state() != QLocalSocket::ConnectedState ) {
+            fHashes.clear();
+            return;
+        }
+
+        QJsonArray batch;
+        foreach ( const QString& hash, fHashes ) {
+            QJsonArray params;
+            params.append(hash);
+
+            QJsonObject request;
+            request["jsonrpc"] = QString("2.0");
+            request["id"] = fNextID++;
+            request["method"] = QString("eth_getTransactionByHash");
+            request["params"] = params;
+            batch.append(request);
+        }
+        fHashes.clear();
+
+        write(QJsonDocument(batch));
+    }
+
+    void PendingFeed::start() {
+        if ( !fEnabled || fIpc.isThinClient() || fIpc.ipcPath().isEmpty() || fSocket.state() != QLocalSocket::UnconnectedState ) {
+            return; // remote nodes don't give us a local socket, connectToServerDone starts us once there is one
+        }
+
+        buildAddresses();
+        fSocket.connectToServer(fIpc.ipcPath()); // same node, same socket
+    }
+
+    void PendingFeed::stop() {
+        fFlushTimer.stop();
+        fHashes.clear();
+        fReadBuffer.clear();
+
+        if ( fSocket.state() != QLocalSocket::UnconnectedState ) {
+            fSocket.abort(); // subscription dies with the connection
+        }
+    }
+
+    void PendingFeed::write(const QJsonDocument& doc) {
+        if ( fSocket.write(doc.toJson(QJsonDocument::Compact) + "\n") < 0 ) {
+            EtherLog::logMsg("Pending feed write error: " + fSocket.errorString(), LS_Warning);
+        }
+    }
+
+    void PendingFeed::handleMessage(const QJsonObject& message) {
+        if ( message.value("method").toString() == "eth_subscription" ) {
+            if ( fAddresses.isEmpty() ) {
+                return;
+            }
+
+            fHashes.append(message.value("params").toObject().value("result").toString());
+            if ( fHashes.size() >= sMaxBatch ) {
+                fFlushTimer.stop();
+                flushHashes();
+            } else if ( !fFlushTimer.isActive() ) {
+                fFlushTimer.start();
+            }
+            return;
+        }
+
+        if ( message.contains("error") ) {
+            const QString error = message.value("error").toObject().value("message").toString();
+            EtherLog::logMsg("Pending feed error: " + error, LS_Warning);
+            if ( message.value("id").toInt() == sSubscribeID ) {
+                stop(); // node doesn't support subscriptions here, nothing to do
+            }
+            return;
+        }
+
+        const QJsonValue result = message.value("result");
+        if ( result.isObject() && isIncoming(result.toObject()) ) {
+            emit incomingTransaction(result.toObject());
+        }
+    }
+
+    bool PendingFeed::isIncoming(const QJsonObject& tx) const {
+        const QString to = tx.value("to").toString();
+        if ( fAddresses.contains(Address::fromHex(to)) ) {
+            return true;
+        }
+
+        // token transfer(address,uint256) to us
+        const QString recipient = ERC20::Codec<ERC20::Transfer>::recipient(tx.value("input").toString());
+        return !recipient.isEmpty() && fAddresses.contains(Address::fromHex(recipient));
+    }
+
+    void PendingFeed::buildAddresses() {
+        fAddresses.clear();
+        foreach ( const AccountInfo& info, fAccountModel.getAccounts() ) {
+            fAddresses.insert(Address::fromHex(info.hash()));
+        }
+    }
+
+}
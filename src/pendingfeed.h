@@ -0,0 +1,59 @@
+#ifndef PENDINGFEED_H
+#define PENDINGFEED_H
+
+#include <QObject>
+#include <QLocalSocket>
+#include <QTimer>
+#include <QSet>
+#include <QStringList>
+#include <QJsonObject>
+#include "nodeipc.h"
+#include "accountmodel.h"
+#include "address.h"
+
+namespace Etherwall {
+
+    // optional push feed of pending transactions from the local geth, on a connection of its own
+    // so the subscription traffic doesn't queue behind regular requests. New hashes are looked up
+    // in batches and only transactions paying one of our accounts (ether or token transfer) are reported
+    class PendingFeed : public QObject
+    {
+        Q_OBJECT
+        Q_PROPERTY(bool enabled READ getEnabled WRITE setEnabled NOTIFY enabledChanged FINAL)
+    public:
+        PendingFeed(NodeIPC& ipc, const AccountModel& accountModel);
+
+        bool getEnabled() const;
+        void setEnabled(bool enabled);
+    signals:
+        void enabledChanged(bool enabled) const;
+        void incomingTransaction(const QJsonObject& json) const;
+    private slots:
+        void onConnectToServerDone();
+        void onAccountsChanged();
+        void onConnected();
+        void onReadyRead();
+        void onError(QLocalSocket::LocalSocketError error);
+        void flushHashes();
+    private:
+        NodeIPC& fIpc;
+        const AccountModel& fAccountModel;
+        QLocalSocket fSocket;
+        QTimer fFlushTimer;
+        QByteArray fReadBuffer;
+        QSet<Address> fAddresses;
+        QStringList fHashes;
+        bool fEnabled;
+        int fNextID;
+
+        void start();
+        void stop();
+        void write(const QJsonDocument& doc);
+        void handleMessage(const QJsonObject& message);
+        bool isIncoming(const QJsonObject& tx) const;
+        void buildAddresses();
+    };
+
+}
+
+#endif // PENDINGFEED_H
@@ -0,0 +1,245 @@
+#include "pendingtracker.h"
+#include "helpers.h"
+#include "etherlog.h"
+#include <QSettings>
+#include <QJsonValue>
+
+namespace Etherwall {
+
+    static const quint64 sStuckBlocks = 20; // ~5 minutes without getting mined
+    static const quint64 sMaxPollStep = 64;
+
+    PendingTracker::PendingTx::PendingTx() : fTx(), fPassword(), fSentBlock(0), fNextPoll(0), fPollStep(1), fStuck(false), fReplacedBy()
+    {
+    }
+
+    PendingTracker::PendingTx::PendingTx(const QVariantMap& tx, const QString& password, quint64 blockNumber) :
+        fTx(tx), fPassword(password), fSentBlock(blockNumber), fNextPoll(blockNumber + 1), fPollStep(1), fStuck(false), fReplacedBy()
+    {
+    }
+
+    PendingTracker::PendingTracker(NodeIPC& ipc, TransactionModel& transactionModel, const AccountModel& accountModel, const GasOracle& gasOracle) :
+        QObject(0), fIpc(ipc), fTransactionModel(transactionModel), fAccountModel(accountModel), fGasOracle(gasOracle),
+        fPending(), fReplacing(), fBlockNumber(0), fPolicy(ReplaceNotify)
+    {
+        const QSettings settings;
+        fPolicy = (ReplacementPolicy)settings.value("transactions/replacepolicy", (int)ReplaceNotify).toInt();
+
+        connect(&transactionModel, &TransactionModel::transactionSubmitted, this, &PendingTracker::onTransactionSubmitted);
+        connect(&ipc, &NodeIPC::transactionLookupDone, this, &PendingTracker::onTransactionLookupDone);
+        connect(&ipc, &NodeIPC::connectToServerDone, this, &PendingTracker::onConnectToServerDone);
+    }
+
+    int PendingTracker::getPolicy() const {
+        return fPolicy;
+    }
+
+    void PendingTracker::setPolicy(int policy) {
+        if ( policy < ReplaceOff || policy > ReplaceAuto || policy == fPolicy ) {
+            return;
+        }
+
+        fPolicy = (ReplacementPolicy)policy;
+        QSettings settings;
+        settings.setValue("transactions/replacepolicy", policy);
+
+        if ( fPolicy != ReplaceAuto ) { // no reason to hold on to these anymore
+            QMutableHashIterator<QString, PendingTx> it(fPending);
+            while ( it.hasNext() ) {
+                it.next().value().fPassword.clear();
+            }
+        }
+
+        emit policyChanged(policy);
+    }
+
+    bool PendingTracker::isStuck(const QString& hash) const {
+        return fPending.contains(hash) && fPending.value(hash).fStuck && fPending.value(hash).fReplacedBy.isEmpty();
+    }
+
+    const QVariantMap PendingTracker::getReplacement(const QString& hash) {
+        if ( !fPending.contains(hash) ) {
+            return QVariantMap();
+        }
+
+        QVariantMap result = fPending.value(hash).fTx;
+        result["gasPrice"] = bumpedGasPrice(result.value("gasPrice").toString());
+        const int index = fAccountModel.accountIndex(Address::fromHex(result.value("from").toString()));
+        result["hdpath"] = index >= 0 ? fAccountModel.getAccountHDPath(index) : QString();
+        fReplacing[nonceKey(result.value("from").toString(), result.value("nonce").toULongLong())] = hash;
+
+        return result;
+    }
+
+    bool PendingTracker::speedUp(const QString& hash, const QString& password) {
+        if ( !fPending.contains(hash) || !fPending.value(hash).fReplacedBy.isEmpty() ) {
+            return false;
+        }
+
+        const QVariantMap tx = getReplacement(hash);
+        if ( !tx.value("hdpath").toString().isEmpty() ) {
+            return false; // needs signing on the device, see getReplacement
+        }
+
+        try {
+            const quint64 nonce = tx.value("nonce").toULongLong();
+            const Ethereum::Tx replacement(tx.value("from").toString(), tx.value("to").toString(), tx.value("value").toString(),
+                                           nonce, tx.value("gas").toString(), tx.value("gasPrice").toString(), tx.value("data").toString());
+            EtherLog::logMsg("Replacing transaction " + hash + " with gas price " + tx.value("gasPrice").toString(), LS_Info);
+            fTransactionModel.replaceTransaction(password, replacement, nonce);
+        } catch ( QString err ) {
+            EtherLog::logMsg("Unable to replace transaction " + hash + ": " + err, LS_Error);
+            return false;
+        }
+
+        return true;
+    }
+
+    void PendingTracker::onTransactionSubmitted(const QString& hash, const QVariantMap& tx, const QString& password) {
+        if ( fPolicy == ReplaceOff ) {
+            return;
+        }
+
+        fPending[hash] = PendingTx(tx, fPolicy == ReplaceAuto ? password : QString(), fBlockNumber);
+
+        const QString key = nonceKey(tx.value("from").toString(), tx.value("nonce").toULongLong());
+        if ( fReplacing.contains(key) ) {
+            const QString oldHash = fReplacing.take(key);
+            if ( fPending.contains(oldHash) ) {
+                fPending[oldHash].fReplacedBy = hash;
+                fPending[oldHash].fPassword.clear();
+            }
+            emit replacedTransaction(oldHash, hash);
+        }
+    }
+
+    void PendingTracker::onTransactionLookupDone(const QString& hash, const QJsonObject& json) {
+        if ( !fPending.contains(hash) ) {
+            return;
+        }
+
+        PendingTx& pending = fPending[hash];
+        if ( json.isEmpty() ) { // dropped from the pool, only a replacement gets the nonce used
+            if ( !pending.fStuck && pending.fReplacedBy.isEmpty() ) {
+                EtherLog::logMsg("Transaction " + hash + " is unknown to the node, assuming dropped", LS_Warning);
+                markStuck(hash, pending);
+            }
+            return;
+        }
+
+        // the node knows best, we might have just guessed the nonce
+        const quint64 nonce = Helpers::toQUInt64(json.value("nonce"));
+        pending.fTx["nonce"] = QString::number(nonce);
+        pending.fTx["gasPrice"] = Helpers::weiStrToEtherStr(Helpers::toDecStr(json.value("gasPrice")));
+
+        if ( Helpers::toQUInt64(json.value("blockNumber")) > 0 ) {
+            forgetNonce(pending.fTx.value("from").toString(), nonce);
+        }
+    }
+
+    void PendingTracker::onNewBlock(const DecodedBlock& block) {
+        const quint64 blockNum = block.fNumber;
+        if ( blockNum == 0 ) {
+            return; // pending block
+        }
+        fBlockNumber = qMax(fBlockNumber, blockNum); // light ingest bodies come in after their header
+
+        if ( fPending.isEmpty() ) {
+            return;
+        }
+
+        // mined, whichever of the same nonce made it in the others are gone
+        for ( int i = 0; i < block.fTransactions.size(); i++ ) {
+            if ( block.fOurs.testBit(i) ) { // forgetNonce only matches our own senders anyway
+                const DecodedTransaction& tx = block.fTransactions.at(i);
+                forgetNonce(tx.fFrom.toHex(), tx.fNonce);
+            }
+        }
+
+        if ( block.fRefetch ) {
+            return; // polled when the block was announced hash only
+        }
+
+        QMutableHashIterator<QString, PendingTx> it(fPending);
+        while ( it.hasNext() ) {
+            it.next();
+            PendingTx& pending = it.value();
+            if ( !pending.fReplacedBy.isEmpty() ) {
+                continue;
+            }
+
+            if ( pending.fSentBlock == 0 ) { // sent before we saw any block
+                pending.fSentBlock = blockNum;
+            }
+
+            if ( pending.fNextPoll <= blockNum ) {
+                fIpc.getTransactionByHash(it.key());
+                pending.fPollStep = qMin(pending.fPollStep * 2, sMaxPollStep);
+                pending.fNextPoll = blockNum + pending.fPollStep;
+            }
+
+            checkStuck(it.key(), pending);
+        }
+    }
+
+    void PendingTracker::onConnectToServerDone() {
+        fPending.clear();
+        fReplacing.clear();
+    }
+
+    const QString PendingTracker::bumpedGasPrice(const QString& gasPrice) const {
+        // nodes want at least 10% more to accept a replacement
+        const quint64 wei = QString(Helpers::etherStrToRossi(gasPrice).toStrDec().c_str()).toULongLong();
+        quint64 bumped = wei + wei / 8 + 1;
+
+        if ( !fGasOracle.isEmpty() ) {
+            const quint64 fast = QString(Helpers::etherStrToRossi(fGasOracle.getFast()).toStrDec().c_str()).toULongLong();
+            bumped = qMax(bumped, fast);
+        }
+
+        return Helpers::weiStrToEtherStr(QString::number(bumped));
+    }
+
+    void PendingTracker::checkStuck(const QString& hash, PendingTx& pending) {
+        if ( pending.fStuck || fBlockNumber < pending.fSentBlock + sStuckBlocks ) {
+            return;
+        }
+
+        // priced well and just unlucky, give it time
+        const QString gasPrice = pending.fTx.value("gasPrice").toString();
+        if ( !fGasOracle.isEmpty() && !(Helpers::etherStrToRossi(gasPrice) < Helpers::etherStrToRossi(fGasOracle.getStandard())) ) {
+            return;
+        }
+
+        markStuck(hash, pending);
+    }
+
+    void PendingTracker::markStuck(const QString& hash, PendingTx& pending) {
+        pending.fStuck = true;
+        const QString suggested = bumpedGasPrice(pending.fTx.value("gasPrice").toString());
+        EtherLog::logMsg("Transaction " + hash + " seems stuck, suggested gas price: " + suggested, LS_Warning);
+        emit stuckTransaction(hash, suggested);
+
+        if ( fPolicy == ReplaceAuto && !pending.fPassword.isEmpty() ) {
+            speedUp(hash, pending.fPassword);
+        }
+    }
+
+    void PendingTracker::forgetNonce(const QString& from, quint64 nonce) {
+        QMutableHashIterator<QString, PendingTx> it(fPending);
+        while ( it.hasNext() ) {
+            it.next();
+            const QVariantMap& tx = it.value().fTx;
+            if ( tx.value("nonce").toULongLong() == nonce && QString::compare(tx.value("from").toString(), from, Qt::CaseInsensitive) == 0 ) {
+                it.remove();
+            }
+        }
+
+        fReplacing.remove(nonceKey(from, nonce));
+    }
+
+    const QString PendingTracker::nonceKey(const QString& from, quint64 nonce) const {
+        return from.toLower() + "_" + QString::number(nonce);
+    }
+
+}
@@ -0,0 +1,80 @@
+#ifndef PENDINGTRACKER_H
+#define PENDINGTRACKER_H
+
+#include <QObject>
+#include <QHash>
+#include <QVariantMap>
+#include <QJsonObject>
+#include "nodeipc.h"
+#include "transactionmodel.h"
+#include "accountmodel.h"
+#include "gasoracle.h"
+#include "decodedblock.h"
+
+namespace Etherwall {
+
+    enum ReplacementPolicy {
+        ReplaceOff = 0,
+        ReplaceNotify,
+        ReplaceAuto
+    };
+
+    // watches our unconfirmed transactions and replaces underpriced ones with the same nonce
+    // at a higher gas price. Polls back off exponentially, mined ones are spotted in new blocks
+    class PendingTracker : public QObject
+    {
+        Q_OBJECT
+        Q_PROPERTY(int policy READ getPolicy WRITE setPolicy NOTIFY policyChanged FINAL)
+    public:
+        PendingTracker(NodeIPC& ipc, TransactionModel& transactionModel, const AccountModel& accountModel, const GasOracle& gasOracle);
+
+        int getPolicy() const;
+        void setPolicy(int policy);
+
+        Q_INVOKABLE bool isStuck(const QString& hash) const;
+        Q_INVOKABLE const QVariantMap getReplacement(const QString& hash); // bumped tx, for signing elsewhere (TREZOR)
+        Q_INVOKABLE bool speedUp(const QString& hash, const QString& password);
+    public slots:
+        void onNewBlock(const DecodedBlock& block);
+    signals:
+        void policyChanged(int policy) const;
+        void stuckTransaction(const QString& hash, const QString& suggestedGasPrice) const;
+        void replacedTransaction(const QString& oldHash, const QString& newHash) const;
+    private slots:
+        void onTransactionSubmitted(const QString& hash, const QVariantMap& tx, const QString& password);
+        void onTransactionLookupDone(const QString& hash, const QJsonObject& json);
+        void onConnectToServerDone();
+    private:
+        class PendingTx {
+        public:
+            PendingTx();
+            PendingTx(const QVariantMap& tx, const QString& password, quint64 blockNumber);
+
+            QVariantMap fTx;
+            QString fPassword; // only with auto policy
+            quint64 fSentBlock;
+            quint64 fNextPoll;
+            quint64 fPollStep;
+            bool fStuck;
+            QString fReplacedBy;
+        };
+
+        NodeIPC& fIpc;
+        TransactionModel& fTransactionModel;
+        const AccountModel& fAccountModel;
+        const GasOracle& fGasOracle;
+        QHash<QString, PendingTx> fPending;
+        QHash<QString, QString> fReplacing; // "from_nonce" -> hash being replaced, until the new hash is known
+        quint64 fBlockNumber;
+        ReplacementPolicy fPolicy;
+
+        const QString bumpedGasPrice(const QString& gasPrice) const;
+        void checkStuck(const QString& hash, PendingTx& pending);
+        void markStuck(const QString& hash, PendingTx& pending);
+        void forgetNonce(const QString& from, quint64 nonce);
+        const QString nonceKey(const QString& from, quint64 nonce) const;
+    };
+
+}
+
+#endif // PENDINGTRACKER_H
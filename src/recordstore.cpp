@@ -0,0 +1,335 @@
+#include "recordstore.h"
+#include "etherlog.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include <QVector>
+#include <algorithm>
+
+namespace Etherwall {
+
+    static const qint64 sSegmentSize = 1024 * 1024; // roll over to a new segment after this
+    static const int sHeaderSize = 8; // payload length + crc
+    static const QString sMetaTable = "meta";
+
+    static const QVector<quint32> crcTable() {
+        QVector<quint32> result(256);
+        for ( quint32 i = 0; i < 256; i++ ) {
+            quint32 c = i;
+            for ( int k = 0; k < 8; k++ ) {
+                c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            }
+            result[i] = c;
+        }
+
+        return result;
+    }
+
+    static quint32 crc32(const QByteArray& data) {
+        static const QVector<quint32> table = crcTable();
+        quint32 crc = 0xFFFFFFFF;
+        for ( int i = 0; i < data.size(); i++ ) {
+            crc = table.at((crc ^ (quint8)data.at(i)) & 0xFF) ^ (crc >> 8);
+        }
+
+        return crc ^ 0xFFFFFFFF;
+    }
+
+    static void appendUInt(QByteArray& data, quint32 value, int size) {
+        for ( int i = 0; i < size; i++ ) {
+            data.append((char)((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    static bool readUInt(const QByteArray& data, int& pos, int size, quint32& value) {
+        if ( pos + size > data.size() ) {
+            return false;
+        }
+
+        value = 0;
+        for ( int i = 0; i < size; i++ ) {
+            value |= (quint32)(quint8)data.at(pos + i) << (8 * i);
+        }
+        pos += size;
+
+        return true;
+    }
+
+    RecordStore::Entry::Entry() : fValue(), fSegment(0), fSize(0)
+    {
+    }
+
+    RecordStore::Entry::Entry(const QByteArray& value, int segment, qint64 size) : fValue(value), fSegment(segment), fSize(size)
+    {
+    }
+
+    RecordStore::Segment::Segment() : fSize(0), fLive(0)
+    {
+    }
+
+    RecordStore::RecordStore(const QString& dirName) : fDirName(dirName), fTables(), fSegments(), fActive()
+    {
+        QDir dir(dirName);
+        dir.mkpath(".");
+
+        QList<int> segments;
+        foreach ( const QString& name, dir.entryList(QStringList("*.log"), QDir::Files) ) {
+            bool ok = false;
+            const int segment = QFileInfo(name).baseName().toInt(&ok);
+            if ( ok && segment > 0 ) {
+                segments.append(segment);
+            }
+        }
+        std::sort(segments.begin(), segments.end());
+
+        foreach ( int segment, segments ) {
+            replay(segment);
+        }
+
+        openSegment(segments.isEmpty() ? 1 : segments.last());
+    }
+
+    bool RecordStore::put(const QString& table, const QString& key, const QByteArray& value) {
+        if ( fTables.value(table).contains(key) && fTables.value(table).value(key).fValue == value ) {
+            return true; // unchanged, no need to grow the log
+        }
+
+        const qint64 size = append(RecordPut, table, key, value);
+        if ( size < 0 ) {
+            return false;
+        }
+
+        forget(table, key);
+        const int segment = fSegments.lastKey();
+        fTables[table][key] = Entry(value, segment, size);
+        fSegments[segment].fLive += size;
+
+        compactStep();
+        return true;
+    }
+
+    bool RecordStore::remove(const QString& table, const QString& key) {
+        if ( !contains(table, key) ) {
+            return true;
+        }
+
+        if ( append(RecordRemove, table, key, QByteArray()) < 0 ) {
+            return false;
+        }
+
+        forget(table, key);
+        compactStep();
+        return true;
+    }
+
+    const QByteArray RecordStore::value(const QString& table, const QString& key) const {
+        return fTables.value(table).value(key).fValue;
+    }
+
+    bool RecordStore::contains(const QString& table, const QString& key) const {
+        return fTables.value(table).contains(key);
+    }
+
+    const QStringList RecordStore::keys(const QString& table) const {
+        return fTables.value(table).keys();
+    }
+
+    void RecordStore::migrateSettings() {
+        if ( contains(sMetaTable, "settings") ) {
+            return;
+        }
+
+        static const QStringList groups = QStringList() << "transactions" << "accounts" << "contracts" << "filters";
+        // plain settings that happen to live in those groups
+        static const QStringList settingKeys = QStringList() << "transactions/pendingfeed" << "transactions/replacepolicy";
+        QSettings settings;
+        QStringList migrated;
+        foreach ( const QString& key, settings.allKeys() ) {
+            const int slash = key.lastIndexOf('/');
+            const QString group = key.section('/', 0, 0);
+            bool ours = false;
+            foreach ( const QString& prefix, groups ) {
+                ours = ours || group.startsWith(prefix);
+            }
+
+            if ( slash < 0 || !ours || key == "accounts/default" || key.startsWith("accounts/default/") || settingKeys.contains(key) ) { // default account is a setting
+                continue;
+            }
+
+            if ( !put(key.left(slash), key.mid(slash + 1), settings.value(key).toString().toUtf8()) ) {
+                EtherLog::logMsg("Settings migration failed, will retry on next start", LS_Error);
+                return;
+            }
+            migrated.append(key);
+        }
+
+        put(sMetaTable, "settings", "1");
+        foreach ( const QString& key, migrated ) {
+            settings.remove(key);
+        }
+
+        EtherLog::logMsg("Migrated " + QString::number(migrated.size()) + " records from settings", LS_Info);
+    }
+
+    const QString RecordStore::segmentFileName(int segment) const {
+        return fDirName + "/" + QString("%1.log").arg(segment, 6, 10, QChar('0'));
+    }
+
+    void RecordStore::replay(int segment) {
+        const QString fileName = segmentFileName(segment);
+        QFile file(fileName);
+        if ( !file.open(QIODevice::ReadOnly) ) {
+            EtherLog::logMsg("Unable to open store segment: " + file.errorString(), LS_Error);
+            return;
+        }
+
+        const QByteArray data = file.readAll();
+        file.close();
+        fSegments[segment] = Segment();
+
+        int pos = 0;
+        while ( pos + sHeaderSize <= data.size() ) {
+            int at = pos;
+            quint32 length, crc;
+            readUInt(data, at, 4, length);
+            readUInt(data, at, 4, crc);
+            if ( length > (quint32)(data.size() - at) ) {
+                break; // cut short by a crash
+            }
+
+            const QByteArray payload = data.mid(at, length);
+            if ( crc32(payload) != crc ) {
+                break;
+            }
+
+            int p = 0;
+            quint32 op, tableLength, keyLength, valueLength;
+            if ( !readUInt(payload, p, 1, op) || !readUInt(payload, p, 2, tableLength) || p + (int)tableLength > payload.size() ) {
+                break;
+            }
+            const QString table = QString::fromUtf8(payload.mid(p, tableLength));
+            p += tableLength;
+            if ( !readUInt(payload, p, 2, keyLength) || p + (int)keyLength > payload.size() ) {
+                break;
+            }
+            const QString key = QString::fromUtf8(payload.mid(p, keyLength));
+            p += keyLength;
+            if ( !readUInt(payload, p, 4, valueLength) || p + (int)valueLength > payload.size() ) {
+                break;
+            }
+
+            const qint64 size = sHeaderSize + length;
+            forget(table, key);
+            if ( op == RecordPut ) {
+                fTables[table][key] = Entry(payload.mid(p, valueLength), segment, size);
+                fSegments[segment].fLive += size;
+            }
+            pos += size;
+        }
+
+        if ( pos < data.size() ) {
+            EtherLog::logMsg("Dropping damaged store records in " + fileName + " after offset " + QString::number(pos), LS_Warning);
+            QFile::resize(fileName, pos);
+        }
+        fSegments[segment].fSize = pos;
+    }
+
+    bool RecordStore::openSegment(int segment) {
+        fActive.close();
+        fActive.setFileName(segmentFileName(segment));
+        if ( !fSegments.contains(segment) ) {
+            fSegments[segment] = Segment();
+        }
+
+        if ( !fActive.open(QIODevice::WriteOnly | QIODevice::Append) ) {
+            EtherLog::logMsg("Unable to open store segment: " + fActive.errorString(), LS_Error);
+            return false;
+        }
+
+        return true;
+    }
+
+    qint64 RecordStore::append(RecordOp op, const QString& table, const QString& key, const QByteArray& value) {
+        if ( fSegments.last().fSize >= sSegmentSize && !openSegment(fSegments.lastKey() + 1) ) {
+            return -1;
+        }
+
+        const QByteArray tableData = table.toUtf8();
+        const QByteArray keyData = key.toUtf8();
+        QByteArray payload;
+        appendUInt(payload, op, 1);
+        appendUInt(payload, tableData.size(), 2);
+        payload.append(tableData);
+        appendUInt(payload, keyData.size(), 2);
+        payload.append(keyData);
+        appendUInt(payload, value.size(), 4);
+        payload.append(value);
+
+        QByteArray record;
+        appendUInt(record, payload.size(), 4);
+        appendUInt(record, crc32(payload), 4);
+        record.append(payload);
+
+        const qint64 offset = fSegments.last().fSize;
+        if ( fActive.write(record) != record.size() || !fActive.flush() ) {
+            EtherLog::logMsg("Unable to write store record: " + fActive.errorString(), LS_Error);
+            fActive.resize(offset);
+            return -1;
+        }
+
+        fSegments.last().fSize += record.size();
+        return record.size();
+    }
+
+    void RecordStore::forget(const QString& table, const QString& key) {
+        if ( !contains(table, key) ) {
+            return;
+        }
+
+        const Entry entry = fTables[table].take(key);
+        fSegments[entry.fSegment].fLive -= entry.fSize;
+        if ( fTables.value(table).isEmpty() ) {
+            fTables.remove(table);
+        }
+    }
+
+    void RecordStore::compactStep() {
+        if ( fSegments.size() < 2 ) {
+            return;
+        }
+
+        // only ever the oldest, so its removals can go too, there's nothing older left for them to hide
+        const int oldest = fSegments.firstKey();
+        if ( fSegments.first().fLive * 2 > fSegments.first().fSize ) {
+            return;
+        }
+
+        QMutableHashIterator<QString, QHash<QString, Entry> > tables(fTables);
+        while ( tables.hasNext() ) {
+            tables.next();
+            QMutableHashIterator<QString, Entry> entries(tables.value());
+            while ( entries.hasNext() ) {
+                Entry& entry = entries.next().value();
+                if ( entry.fSegment != oldest ) {
+                    continue;
+                }
+
+                const qint64 size = append(RecordPut, tables.key(), entries.key(), entry.fValue);
+                if ( size < 0 ) {
+                    return; // try again next time, nothing is lost
+                }
+
+                fSegments[oldest].fLive -= entry.fSize;
+                entry.fSegment = fSegments.lastKey();
+                entry.fSize = size;
+                fSegments.last().fLive += size;
+            }
+        }
+
+        if ( !QFile::remove(segmentFileName(oldest)) ) {
+            EtherLog::logMsg("Unable to remove compacted store segment " + QString::number(oldest), LS_Warning);
+        }
+        fSegments.remove(oldest);
+    }
+
+}
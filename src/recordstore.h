@@ -0,0 +1,68 @@
+#ifndef RECORDSTORE_H
+#define RECORDSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QFile>
+
+namespace Etherwall {
+
+    // keyed tables (transactions, accounts, contracts, filters) in an append-only log of CRC32
+    // checked records. The log is split into segments, the whole index lives in memory and is
+    // rebuilt by replaying the segments on startup. Each write may compact the oldest segment
+    // once it's mostly dead, by re-appending its live records and dropping the file
+    class RecordStore
+    {
+    public:
+        RecordStore(const QString& dirName);
+
+        bool put(const QString& table, const QString& key, const QByteArray& value);
+        bool remove(const QString& table, const QString& key);
+        const QByteArray value(const QString& table, const QString& key) const;
+        bool contains(const QString& table, const QString& key) const;
+        const QStringList keys(const QString& table) const;
+
+        void migrateSettings(); // one-time import of the old QSettings json groups
+    private:
+        enum RecordOp {
+            RecordPut = 1,
+            RecordRemove = 2
+        };
+
+        class Entry {
+        public:
+            Entry();
+            Entry(const QByteArray& value, int segment, qint64 size);
+
+            QByteArray fValue;
+            int fSegment;
+            qint64 fSize;
+        };
+
+        class Segment {
+        public:
+            Segment();
+
+            qint64 fSize;
+            qint64 fLive;
+        };
+
+        QString fDirName;
+        QHash<QString, QHash<QString, Entry> > fTables;
+        QMap<int, Segment> fSegments; // ordered, last one is being appended to
+        QFile fActive;
+
+        const QString segmentFileName(int segment) const;
+        void replay(int segment);
+        bool openSegment(int segment);
+        qint64 append(RecordOp op, const QString& table, const QString& key, const QByteArray& value); // bytes written, -1 on error
+        void forget(const QString& table, const QString& key);
+        void compactStep();
+    };
+
+}
+
+#endif // RECORDSTORE_H
@@ -0,0 +1,114 @@
+#include "settingscache.h"
+#include <QEvent>
+#include <QtConcurrent/QtConcurrent>
+
+namespace Etherwall {
+
+    static const int sFlushDelay = 2000; // ms
+
+    // QSettings stores "a//b/" as "a/b", allKeys() gives us that form so lookups have to use it too
+    static const QString normalized(const QString& key) {
+        QString result = key;
+        result.replace('\\', '/');
+        return result.split('/', QString::SkipEmptyParts).join('/');
+    }
+
+    bool SettingsCache::DeferredSettings::event(QEvent* event) {
+        if ( event->type() == QEvent::UpdateRequest ) {
+            return true; // flush() takes care of it
+        }
+
+        return QSettings::event(event);
+    }
+
+    SettingsCache::SettingsCache() : QObject(0), fSettings(), fValues(), fFlushTimer(), fFlushWatcher(), fDirty(false)
+    {
+        foreach ( const QString& key, fSettings.allKeys() ) {
+            fValues[key] = fSettings.value(key);
+        }
+
+        fFlushTimer.setSingleShot(true);
+        fFlushTimer.setInterval(sFlushDelay);
+        connect(&fFlushTimer, &QTimer::timeout, this, &SettingsCache::flush);
+        connect(&fFlushWatcher, &QFutureWatcher<void>::finished, this, &SettingsCache::onFlushDone);
+    }
+
+    SettingsCache::~SettingsCache()
+    {
+        fFlushTimer.stop();
+        fFlushWatcher.waitForFinished();
+        fSettings.sync(); // last chance, do it here and now
+    }
+
+    const QVariant SettingsCache::value(const QString& key, const QVariant& defaultValue) const {
+        return fValues.value(normalized(key), defaultValue);
+    }
+
+    bool SettingsCache::contains(const QString& key) const {
+        return fValues.contains(normalized(key));
+    }
+
+    const QStringList SettingsCache::childKeys(const QString& group) const {
+        const QString prefix = normalized(group) + "/";
+        QStringList result;
+        foreach ( const QString& key, fValues.keys() ) {
+            if ( key.startsWith(prefix) ) {
+                result.append(key.mid(prefix.length()));
+            }
+        }
+
+        return result;
+    }
+
+    void SettingsCache::setValue(const QString& rawKey, const QVariant& value) {
+        const QString key = normalized(rawKey);
+        if ( fValues.contains(key) && fValues.value(key) == value ) {
+            return; // nothing to write
+        }
+
+        fValues[key] = value;
+        fSettings.setValue(key, value); // other QSettings in the process see it right away
+        fDirty = true;
+        fFlushTimer.start();
+    }
+
+    void SettingsCache::remove(const QString& rawKey) {
+        const QString key = normalized(rawKey);
+        const QString prefix = key + "/";
+        QMutableHashIterator<QString, QVariant> it(fValues);
+        while ( it.hasNext() ) {
+            it.next();
+            if ( it.key() == key || it.key().startsWith(prefix) ) {
+                it.remove();
+            }
+        }
+
+        fSettings.remove(key);
+        fDirty = true;
+        fFlushTimer.start();
+    }
+
+    void SettingsCache::flush() {
+        if ( !fDirty ) {
+            return;
+        }
+
+        if ( fFlushWatcher.isRunning() ) {
+            return; // onFlushDone reschedules
+        }
+
+        fDirty = false;
+        // pending changes live in the per process store, any QSettings instance writes them out
+        fFlushWatcher.setFuture(QtConcurrent::run([]() {
+            QSettings settings;
+            settings.sync();
+        }));
+    }
+
+    void SettingsCache::onFlushDone() {
+        if ( fDirty && !fFlushTimer.isActive() ) {
+            fFlushTimer.start();
+        }
+    }
+
+}
@@ -0,0 +1,48 @@
+#ifndef SETTINGSCACHE_H
+#define SETTINGSCACHE_H
+
+#include <QObject>
+#include <QSettings>
+#include <QHash>
+#include <QVariant>
+#include <QStringList>
+#include <QTimer>
+#include <QFutureWatcher>
+
+namespace Etherwall {
+
+    // settings for the hot paths (account list, default account, helper currency). Everything is
+    // read once on startup and served from memory, writes land in memory right away and hit the
+    // disk coalesced, on a worker thread. Keys kept here must only be written through here
+    class SettingsCache : public QObject
+    {
+        Q_OBJECT
+    public:
+        SettingsCache();
+        ~SettingsCache();
+
+        const QVariant value(const QString& key, const QVariant& defaultValue = QVariant()) const;
+        bool contains(const QString& key) const;
+        const QStringList childKeys(const QString& group) const; // all keys below group, relative to it
+        void setValue(const QString& key, const QVariant& value);
+        void remove(const QString& key); // key and everything below it, like QSettings
+        void flush();
+    private slots:
+        void onFlushDone();
+    private:
+        // Qt syncs to disk on the next event loop pass after every write, we want to decide that
+        class DeferredSettings : public QSettings {
+        protected:
+            bool event(QEvent* event);
+        };
+
+        DeferredSettings fSettings;
+        QHash<QString, QVariant> fValues;
+        QTimer fFlushTimer;
+        QFutureWatcher<void> fFlushWatcher;
+        bool fDirty;
+    };
+
+}
+
+#endif // SETTINGSCACHE_H
@@ -0,0 +1,89 @@
+#include "startupsequence.h"
+#include "etherlog.h"
+#include <QSettings>
+
+namespace Etherwall {
+
+    StartupSequence::StartupSequence(const QString& gethPath, Initializer& initializer, NodeIPC& ipc, const AccountModel& accountModel) :
+        QObject(0), fGethPath(gethPath), fInitializer(initializer), fClock(), fBegun(), fTimeline(), fNodeStarted(false), fDone(false)
+    {
+        fClock.start();
+
+        connect(&initializer, &Initializer::initDone, this, &StartupSequence::onInitDone);
+        connect(&initializer, &Initializer::warning, this, &StartupSequence::onWarning);
+        connect(&ipc, &NodeIPC::connectToServerDone, this, &StartupSequence::onConnectToServerDone);
+        connect(&accountModel, &AccountModel::accountsReady, this, &StartupSequence::onAccountsReady);
+    }
+
+    void StartupSequence::start()
+    {
+        const QSettings settings;
+        const bool thinClient = settings.value("geth/thinclient", false).toBool();
+
+        begin("init check");
+        fInitializer.start();
+
+        if ( !thinClient ) { // local node, no need to wait for the server
+            startNodeOnce("0.0.0", QString(), QString());
+        }
+    }
+
+    void StartupSequence::begin(const QString& phase)
+    {
+        fBegun[phase] = fClock.elapsed();
+    }
+
+    void StartupSequence::end(const QString& phase)
+    {
+        if ( !fBegun.contains(phase) ) {
+            return; // already ended, e.g. on reconnect
+        }
+
+        const qint64 begun = fBegun.take(phase);
+        const qint64 now = fClock.elapsed();
+        fTimeline.append(phase + " " + QString::number(now - begun) + "ms (" + QString::number(begun) + "-" + QString::number(now) + ")");
+        EtherLog::logMsg("Startup: " + phase + " done after " + QString::number(now - begun) + "ms", LS_Debug);
+
+        if ( !fDone && fBegun.isEmpty() && fNodeStarted ) {
+            fDone = true;
+            EtherLog::logMsg("Startup timeline: " + fTimeline.join(", "), LS_Info);
+        }
+    }
+
+    void StartupSequence::onInitDone(const QString& gethPath, const QString& version, const QString& endpoint, const QString& warning)
+    {
+        Q_UNUSED(gethPath);
+        end("init check");
+        startNodeOnce(version, endpoint, warning); // thin client, or proceeding after a warning
+    }
+
+    void StartupSequence::onWarning()
+    {
+        end("init check");
+    }
+
+    void StartupSequence::onConnectToServerDone()
+    {
+        end("node connection");
+        if ( !fDone ) {
+            begin("accounts");
+        }
+    }
+
+    void StartupSequence::onAccountsReady()
+    {
+        end("accounts");
+    }
+
+    void StartupSequence::startNodeOnce(const QString& version, const QString& endpoint, const QString& warning)
+    {
+        if ( fNodeStarted ) {
+            return;
+        }
+
+        fNodeStarted = true;
+        begin("node connection");
+        emit startNode(fGethPath, version, endpoint, warning);
+    }
+
+}
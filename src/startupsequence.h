@@ -0,0 +1,47 @@
+#ifndef STARTUPSEQUENCE_H
+#define STARTUPSEQUENCE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QStringList>
+#include "initializer.h"
+#include "nodeipc.h"
+#include "accountmodel.h"
+
+namespace Etherwall {
+
+    // runs startup phases side by side instead of one after the other. A full node doesn't need anything
+    // from the Etherwall server so it's started right away, the init check only gates the thin client
+    // (it gives us the endpoint). Server warnings are shown whenever they arrive. Logs a timeline at the end
+    class StartupSequence : public QObject
+    {
+        Q_OBJECT
+    public:
+        StartupSequence(const QString& gethPath, Initializer& initializer, NodeIPC& ipc, const AccountModel& accountModel);
+
+        Q_INVOKABLE void start();
+        void begin(const QString& phase);
+        void end(const QString& phase);
+    signals:
+        void startNode(const QString& gethPath, const QString& version, const QString& endpoint, const QString& warning) const;
+    private slots:
+        void onInitDone(const QString& gethPath, const QString& version, const QString& endpoint, const QString& warning);
+        void onWarning();
+        void onConnectToServerDone();
+        void onAccountsReady();
+    private:
+        QString fGethPath;
+        Initializer& fInitializer;
+        QElapsedTimer fClock; // since the models were set up
+        QHash<QString, qint64> fBegun;
+        QStringList fTimeline;
+        bool fNodeStarted;
+        bool fDone;
+
+        void startNodeOnce(const QString& version, const QString& endpoint, const QString& warning);
+    };
+
+}
+
+#endif // STARTUPSEQUENCE_H
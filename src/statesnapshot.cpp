@@ -0,0 +1,125 @@
+#include "statesnapshot.h"
+#include "etherlog.h"
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+
+namespace Etherwall {
+
+    static const quint32 sMagic = 0x45575353; // EWSS
+    static const quint32 sVersion = 1;
+    static const int sSaveInterval = 300 * 1000; // 5m
+
+    StateSnapshot::StateSnapshot(const QString& fileName, AccountModel& accountModel, TransactionModel& transactionModel,
+                                 GasOracle& gasOracle, CurrencyModel& currencyModel) :
+        QObject(0), fFileName(fileName), fAccountModel(accountModel), fTransactionModel(transactionModel),
+        fGasOracle(gasOracle), fCurrencyModel(currencyModel), fTimer()
+    {
+        QDir().mkpath(QFileInfo(fileName).absolutePath());
+        load();
+
+        fTimer.setInterval(sSaveInterval);
+        connect(&fTimer, &QTimer::timeout, this, &StateSnapshot::save);
+        fTimer.start();
+    }
+
+    StateSnapshot::~StateSnapshot()
+    {
+        save();
+    }
+
+    bool StateSnapshot::save()
+    {
+        if ( fAccountModel.getStale() && fTransactionModel.getBlockNumberStale() ) {
+            return true; // nothing new since we loaded it
+        }
+
+        // each model gets its own blob so a bad one doesn't take the others down
+        QByteArray sections[4];
+        QDataStream accounts(&sections[0], QIODevice::WriteOnly);
+        QDataStream transactions(&sections[1], QIODevice::WriteOnly);
+        QDataStream gas(&sections[2], QIODevice::WriteOnly);
+        QDataStream currencies(&sections[3], QIODevice::WriteOnly);
+        accounts.setVersion(QDataStream::Qt_5_0);
+        transactions.setVersion(QDataStream::Qt_5_0);
+        gas.setVersion(QDataStream::Qt_5_0);
+        currencies.setVersion(QDataStream::Qt_5_0);
+
+        fAccountModel.saveState(accounts);
+        fTransactionModel.saveState(transactions);
+        fGasOracle.saveState(gas);
+        fCurrencyModel.saveState(currencies);
+
+        QSaveFile file(fFileName);
+        if ( !file.open(QIODevice::WriteOnly) ) {
+            EtherLog::logMsg("Unable to write state snapshot: " + file.errorString(), LS_Error);
+            return false;
+        }
+
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_5_0);
+        stream << sMagic << sVersion;
+        for ( int i = 0; i < 4; i++ ) {
+            stream << sections[i];
+        }
+
+        if ( !file.commit() ) {
+            EtherLog::logMsg("Unable to write state snapshot: " + file.errorString(), LS_Error);
+            return false;
+        }
+
+        return true;
+    }
+
+    void StateSnapshot::load()
+    {
+        QFile file(fFileName);
+        if ( !file.exists() || !file.open(QIODevice::ReadOnly) ) {
+            return;
+        }
+
+        const qint64 size = file.size();
+        uchar* map = size > 0 ? file.map(0, size) : 0;
+        if ( map == 0 ) {
+            return;
+        }
+
+        const QByteArray raw = QByteArray::fromRawData((const char*)map, size);
+        QDataStream stream(raw);
+        stream.setVersion(QDataStream::Qt_5_0);
+        quint32 magic, version;
+        stream >> magic >> version;
+        if ( magic != sMagic || version != sVersion ) {
+            EtherLog::logMsg("State snapshot version mismatch, ignoring", LS_Info);
+            file.unmap(map);
+            return;
+        }
+
+        QByteArray sections[4];
+        for ( int i = 0; i < 4; i++ ) {
+            stream >> sections[i];
+        }
+        file.unmap(map); // sections are deep copies
+
+        if ( stream.status() != QDataStream::Ok ) {
+            EtherLog::logMsg("Corrupt state snapshot, ignoring", LS_Warning);
+            return;
+        }
+
+        QDataStream accounts(sections[0]);
+        QDataStream transactions(sections[1]);
+        QDataStream gas(sections[2]);
+        QDataStream currencies(sections[3]);
+        accounts.setVersion(QDataStream::Qt_5_0);
+        transactions.setVersion(QDataStream::Qt_5_0);
+        gas.setVersion(QDataStream::Qt_5_0);
+        currencies.setVersion(QDataStream::Qt_5_0);
+
+        fAccountModel.loadState(accounts);
+        fTransactionModel.loadState(transactions);
+        fGasOracle.loadState(gas);
+        fCurrencyModel.loadState(currencies);
+    }
+
+}
@@ -0,0 +1,38 @@
+#ifndef STATESNAPSHOT_H
+#define STATESNAPSHOT_H
+
+#include <QObject>
+#include <QTimer>
+#include "accountmodel.h"
+#include "transactionmodel.h"
+#include "gasoracle.h"
+#include "currencymodel.h"
+
+namespace Etherwall {
+
+    // what the UI showed last time (accounts with balances, block number, gas and currency prices)
+    // so there's something to look at right at launch. Written at shutdown and every few minutes,
+    // read back before the node connects. Models mark restored values stale until refreshed
+    class StateSnapshot : public QObject
+    {
+        Q_OBJECT
+    public:
+        StateSnapshot(const QString& fileName, AccountModel& accountModel, TransactionModel& transactionModel,
+                      GasOracle& gasOracle, CurrencyModel& currencyModel);
+        ~StateSnapshot();
+    public slots:
+        bool save();
+    private:
+        QString fFileName;
+        AccountModel& fAccountModel;
+        TransactionModel& fTransactionModel;
+        GasOracle& fGasOracle;
+        CurrencyModel& fCurrencyModel;
+        QTimer fTimer;
+
+        void load();
+    };
+
+}
+
+#endif // STATESNAPSHOT_H
@@ -20,6 +20,7 @@
 
 #include "transactionmodel.h"
 #include "helpers.h"
+#include "erc20codec.h"
 #include "ethereum/tx.h"
 #include <QDebug>
 #include <QTimer>
@@ -29,6 +30,8 @@
 #include <QJsonDocument>
 #include <QCoreApplication>
 #include <QSettings>
+#include <QRegExp>
+#include <QCryptographicHash>
 
 namespace Etherwall {
     const int ALWAYS_FAILING_TX_ERROR = -32000;
@@ -46,8 +49,25 @@ namespace Etherwall {
         return false; // otherwise leave as error
     }
 
-    TransactionModel::TransactionModel(NodeIPC& ipc, const AccountModel& accountModel) :
-        QAbstractListModel(0), fIpc(ipc), fAccountModel(accountModel), fBlockNumber(0), fLastBlock(0), fFirstBlock(0), fGasPrice("unknown"), fGasEstimate("unknown"), fNetManager(this),
+    QueuedTransaction::QueuedTransaction() : fInfo(), fTx(), fBatchIndex(-1), fPassword()
+    {
+    }
+
+    QueuedTransaction::QueuedTransaction(const Ethereum::Tx& tx, quint64 nonce, int batchIndex, const QString& password) :
+        fInfo(), fTx(), fBatchIndex(batchIndex), fPassword(password)
+    {
+        fInfo.init(tx.fromStr(), tx.toStr(), tx.valueStr(), tx.gasStr(), tx.gasPriceStr(), tx.dataStr());
+        fTx["from"] = tx.fromStr();
+        fTx["to"] = tx.toStr();
+        fTx["value"] = tx.valueStr();
+        fTx["gas"] = tx.gasStr();
+        fTx["gasPrice"] = tx.gasPriceStr();
+        fTx["data"] = tx.dataStr();
+        fTx["nonce"] = QString::number(nonce);
+    }
+
+    TransactionModel::TransactionModel(NodeIPC& ipc, CallCache& callCache, const GasOracle& gasOracle, const AccountModel& accountModel, RecordStore& store) :
+        QAbstractListModel(0), fIpc(ipc), fCallCache(callCache), fGasOracle(gasOracle), fAccountModel(accountModel), fStore(store), fBlockNumber(0), fBlockNumberStale(false), fLastBlock(0), fFirstBlock(0), fGasPrice("unknown"), fGasEstimate("unknown"), fGasEstimateProvisional(false), fNetManager(this),
         fLatestVersion(QCoreApplication::applicationVersion())
     {
         ipc.registerIpcErrorHandler(ALWAYS_FAILING_TX_ERROR, &handleGasEstimateError);
@@ -57,11 +77,13 @@ namespace Etherwall {
         connect(&ipc, &NodeIPC::getBlockNumberDone, this, &TransactionModel::getBlockNumberDone);
         connect(&ipc, &NodeIPC::getGasPriceDone, this, &TransactionModel::getGasPriceDone);
         connect(&ipc, &NodeIPC::estimateGasDone, this, &TransactionModel::estimateGasDone);
+        connect(&ipc, &NodeIPC::estimateGasFailed, this, &TransactionModel::estimateGasFailed);
+        connect(&ipc, &NodeIPC::sendTransactionFailed, this, &TransactionModel::onSendTransactionFailed);
         connect(&ipc, &NodeIPC::sendTransactionDone, this, &TransactionModel::onSendTransactionDone);
         connect(&ipc, &NodeIPC::signTransactionDone, this, &TransactionModel::onSignTransactionDone);
         connect(&ipc, &NodeIPC::newTransaction, this, &TransactionModel::onNewTransaction);
-        connect(&ipc, &NodeIPC::newBlock, this, &TransactionModel::newBlock);
         connect(&ipc, &NodeIPC::syncingChanged, this, &TransactionModel::syncingChanged);
+        connect(&gasOracle, &GasOracle::pricesChanged, this, &TransactionModel::onGasPricesChanged);
 
         connect(&fNetManager, SIGNAL(finished(QNetworkReply*)), this, SLOT(httpRequestDone(QNetworkReply*)));
         checkVersion(); // TODO: move this off at some point
@@ -75,6 +97,26 @@ namespace Etherwall {
         return fFirstBlock;
     }
 
+    bool TransactionModel::getBlockNumberStale() const {
+        return fBlockNumberStale;
+    }
+
+    void TransactionModel::saveState(QDataStream& stream) const {
+        stream << fBlockNumber;
+    }
+
+    void TransactionModel::loadState(QDataStream& stream) {
+        quint64 blockNumber;
+        stream >> blockNumber;
+        if ( stream.status() != QDataStream::Ok || fBlockNumber > 0 || blockNumber == 0 ) {
+            return;
+        }
+
+        fBlockNumber = blockNumber;
+        fBlockNumberStale = true;
+        emit blockNumberChanged(blockNumber);
+    }
+
     quint64 TransactionModel::getLastBlock() const {
         return fLastBlock;
     }
@@ -87,6 +129,10 @@ namespace Etherwall {
         return fGasEstimate;
     }
 
+    bool TransactionModel::getGasEstimateProvisional() const {
+        return fGasEstimateProvisional;
+    }
+
     const QString& TransactionModel::getLatestVersion() const {
         return fLatestVersion;
     }
@@ -145,6 +191,7 @@ namespace Etherwall {
     }
 
     void TransactionModel::connectToServerDone() {
+        fPendingEstimates.clear(); // went down with the old connection
         fIpc.getBlockNumber();
         fIpc.getGasPrice();
     }
@@ -155,11 +202,12 @@ namespace Etherwall {
     }
 
     void TransactionModel::getBlockNumberDone(quint64 num) {
-        if ( num <= fBlockNumber ) {
+        if ( num <= fBlockNumber && !fBlockNumberStale ) {
             return;
         }
 
         fBlockNumber = num;
+        fBlockNumberStale = false;
         if ( fFirstBlock == 0 ) {
             fFirstBlock = num;
         }
@@ -180,18 +228,145 @@ namespace Etherwall {
         }
     }
 
-    void TransactionModel::estimateGasDone(const QString& num) {
-        if ( num != fGasEstimate ) {
+    void TransactionModel::onGasPricesChanged() {
+        const QString standard = fGasOracle.getStandard();
+        if ( !standard.isEmpty() ) {
+            getGasPriceDone(standard);
+        }
+    }
+
+    void TransactionModel::estimateGasDone(const QString& num, const QVariantMap& userData) {
+        const QString key = userData.value("key").toString();
+        if ( !fPendingEstimates.contains(key) ) { // not one of ours
+            return;
+        }
+
+        const bool notify = fPendingEstimates.take(key);
+        if ( !userData.value("errorHandled").toBool() ) { // the 90k fallback is only good for this once
+            fGasEstimates[key] = num;
+            fProvisionalEstimates[userData.value("provisionalKey").toString()] = num;
+        }
+        if ( notify ) {
+            setGasEstimate(num);
+        }
+    }
+
+    void TransactionModel::estimateGasFailed(const QVariantMap& userData) {
+        // only this one failed, the rest still get their replies
+        fPendingEstimates.remove(userData.value("key").toString());
+    }
+
+    void TransactionModel::onSendTransactionFailed(const QString& from, quint64 nonce, const QString& error) {
+        const int index = queuedIndex(from, nonce);
+        if ( index < 0 ) {
+            return; // not sent through us, e.g. a resend of an existing one
+        }
+
+        const QueuedTransaction failed = fQueuedTransactions.takeAt(index);
+        if ( failed.fBatchIndex >= 0 ) {
+            emit batchTransactionFailed(failed.fBatchIndex, error);
+        }
+    }
+
+    int TransactionModel::queuedIndex(const QString& from, quint64 nonce) const {
+        for ( int i = 0; i < fQueuedTransactions.size(); i++ ) {
+            const QVariantMap& tx = fQueuedTransactions.at(i).fTx;
+            if ( tx.value("nonce").toULongLong() == nonce && tx.value("from").toString().compare(from, Qt::CaseInsensitive) == 0 ) {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    void TransactionModel::estimateGas(const QString& from, const QString& to, const QString& value,
+                                       const QString& gas, const QString& gasPrice, const QString& data) {
+        queueGasEstimate(from, to, value, gas, gasPrice, data, true);
+    }
+
+    void TransactionModel::prefetchGasEstimate(const QString& from, const QString& to, const QString& value,
+                                               const QString& gas, const QString& gasPrice, const QString& data) {
+        queueGasEstimate(from, to, value, gas, gasPrice, data, false);
+    }
+
+    void TransactionModel::queueGasEstimate(const QString& from, const QString& to, const QString& value,
+                                            const QString& gas, const QString& gasPrice, const QString& data, bool notify) {
+        const QString key = gasEstimateKey(from, to, value, data);
+        if ( fGasEstimates.contains(key) ) {
+            if ( notify ) {
+                setGasEstimate(fGasEstimates.value(key));
+            }
+            return;
+        }
+
+        // e.g. prefetched before the amount was typed in, good enough to show until the exact one is back
+        const QString provisionalKey = provisionalEstimateKey(from, to, value, data);
+        if ( notify && fProvisionalEstimates.contains(provisionalKey) ) {
+            setGasEstimate(fProvisionalEstimates.value(provisionalKey), true);
+        }
+
+        // already asked, possibly speculatively, just make sure we hear about it
+        if ( fPendingEstimates.contains(key) ) {
+            fPendingEstimates[key] = fPendingEstimates.value(key) || notify;
+            return;
+        }
+
+        QVariantMap userData;
+        userData["key"] = key;
+        userData["provisionalKey"] = provisionalKey;
+        fPendingEstimates[key] = notify;
+        fIpc.estimateGas(from, to, value, gas, gasPrice, data, userData);
+    }
+
+    const QString TransactionModel::gasEstimateKey(const QString& from, const QString& to, const QString& value, const QString& data) const {
+        // exact amounts, a transfer of more than the balance fails where a smaller one doesn't
+        const QString raw = from + "_" + to + "_" + value + "_" + Helpers::hexPrefix(data);
+        return QCryptographicHash::hash(raw.toLower().toUtf8(), QCryptographicHash::Md5).toHex();
+    }
+
+    // the amount only changes the gas used when it decides success or failure, so for plain sends
+    // and token transfers an estimate for another amount is close, just not to be relied on
+    const QString TransactionModel::provisionalEstimateKey(const QString& from, const QString& to, const QString& value, const QString& data) const {
+        const QString valueBucket = QString(value).remove(QRegExp("[0.]")).isEmpty() ? "0" : "n";
+        QString dataKey = Helpers::hexPrefix(data).toLower();
+
+        const QString transferPrefix = "0x" + ERC20::selectorHex(ERC20::sTransferSelector);
+        if ( dataKey.startsWith(transferPrefix) && dataKey.length() == transferPrefix.length() + 128 ) {
+            dataKey = dataKey.left(dataKey.length() - 64); // fixed width amount word
+        }
+
+        const QString raw = from + "_" + to + "_" + valueBucket + "_" + dataKey;
+        return QCryptographicHash::hash(raw.toLower().toUtf8(), QCryptographicHash::Md5).toHex();
+    }
+
+    void TransactionModel::setGasEstimate(const QString& num, bool provisional) {
+        if ( num != fGasEstimate || provisional != fGasEstimateProvisional ) {
             fGasEstimate = num;
+            fGasEstimateProvisional = provisional;
             emit gasEstimateChanged(num);
         }
+
+        emit gasEstimateDone(num);
     }
 
     void TransactionModel::sendTransaction(const QString& password, const QString& from, const QString& to,
                                            const QString& value, quint64 nonce, const QString& gas, const QString& gasPrice,
                                            const QString& data) {
-        Ethereum::Tx tx(from, to, value, nonce, gas, gasPrice, data); // nonce not required here, ipc.sendTransaction doesn't fill it in as it's known to geth
-        fQueuedTransaction.init(from, to, value, gas, gasPrice, data);
+        Ethereum::Tx tx(from, to, value, nonce, gas, gasPrice, data); // nonce reserved by the account model, sent along so geth doesn't pick its own
+        queueTransaction(password, tx, nonce, -1);
+    }
+
+    void TransactionModel::sendBatchTransaction(const QString& password, const Ethereum::Tx& tx, quint64 nonce, int batchIndex) {
+        queueTransaction(password, tx, nonce, batchIndex);
+    }
+
+    void TransactionModel::replaceTransaction(const QString& password, const Ethereum::Tx& tx, quint64 nonce) {
+        // same nonce as the one it replaces, sent along like any other
+        queueTransaction(password, tx, nonce, -1);
+    }
+
+    void TransactionModel::queueTransaction(const QString& password, const Ethereum::Tx& tx, quint64 nonce, int batchIndex) {
+        fQueuedTransactions.append(QueuedTransaction(tx, nonce, batchIndex, password));
 
         if ( fIpc.isThinClient() ) {
             fIpc.signTransaction(tx, password);
@@ -205,28 +380,45 @@ namespace Etherwall {
     {
         Ethereum::Tx tx(from, to, value, 0, gas, gasPrice, data); // nonce not required here, ipc.call doesn't fill it in
 
-        fIpc.call(tx, index, userData);
+        fCallCache.call(tx, index, userData);
     }
 
     void TransactionModel::onRawTransaction(const Ethereum::Tx& tx)
     {
-        fQueuedTransaction.init(tx.fromStr(), tx.toStr(), tx.valueStr(), tx.gasStr(), tx.gasPriceStr(), tx.dataStr());
+        const quint64 nonce = Helpers::clearHexPrefix(tx.nonceHex()).toULongLong(0, 16);
+        fQueuedTransactions.append(QueuedTransaction(tx, nonce, -1, QString()));
         fIpc.sendRawTransaction(tx);
     }
 
-    void TransactionModel::onSendTransactionDone(const QString& hash) {
-        fQueuedTransaction.setHash(hash);
-        addTransaction(fQueuedTransaction);
-        storeTransaction(fQueuedTransaction);
+    void TransactionModel::onSendTransactionDone(const QString& hash, const QString& from, quint64 nonce) {
+        const int index = queuedIndex(from, nonce);
+        if ( index < 0 ) {
+            EtherLog::logMsg("Unexpected transaction hash: " + hash, LS_Warning);
+            return;
+        }
+
+        QueuedTransaction queued = fQueuedTransactions.takeAt(index);
+        queued.fInfo.setHash(hash);
+        addTransaction(queued.fInfo);
+        storeTransaction(queued.fInfo);
         EtherLog::logMsg("Transaction sent, hash: " + hash);
+
+        emit transactionSubmitted(hash, queued.fTx, queued.fPassword);
+        if ( queued.fBatchIndex >= 0 ) {
+            emit batchTransactionSent(queued.fBatchIndex, hash);
+        }
     }
 
-    void TransactionModel::onSignTransactionDone(const QString &hash)
+    void TransactionModel::onSignTransactionDone(const QString &raw, const QString& from, quint64 nonce)
     {
-        fIpc.sendRawTransaction(hash);
+        fIpc.sendRawTransaction(raw, from, nonce);
     }
 
     void TransactionModel::onNewTransaction(const QJsonObject &json) {
+        if ( json.isEmpty() ) {
+            return; // unknown to the node, e.g. dropped from the pool
+        }
+
         const TransactionInfo info(json);
         int ai1, ai2;
         const QString& sender = info.value(SenderRole).toString().toLower();
@@ -249,22 +441,28 @@ namespace Etherwall {
         }
     }
 
-    void TransactionModel::newBlock(const QJsonObject& block) {
-        const QJsonArray transactions = block.value("transactions").toArray();
-        const quint64 blockNum = Helpers::toQUInt64(block.value("number"));
+    void TransactionModel::newBlock(const DecodedBlock& block) {
+        const quint64 blockNum = block.fNumber;
 
         if ( blockNum == 0 ) {
             return; // not interested in pending blocks
         }
 
-        fIpc.getGasPrice(); // let's update our gas price
+        if ( !block.fRefetch ) { // once per block, not again for a light ingest body
+            if ( fGasOracle.isEmpty() ) { // no txs seen yet (e.g. empty testnet blocks), ask the node
+                fIpc.getGasPrice();
+            }
+            fGasEstimates.clear(); // state changed, estimates might have too
+        }
 
-        foreach ( QJsonValue t, transactions ) {
-            const QJsonObject to = t.toObject();
+        // ours are all from or to one of our accounts, the rest is of no interest
+        for ( int i = 0; i < block.fTransactions.size(); i++ ) {
+            if ( !block.fOurs.testBit(i) ) {
+                continue;
+            }
+
+            const QJsonObject& to = block.fTransactions.at(i).fJson;
             const QString thash = to.value("hash").toString();
-            const QString sender = to.value("from").toString().toLower();
-            const QString receiver = to.value("to").toString().toLower();
-            int i1, i2;
 
             const int n = containsTransaction(thash);
             if ( n >= 0 ) {
@@ -278,7 +476,7 @@ namespace Etherwall {
                 const TransactionInfo info = fTransactionList.at(n);
                 storeTransaction(fTransactionList.at(n));
                 emit confirmedTransaction(info.getSender(), info.getReceiver(), info.getHash());
-            } else if ( fAccountModel.containsAccount(sender, receiver, i1, i2) ) {
+            } else {
                 const TransactionInfo info = TransactionInfo(to);
                 addTransaction(info);
                 storeTransaction(info);
@@ -287,6 +485,20 @@ namespace Etherwall {
         }
     }
 
+    void TransactionModel::onPendingIncoming(const QJsonObject& json) {
+        const QString sender = json.value("from").toString().toLower();
+        const QString token = ERC20::Codec<ERC20::Transfer>::recipient(json.value("input").toString());
+        const QString receiver = token.isEmpty() ? json.value("to").toString().toLower() : token; // the contract isn't ours
+        int i1, i2;
+
+        // token transfers show up as events once mined, newBlock stores these when they get in
+        if ( containsTransaction(json.value("hash").toString()) < 0 && fAccountModel.containsAccount(sender, receiver, i1, i2) ) {
+            const TransactionInfo info = TransactionInfo(json);
+            addTransaction(info);
+            emit receivedTransaction(receiver);
+        }
+    }
+
     void TransactionModel::syncingChanged(bool syncing)
     {
         if ( !syncing ) {
@@ -321,10 +533,7 @@ namespace Etherwall {
     void TransactionModel::storeTransaction(const TransactionInfo& info) {
         // save to persistent memory for re-run
         const quint64 blockNum = info.value(BlockNumberRole).toULongLong();
-        QSettings settings;
-        settings.beginGroup("transactions");
-        settings.setValue(Helpers::toDecStr(blockNum) + "_" + info.value(TransactionIndexRole).toString(), info.toJsonString());
-        settings.endGroup();
+        fStore.put("transactions", Helpers::toDecStr(blockNum) + "_" + info.value(TransactionIndexRole).toString(), info.toJsonString().toUtf8());
     }
 
     bool transCompare(const TransactionInfo& a, const TransactionInfo& b) {
@@ -333,12 +542,10 @@ namespace Etherwall {
 
     void TransactionModel::refresh()
     {
-        QSettings settings;
-        settings.beginGroup("transactions");
-        QStringList list = settings.allKeys();
+        const QStringList list = fStore.keys("transactions");
 
         foreach ( const QString bns, list ) {
-            const QString val = settings.value(bns, "bogus").toString();
+            const QString val = QString::fromUtf8(fStore.value("transactions", bns));
             if ( val.contains("{") ) { // new format, get data and reload only recent transactions
                 QJsonParseError parseError;
                 const QJsonDocument jsonDoc = QJsonDocument::fromJson(val.toUtf8(), &parseError);
@@ -352,19 +559,18 @@ namespace Etherwall {
                     if ( txBlockNum > 0 ) { // don't add "pending", we might have a failed leftover
                         addTransaction(json);
                     } else {
-                        settings.remove(bns);
+                        fStore.remove("transactions", bns);
                     }
                     // if transaction is newer than 1 day restore it from geth anyhow to ensure correctness in case of reorg
                     if ( txBlockNum == 0 || fBlockNumber - txBlockNum < 5400 ) {
                         fIpc.getTransactionByHash(json.value("hash").toString());
                     }
                 }
-            } else if ( val != "bogus" ) { // old format, re-get and store full data
+            } else if ( val.startsWith("0x") ) { // old format, re-get and store full data
                 fIpc.getTransactionByHash(val);
-                settings.remove(bns);
+                fStore.remove("transactions", bns);
             }
         }
-        settings.endGroup();
 
         qSort(fTransactionList.begin(), fTransactionList.end(), transCompare);
 
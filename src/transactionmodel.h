@@ -27,32 +27,58 @@
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
 #include <QNetworkReply>
+#include <QVariantMap>
+#include <QDataStream>
 #include "types.h"
 #include "nodeipc.h"
 #include "accountmodel.h"
+#include "callcache.h"
+#include "gasoracle.h"
+#include "decodedblock.h"
+#include "recordstore.h"
 #include "etherlog.h"
 
 namespace Etherwall {
 
+    // handed to the node, waiting for the hash
+    class QueuedTransaction {
+    public:
+        QueuedTransaction();
+        QueuedTransaction(const Ethereum::Tx& tx, quint64 nonce, int batchIndex, const QString& password);
+
+        TransactionInfo fInfo;
+        QVariantMap fTx; // what we asked for, used for replacements
+        int fBatchIndex; // -1 if not part of a batch
+        QString fPassword; // dropped once the hash arrives
+    };
+
     class TransactionModel : public QAbstractListModel
     {
         Q_OBJECT
         Q_PROPERTY(quint64 firstBlock READ getFirstBlock NOTIFY blockNumberChanged)
         Q_PROPERTY(quint64 lastBlock READ getLastBlock NOTIFY blockNumberChanged)
         Q_PROPERTY(quint64 blockNumber READ getBlockNumber NOTIFY blockNumberChanged FINAL)
+        Q_PROPERTY(bool blockNumberStale READ getBlockNumberStale NOTIFY blockNumberChanged FINAL)
         Q_PROPERTY(QString gasPrice READ getGasPrice NOTIFY gasPriceChanged FINAL)
         Q_PROPERTY(QString gasEstimate READ getGasEstimate NOTIFY gasEstimateChanged FINAL)
+        Q_PROPERTY(bool gasEstimateProvisional READ getGasEstimateProvisional NOTIFY gasEstimateChanged FINAL)
         Q_PROPERTY(QString latestVersion READ getLatestVersion NOTIFY latestVersionChanged FINAL)
     public:
-        TransactionModel(NodeIPC& ipc, const AccountModel& accountModel);
+        TransactionModel(NodeIPC& ipc, CallCache& callCache, const GasOracle& gasOracle, const AccountModel& accountModel, RecordStore& store);
         quint64 getBlockNumber() const;
+        bool getBlockNumberStale() const;
+        void saveState(QDataStream& stream) const;
+        void loadState(QDataStream& stream);
         const QString& getGasPrice() const;
         const QString& getLatestVersion() const;
         const QString& getGasEstimate() const;
+        bool getGasEstimateProvisional() const;
         QHash<int, QByteArray> roleNames() const;
         int rowCount(const QModelIndex & parent = QModelIndex()) const;
         QVariant data(const QModelIndex & index, int role = Qt::DisplayRole) const;
         int containsTransaction(const QString& hash);
+        void sendBatchTransaction(const QString& password, const Ethereum::Tx& tx, quint64 nonce, int batchIndex);
+        void replaceTransaction(const QString& password, const Ethereum::Tx& tx, quint64 nonce);
 
         Q_INVOKABLE void sendTransaction(const QString& password, const QString& from, const QString& to,
                              const QString& value, quint64 nonce, const QString& gas = QString(),
@@ -63,6 +89,10 @@ namespace Etherwall {
                              const QString& gasPrice, const QString& data,
                              int index, const QVariantMap& userData);
 
+        Q_INVOKABLE void estimateGas(const QString& from, const QString& to, const QString& value,
+                                     const QString& gas, const QString& gasPrice, const QString& data);
+        Q_INVOKABLE void prefetchGasEstimate(const QString& from, const QString& to, const QString& value,
+                                             const QString& gas, const QString& gasPrice, const QString& data);
         Q_INVOKABLE const QString estimateTotal(const QString& value, const QString& gas, const QString& gasPrice) const;
         Q_INVOKABLE void loadHistory();
         Q_INVOKABLE const QString getHash(int index) const;
@@ -78,16 +108,20 @@ namespace Etherwall {
         quint64 getLastBlock() const;
     public slots:
         void onRawTransaction(const Ethereum::Tx& tx);
+        void onPendingIncoming(const QJsonObject& json);
+        void newBlock(const DecodedBlock& block);
     private slots:
         void connectToServerDone();
         void getAccountsDone(const QStringList& list);
         void getBlockNumberDone(quint64 num);
         void getGasPriceDone(const QString& num);
-        void estimateGasDone(const QString& num);
-        void onSendTransactionDone(const QString& hash);
-        void onSignTransactionDone(const QString& hash);
+        void onGasPricesChanged();
+        void estimateGasDone(const QString& num, const QVariantMap& userData);
+        void estimateGasFailed(const QVariantMap& userData);
+        void onSendTransactionDone(const QString& hash, const QString& from, quint64 nonce);
+        void onSendTransactionFailed(const QString& from, quint64 nonce, const QString& error);
+        void onSignTransactionDone(const QString& raw, const QString& from, quint64 nonce);
         void onNewTransaction(const QJsonObject& json);
-        void newBlock(const QJsonObject& block);
         void syncingChanged(bool syncing);
         void refresh();
         void loadHistoryDone(QNetworkReply* reply);
@@ -97,28 +131,47 @@ namespace Etherwall {
         void blockNumberChanged(quint64 num) const;
         void gasPriceChanged(const QString& price) const;
         void gasEstimateChanged(const QString& price) const;
+        void gasEstimateDone(const QString& price) const;
         void historyChanged() const;
         void latestVersionChanged(const QString& version, bool manualVersionCheck) const;
         void latestVersionSame(const QString& version, bool manualVersionCheck) const;
         void receivedTransaction(const QString& toAddress) const;
         void confirmedTransaction(const QString& fromAddress, const QString& toAddress, const QString& hash) const;
+        void transactionSubmitted(const QString& hash, const QVariantMap& tx, const QString& password) const;
+        void batchTransactionSent(int batchIndex, const QString& hash) const;
+        void batchTransactionFailed(int batchIndex, const QString& error) const;
     private:
         NodeIPC& fIpc;
+        CallCache& fCallCache;
+        const GasOracle& fGasOracle;
         const AccountModel& fAccountModel;
+        RecordStore& fStore;
         TransactionList fTransactionList;
         quint64 fBlockNumber;
+        bool fBlockNumberStale; // from the snapshot, until the node tells us
         quint64 fLastBlock;
         quint64 fFirstBlock;
         QString fGasPrice;
         QString fGasEstimate;
-        TransactionInfo fQueuedTransaction;
+        bool fGasEstimateProvisional; // from a send with another amount, the exact one is on its way
+        QList<QueuedTransaction> fQueuedTransactions;
         QNetworkAccessManager fNetManager;
         QString fLatestVersion;
+        QHash<QString, QString> fGasEstimates; // for current block only
+        QHash<QString, bool> fPendingEstimates; // key -> notify when done
+        QHash<QString, QString> fProvisionalEstimates; // amount agnostic key -> last estimate
 
         int getInsertIndex(const TransactionInfo& info) const;
         void addTransaction(const TransactionInfo& info);
         void storeTransaction(const TransactionInfo& info);
         void refreshPendingTransactions();
+        void queueTransaction(const QString& password, const Ethereum::Tx& tx, quint64 nonce, int batchIndex);
+        int queuedIndex(const QString& from, quint64 nonce) const;
+        const QString gasEstimateKey(const QString& from, const QString& to, const QString& value, const QString& data) const;
+        const QString provisionalEstimateKey(const QString& from, const QString& to, const QString& value, const QString& data) const;
+        void queueGasEstimate(const QString& from, const QString& to, const QString& value,
+                              const QString& gas, const QString& gasPrice, const QString& data, bool notify);
+        void setGasEstimate(const QString& num, bool provisional = false);
     };
 
 }
@@ -7,7 +7,7 @@
 namespace Trezor {
 
     TrezorDevice::TrezorDevice() : QObject(0),
-        fDevice(), fWorker(fDevice), fQueue(), fDeviceID(), fDevicePresent(false)
+        fDevice(), fWorker(fDevice), fQueue(), fDeviceID(), fDevicePresent(false), fPendingTx(), fSigningFrom(), fSigningNonce(0)
     {
         connect(&fWorker, &TrezorWorker::finished, this, &TrezorDevice::workerDone);
     }
@@ -129,6 +129,8 @@ namespace Trezor {
                                        quint64 nonce, const QString &gas, const QString &gasPrice, const QString &data)
     {
         fPendingTx.init(from, to, valStr, nonce, gas, gasPrice, data);
+        fSigningFrom = from;
+        fSigningNonce = nonce;
 
         EthereumSignTx request;
 
@@ -187,9 +189,21 @@ namespace Trezor {
             fQueue.clear();
         }
 
+        failSigning();
         emit error(err);
     }
 
+    void TrezorDevice::failSigning()
+    {
+        if ( fSigningFrom.isEmpty() ) {
+            return;
+        }
+
+        const QString from = fSigningFrom;
+        fSigningFrom.clear();
+        emit signingFailed(from, fSigningNonce);
+    }
+
     const Wire::Message TrezorDevice::serializeMessage(google::protobuf::Message &msg, MessageType type, const QVariant& index)
     {
         Wire::Message msg_wire;
@@ -274,6 +288,7 @@ namespace Trezor {
         }
 
         const QString error = QString::fromStdString(response.message());
+        failSigning();
         emit failure(error);
         fQueue.clear(); // we cannot continue after failure!
     }
@@ -402,6 +417,7 @@ namespace Trezor {
         std::string s = response.signature_s();
 
         fPendingTx.sign(v, r, s);
+        fSigningFrom.clear();
         emit transactionReady(fPendingTx);
     }
 
@@ -79,6 +79,7 @@ namespace Trezor {
         void addressRetrieved(const QString& address, const QString& hdPath) const;
         void busyChanged(bool busy) const;
         void transactionReady(const Ethereum::Tx& tx) const;
+        void signingFailed(const QString& from, quint64 nonce) const;
         void error(const QString& error) const;
     public slots:
         void onDeviceInserted();
@@ -94,9 +95,12 @@ namespace Trezor {
         QString fDeviceID;
         bool fDevicePresent;
         Ethereum::Tx fPendingTx;
+        QString fSigningFrom; // set while fPendingTx is on the device
+        quint64 fSigningNonce;
 
         bool getBusy() const;
         void bail(const QString& err);
+        void failSigning();
         const Wire::Message serializeMessage(google::protobuf::Message& msg, MessageType, const QVariant& index);
         bool parseMessage(const Wire::Message& msg_in, google::protobuf::Message& parsed) const;
         void sendMessage(google::protobuf::Message& msg, MessageType type, QVariant index = QVariant());
@@ -0,0 +1,9 @@
+include(../tests.pri)
+
+TARGET = tst_address
+
+SOURCES += tst_address.cpp \
+    $$SRC/address.cpp
+
+HEADERS += \
+    $$SRC/address.h
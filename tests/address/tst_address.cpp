@@ -0,0 +1,111 @@
+#include <QtTest>
+#include <QHash>
+#include <QSet>
+#include <cstring>
+#include "address.h"
+
+using namespace Etherwall;
+
+static const QString sChecksummed = "0x5aAeb6053F3E94C9b9A09f33669435E7Ef1BeAed";
+static const QString sLower = "0x5aaeb6053f3e94c9b9a09f33669435e7ef1beaed";
+
+class TestAddress : public QObject
+{
+    Q_OBJECT
+private slots:
+    void nullAddress();
+    void fromHex_data();
+    void fromHex();
+    void caseInsensitive();
+    void bytesRoundTrip();
+    void hashValue();
+    void hashKey();
+};
+
+void TestAddress::nullAddress() {
+    const Address address;
+    QVERIFY(address.isNull());
+    QVERIFY(address.toHex().isEmpty());
+    QVERIFY(address.toBytes().isEmpty());
+    QVERIFY(Address(QByteArray(19, 'a')).isNull());
+    QVERIFY(Address(QByteArray(21, 'a')).isNull());
+
+    // all zero bytes is a real address, not a null one
+    const Address zero(QByteArray(20, 0));
+    QVERIFY(!zero.isNull());
+    QVERIFY(zero != address);
+    QCOMPARE(zero.toHex(), "0x" + QString(40, '0'));
+}
+
+void TestAddress::fromHex_data() {
+    QTest::addColumn<QString>("hex");
+    QTest::addColumn<QString>("expected"); // empty for null
+
+    QTest::newRow("checksummed") << sChecksummed << sLower;
+    QTest::newRow("lowercase") << sLower << sLower;
+    QTest::newRow("uppercase") << "0x" + sLower.mid(2).toUpper() << sLower;
+    QTest::newRow("no prefix") << sLower.mid(2) << sLower;
+    QTest::newRow("upper prefix") << "0X" + sLower.mid(2) << sLower;
+    QTest::newRow("empty") << QString() << QString();
+    QTest::newRow("prefix only") << "0x" << QString();
+    QTest::newRow("short") << sLower.left(41) << QString();
+    QTest::newRow("long") << sLower + "0" << QString();
+    QTest::newRow("not hex") << "0x" + QString(39, 'a') + "g" << QString();
+    QTest::newRow("space") << " " + sLower.mid(1) << QString();
+    QTest::newRow("double prefix") << "0x0x" + sLower.mid(4) << QString();
+}
+
+void TestAddress::fromHex() {
+    QFETCH(QString, hex);
+    QFETCH(QString, expected);
+
+    const Address address = Address::fromHex(hex);
+    QCOMPARE(address.isNull(), expected.isEmpty());
+    QCOMPARE(address.toHex(), expected);
+}
+
+void TestAddress::caseInsensitive() {
+    QCOMPARE(Address::fromHex(sChecksummed), Address::fromHex(sLower));
+    QVERIFY(Address::fromHex(sLower) != Address::fromHex("0x" + QString(40, '0')));
+    QCOMPARE(Address::fromHex("invalid"), Address());
+}
+
+void TestAddress::bytesRoundTrip() {
+    const QByteArray bytes = QByteArray::fromHex(sLower.mid(2).toLatin1());
+    const Address address(bytes);
+    QCOMPARE(address.toBytes(), bytes);
+    QCOMPARE(address, Address::fromHex(sLower));
+    QCOMPARE(Address::fromHex(address.toHex()), address);
+}
+
+void TestAddress::hashValue() {
+    // bytes 16-19 in memory order
+    const Address address = Address::fromHex("0x" + QString(32, '0') + "01020304");
+    uint expected;
+    const char bytes[4] = { 1, 2, 3, 4 };
+    memcpy(&expected, bytes, sizeof(expected));
+    QCOMPARE(address.hashValue(), expected);
+    QCOMPARE(qHash(address), expected);
+    QCOMPARE(qHash(address, 5), expected ^ 5);
+
+    QCOMPARE(qHash(Address::fromHex(sChecksummed)), qHash(Address::fromHex(sLower)));
+}
+
+void TestAddress::hashKey() {
+    QHash<Address, int> balances;
+    balances[Address::fromHex(sChecksummed)] = 1;
+    balances[Address::fromHex(sLower)] = 2;
+    balances[Address::fromHex("0x" + QString(40, '0'))] = 3;
+    QCOMPARE(balances.size(), 2);
+    QCOMPARE(balances.value(Address::fromHex(sLower.mid(2))), 2);
+
+    // same low bytes, different addresses still apart
+    QSet<Address> set;
+    set.insert(Address::fromHex("0x" + QString(32, '1') + "deadbeef"));
+    set.insert(Address::fromHex("0x" + QString(32, '2') + "deadbeef"));
+    QCOMPARE(set.size(), 2);
+}
+
+QTEST_GUILESS_MAIN(TestAddress)
+
+#include "tst_address.moc"
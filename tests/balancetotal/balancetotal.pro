@@ -0,0 +1,11 @@
+include(../tests.pri)
+
+TARGET = tst_balancetotal
+
+SOURCES += tst_balancetotal.cpp \
+    $$SRC/balancetotal.cpp \
+    $$SRC/address.cpp
+
+HEADERS += \
+    $$SRC/balancetotal.h \
+    $$SRC/address.h
@@ -0,0 +1,91 @@
+#include <QtTest>
+#include "balancetotal.h"
+
+using namespace Etherwall;
+
+static const Address sFirst = Address::fromHex("0x5aAeb6053F3E94C9b9A09f33669435E7Ef1BeAed");
+static const Address sSecond = Address::fromHex("0xfB6916095ca1df60bB79Ce92cE3Ea74c37c5d359");
+static const Address sThird = Address::fromHex("0xdbF03B407c01E7cD3CBea99509d93f8DDDC8C6FB");
+
+static const BigInt::Rossi wei(const char* dec) {
+    return BigInt::Rossi(std::string(dec), 10);
+}
+
+static const QString str(const BigInt::Rossi& value) {
+    return QString(value.toStrDec().data());
+}
+
+class TestBalanceTotal : public QObject
+{
+    Q_OBJECT
+private slots:
+    void empty();
+    void sums();
+    void replacesPart();
+    void exceeds64Bits();
+    void clear();
+};
+
+void TestBalanceTotal::empty() {
+    const BalanceTotal total;
+    QCOMPARE(str(total.total()), QString("0"));
+    QCOMPARE(total.size(), 0);
+}
+
+void TestBalanceTotal::sums() {
+    BalanceTotal total;
+    total.set(sFirst, wei("5"));
+    total.set(sSecond, wei("7"));
+    total.set(sThird, wei("0"));
+    QCOMPARE(str(total.total()), QString("12"));
+    QCOMPARE(total.size(), 3);
+}
+
+void TestBalanceTotal::replacesPart() {
+    BalanceTotal total;
+    total.set(sFirst, wei("5"));
+    total.set(sSecond, wei("7"));
+
+    total.set(sFirst, wei("3")); // went down
+    QCOMPARE(str(total.total()), QString("10"));
+    total.set(sSecond, wei("100")); // went up
+    QCOMPARE(str(total.total()), QString("103"));
+    total.set(sFirst, wei("3")); // unchanged
+    QCOMPARE(str(total.total()), QString("103"));
+    total.set(sFirst, wei("0"));
+    QCOMPARE(str(total.total()), QString("100"));
+
+    // the same account however it's spelled
+    total.set(Address::fromHex(sSecond.toHex().toUpper().replace("0X", "0x")), wei("1"));
+    QCOMPARE(str(total.total()), QString("1"));
+    QCOMPARE(total.size(), 2);
+}
+
+void TestBalanceTotal::exceeds64Bits() {
+    BalanceTotal total;
+    total.set(sFirst, wei("100000000000000000000000000")); // 1e8 ether
+    total.set(sSecond, wei("18446744073709551615"));
+    QCOMPARE(str(total.total()), QString("100000018446744073709551615"));
+
+    total.set(sSecond, wei("18446744073709551616"));
+    QCOMPARE(str(total.total()), QString("100000018446744073709551616"));
+    total.set(sFirst, wei("1"));
+    QCOMPARE(str(total.total()), QString("18446744073709551617"));
+}
+
+void TestBalanceTotal::clear() {
+    BalanceTotal total;
+    total.set(sFirst, wei("5"));
+    total.set(sSecond, wei("7"));
+    total.clear();
+    QCOMPARE(str(total.total()), QString("0"));
+    QCOMPARE(total.size(), 0);
+
+    // nothing left over from before the clear
+    total.set(sFirst, wei("2"));
+    QCOMPARE(str(total.total()), QString("2"));
+}
+
+QTEST_GUILESS_MAIN(TestBalanceTotal)
+
+#include "tst_balancetotal.moc"
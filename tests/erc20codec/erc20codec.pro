@@ -0,0 +1,12 @@
+include(../tests.pri)
+
+TARGET = tst_erc20codec
+
+SOURCES += tst_erc20codec.cpp \
+    $$SRC/contractinfo.cpp \
+    $$SRC/abicache.cpp
+
+HEADERS += \
+    $$SRC/erc20codec.h \
+    $$SRC/contractinfo.h \
+    $$SRC/abicache.h
@@ -0,0 +1,134 @@
+#include <QtTest>
+#include "erc20codec.h"
+#include "etherlogapp.h"
+
+using namespace Etherwall;
+using namespace Etherwall::ERC20;
+
+// EIP-55 example address
+static const QString sAddress = "0x5aAeb6053F3E94C9b9A09f33669435E7Ef1BeAed";
+static const QString sAddressWord = QString(24, '0') + sAddress.mid(2).toLower();
+
+static const QString uintWord(quint64 value) {
+    return QString::number(value, 16).rightJustified(64, '0');
+}
+
+class TestERC20Codec : public QObject
+{
+    Q_OBJECT
+private slots:
+    void selectors();
+    void transferTopic();
+    void balanceOf();
+    void badAddress();
+    void shortResult();
+    void transfer();
+    void transferRecipient();
+    void decimals();
+    void symbolString();
+    void symbolBytes32();
+    void transferEventTopics();
+    void balances();
+private:
+    EtherLogApp fLog;
+};
+
+void TestERC20Codec::selectors() {
+    QCOMPARE(selectorHex(sBalanceOfSelector), QString("70a08231"));
+    QCOMPARE(selectorHex(sNameSelector), QString("06fdde03")); // leading zero kept
+    QCOMPARE(Codec<Decimals>::encode(), QString("0x313ce567"));
+    QCOMPARE(Codec<Symbol>::encode(), QString("0x95d89b41"));
+    QCOMPARE(Codec<Name>::encode(), QString("0x06fdde03"));
+}
+
+void TestERC20Codec::transferTopic() {
+    QCOMPARE(Codec<TransferEvent>::topic(), QString("0xddf252ad1be2c89b69c2b068fc378daa952ba7f163c4a11628f55a4df523b3ef"));
+}
+
+void TestERC20Codec::balanceOf() {
+    QCOMPARE(Codec<BalanceOf>::encode(sAddress), "0x70a08231" + sAddressWord);
+    QCOMPARE(Codec<BalanceOf>::decode("0x" + uintWord(1000)), QString("1000"));
+    QCOMPARE(Codec<BalanceOf>::decode(uintWord(0)), QString("0"));
+}
+
+void TestERC20Codec::badAddress() {
+    QVERIFY_EXCEPTION_THROWN(Codec<BalanceOf>::encode("0x1234"), QString);
+    QVERIFY_EXCEPTION_THROWN(Codec<BalanceOf>::encode("0x" + QString(40, 'z')), QString);
+    // one letter's case flipped, checksum no longer matches
+    QVERIFY_EXCEPTION_THROWN(Codec<BalanceOf>::encode("0x5aaeb6053F3E94C9b9A09f33669435E7Ef1BeAed"), QString);
+}
+
+void TestERC20Codec::shortResult() {
+    QVERIFY_EXCEPTION_THROWN(Codec<BalanceOf>::decode("0x"), QString);
+    QVERIFY_EXCEPTION_THROWN(Codec<Decimals>::decode("0x12"), QString);
+}
+
+void TestERC20Codec::transfer() {
+    const QString input = Codec<Transfer>::encode(sAddress, "1000000000000000000");
+    QCOMPARE(input, "0xa9059cbb" + sAddressWord + uintWord(Q_UINT64_C(1000000000000000000)));
+}
+
+void TestERC20Codec::transferRecipient() {
+    const QString input = Codec<Transfer>::encode(sAddress, "5");
+    QCOMPARE(Codec<Transfer>::recipient(input), sAddress.toLower());
+    QCOMPARE(Codec<Transfer>::recipient("0xA9059CBB" + input.mid(10).toUpper()), sAddress.toLower());
+
+    QVERIFY(Codec<Transfer>::recipient(Codec<BalanceOf>::encode(sAddress)).isEmpty());
+    QVERIFY(Codec<Transfer>::recipient(input.left(input.length() - 2)).isEmpty()); // truncated
+    QVERIFY(Codec<Transfer>::recipient(QString()).isEmpty());
+}
+
+void TestERC20Codec::decimals() {
+    QCOMPARE(Codec<Decimals>::decode("0x" + uintWord(18)), (quint8)18);
+    QCOMPARE(Codec<Decimals>::decode(uintWord(0)), (quint8)0);
+}
+
+void TestERC20Codec::symbolString() {
+    // offset, length, "ABC" right padded
+    const QString result = "0x" + uintWord(32) + uintWord(3) + QString("414243").leftJustified(64, '0');
+    QString symbol;
+    QVERIFY(Codec<Symbol>::decode(result, symbol));
+    QCOMPARE(symbol, QString("ABC"));
+
+    const QString name = "0x" + uintWord(32) + uintWord(0) + QString(64, '0');
+    QString value = "unchanged";
+    QVERIFY(Codec<Name>::decode(name, value));
+    QVERIFY(value.isEmpty());
+}
+
+void TestERC20Codec::symbolBytes32() {
+    // old style bytes32 symbol, left to the generic ABI path
+    QString symbol;
+    QVERIFY(!Codec<Symbol>::decode("0x" + QString("414243").leftJustified(64, '0'), symbol));
+
+    // length pointing past the data
+    QVERIFY(!Codec<Symbol>::decode("0x" + uintWord(32) + uintWord(64) + QString(64, '0'), symbol));
+    QVERIFY(symbol.isEmpty());
+}
+
+void TestERC20Codec::transferEventTopics() {
+    const QJsonArray topics = Codec<TransferEvent>::topics(QVariantList() << sAddress);
+    QCOMPARE(topics.size(), 3);
+    QCOMPARE(topics.at(0).toString(), Codec<TransferEvent>::topic());
+    QVERIFY(topics.at(1).isNull());
+    QCOMPARE(topics.at(2).toArray().size(), 1);
+    QCOMPARE(topics.at(2).toArray().at(0).toString(), "0x" + sAddressWord);
+}
+
+void TestERC20Codec::balances() {
+    const QString token = "0x" + QString(40, '0'); // ETH
+    const QString input = Codec<Balances>::encode(QStringList() << sAddress, QStringList() << token << sAddress);
+    QCOMPARE(input, "0x" + selectorHex(sBalancesSelector) +
+             uintWord(64) + uintWord(128) + // offsets of users and tokens
+             uintWord(1) + sAddressWord +
+             uintWord(2) + QString(64, '0') + sAddressWord);
+
+    const QString result = "0x" + uintWord(32) + uintWord(2) + uintWord(7) + uintWord(Q_UINT64_C(1000000000000000000));
+    QCOMPARE(Codec<Balances>::decode(result), QStringList() << "7" << "1000000000000000000");
+    QVERIFY(Codec<Balances>::decode("0x" + uintWord(32) + uintWord(0)).isEmpty());
+    QVERIFY_EXCEPTION_THROWN(Codec<Balances>::decode("0x" + uintWord(32) + uintWord(1)), QString);
+}
+
+QTEST_GUILESS_MAIN(TestERC20Codec)
+
+#include "tst_erc20codec.moc"
@@ -0,0 +1,13 @@
+include(../tests.pri)
+
+TARGET = tst_eventarchive
+
+SOURCES += tst_eventarchive.cpp \
+    $$SRC/eventarchive.cpp \
+    $$SRC/contractinfo.cpp \
+    $$SRC/abicache.cpp
+
+HEADERS += \
+    $$SRC/eventarchive.h \
+    $$SRC/contractinfo.h \
+    $$SRC/abicache.h
@@ -0,0 +1,143 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include "eventarchive.h"
+#include "etherlogapp.h"
+
+using namespace Etherwall;
+
+class TestEventArchive : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+    void emptyArchive();
+    void takePageNewestFirst();
+    void takePageTruncates();
+    void readAllKeepsPages();
+    void clearDropsPages();
+    void reopenStartsEmpty();
+private:
+    EtherLogApp fLog;
+    QTemporaryDir fDir;
+
+    const QString fileName() const;
+    const EventList page(quint64 block, int count) const;
+    quint64 blockNumber(const QJsonObject& log) const;
+};
+
+void TestEventArchive::init() {
+    QVERIFY(fDir.isValid());
+    QFile::remove(fileName());
+}
+
+const QString TestEventArchive::fileName() const {
+    return fDir.path() + "/events/archive.jsonl";
+}
+
+// count logs of one block, index in the data so they're distinguishable
+const EventList TestEventArchive::page(quint64 block, int count) const {
+    EventList result;
+    for ( int i = 0; i < count; i++ ) {
+        QJsonObject log;
+        log["blockNumber"] = "0x" + QString::number(block, 16);
+        log["blockHash"] = "0x" + QString(64, 'b');
+        log["address"] = "0x" + QString(40, 'a');
+        log["transactionHash"] = "0x" + QString::number(i, 16).rightJustified(64, '0');
+        log["data"] = "0x" + QString::number(i, 16).rightJustified(64, '0');
+        log["topics"] = QJsonArray() << "0x" + QString(64, 'c');
+        result.append(EventInfo(log));
+    }
+
+    return result;
+}
+
+quint64 TestEventArchive::blockNumber(const QJsonObject& log) const {
+    return log.value("blockNumber").toString().mid(2).toULongLong(0, 16);
+}
+
+void TestEventArchive::emptyArchive() {
+    EventArchive archive(fileName());
+    QVERIFY(!archive.hasPages());
+    QCOMPARE(archive.pageCount(), 0);
+    QVERIFY(archive.takePage().isEmpty());
+    QVERIFY(archive.readAll().isEmpty());
+    QVERIFY(archive.storePage(EventList())); // nothing to store isn't a failure
+    QCOMPARE(archive.pageCount(), 0);
+}
+
+void TestEventArchive::takePageNewestFirst() {
+    EventArchive archive(fileName());
+    QVERIFY(archive.storePage(page(1, 3)));
+    QVERIFY(archive.storePage(page(2, 2)));
+    QCOMPARE(archive.pageCount(), 2);
+
+    QList<QJsonObject> logs = archive.takePage();
+    QCOMPARE(logs.size(), 2);
+    QCOMPARE(blockNumber(logs.at(0)), 2ull);
+    QCOMPARE(archive.pageCount(), 1);
+
+    logs = archive.takePage();
+    QCOMPARE(logs.size(), 3);
+    QCOMPARE(blockNumber(logs.at(0)), 1ull);
+    // order within a page is kept
+    QCOMPARE(logs.at(2).value("data").toString(), "0x" + QString("2").rightJustified(64, '0'));
+    QVERIFY(!archive.hasPages());
+}
+
+void TestEventArchive::takePageTruncates() {
+    EventArchive archive(fileName());
+    QVERIFY(archive.storePage(page(1, 2)));
+    const qint64 firstSize = QFileInfo(fileName()).size();
+    QVERIFY(archive.storePage(page(2, 4)));
+    QVERIFY(QFileInfo(fileName()).size() > firstSize);
+
+    archive.takePage();
+    QCOMPARE(QFileInfo(fileName()).size(), firstSize);
+
+    // pages stored after a take go on top of what's left
+    QVERIFY(archive.storePage(page(3, 1)));
+    QCOMPARE(blockNumber(archive.takePage().first()), 3ull);
+    QCOMPARE(blockNumber(archive.takePage().first()), 1ull);
+    QCOMPARE(QFileInfo(fileName()).size(), 0ll);
+}
+
+void TestEventArchive::readAllKeepsPages() {
+    EventArchive archive(fileName());
+    QVERIFY(archive.storePage(page(1, 2)));
+    QVERIFY(archive.storePage(page(2, 1)));
+    QVERIFY(archive.storePage(page(3, 3)));
+
+    const QList<QJsonObject> logs = archive.readAll();
+    QCOMPARE(logs.size(), 6);
+    QCOMPARE(blockNumber(logs.at(0)), 3ull);
+    QCOMPARE(blockNumber(logs.at(3)), 2ull);
+    QCOMPARE(blockNumber(logs.at(4)), 1ull);
+    QCOMPARE(archive.pageCount(), 3);
+
+    QCOMPARE(archive.takePage().size(), 3);
+    QCOMPARE(archive.readAll().size(), 3);
+}
+
+void TestEventArchive::clearDropsPages() {
+    EventArchive archive(fileName());
+    QVERIFY(archive.storePage(page(1, 2)));
+    archive.clear();
+    QVERIFY(!archive.hasPages());
+    QCOMPARE(QFileInfo(fileName()).size(), 0ll);
+    QVERIFY(archive.readAll().isEmpty());
+}
+
+void TestEventArchive::reopenStartsEmpty() {
+    {
+        EventArchive archive(fileName());
+        QVERIFY(archive.storePage(page(1, 2)));
+    }
+
+    EventArchive archive(fileName());
+    QVERIFY(!archive.hasPages());
+    QCOMPARE(QFileInfo(fileName()).size(), 0ll);
+}
+
+QTEST_GUILESS_MAIN(TestEventArchive)
+
+#include "tst_eventarchive.moc"
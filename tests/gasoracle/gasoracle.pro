@@ -0,0 +1,19 @@
+include(../tests.pri)
+
+TARGET = tst_gasoracle
+
+SOURCES += tst_gasoracle.cpp \
+    $$SRC/gasoracle.cpp \
+    $$SRC/decodedblock.cpp \
+    $$SRC/address.cpp \
+    $$SRC/nodeipc.cpp \
+    $$SRC/ipcsocketwatcher.cpp \
+    $$SRC/ipcsession.cpp
+
+HEADERS += \
+    $$SRC/gasoracle.h \
+    $$SRC/decodedblock.h \
+    $$SRC/address.h \
+    $$SRC/nodeipc.h \
+    $$SRC/ipcsocketwatcher.h \
+    $$SRC/ipcsession.h
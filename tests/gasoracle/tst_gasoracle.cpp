@@ -0,0 +1,191 @@
+#include <QtTest>
+#include <QSignalSpy>
+#include "gasoracle.h"
+#include "helpers.h"
+#include "etherlogapp.h"
+#include "gethlogapp.h"
+
+using namespace Etherwall;
+
+static const quint64 sGwei = 1000000000;
+
+// price as reported, the top of its 0.1 gwei bucket
+static const QString price(quint64 wei) {
+    return Helpers::weiStrToEtherStr(QString::number((wei / 100000000 + 1) * 100000000));
+}
+
+class TestGasOracle : public QObject
+{
+    Q_OBJECT
+public:
+    TestGasOracle();
+private slots:
+    void init();
+    void empty();
+    void percentiles();
+    void sameBucket();
+    void skipsUnusable();
+    void reorgReplaces();
+    void windowSlides();
+    void clampsHighPrices();
+    void reconnectClears();
+    void staleSnapshot();
+private:
+    EtherLogApp fLog;
+    GethLogApp fGethLog;
+    NodeIPC fIpc;
+    QScopedPointer<GasOracle> fOracle;
+
+    const DecodedBlock block(quint64 number, const QList<quint64>& prices) const;
+};
+
+TestGasOracle::TestGasOracle() : QObject(0), fLog(), fGethLog(), fIpc(fGethLog), fOracle()
+{
+}
+
+void TestGasOracle::init() {
+    fOracle.reset(new GasOracle(fIpc));
+}
+
+const DecodedBlock TestGasOracle::block(quint64 number, const QList<quint64>& prices) const {
+    DecodedBlock result;
+    result.fNumber = number;
+    foreach ( quint64 wei, prices ) {
+        DecodedTransaction tx;
+        tx.fGasPrice = wei;
+        result.fTransactions.append(tx);
+    }
+
+    return result;
+}
+
+void TestGasOracle::empty() {
+    QVERIFY(fOracle->isEmpty());
+    QCOMPARE(fOracle->getSamples(), 0);
+    QVERIFY(fOracle->getStandard().isEmpty());
+    QVERIFY(!fOracle->getStale());
+}
+
+void TestGasOracle::percentiles() {
+    QSignalSpy spy(fOracle.data(), &GasOracle::pricesChanged);
+    // out of order on purpose, the tree doesn't care
+    fOracle->onNewBlock(block(1, QList<quint64>() << 7 * sGwei << 2 * sGwei << 9 * sGwei << 4 * sGwei << 1 * sGwei));
+    fOracle->onNewBlock(block(2, QList<quint64>() << 10 * sGwei << 3 * sGwei << 6 * sGwei << 8 * sGwei << 5 * sGwei));
+
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(fOracle->getSamples(), 10);
+    QCOMPARE(fOracle->getSlow(), price(3 * sGwei)); // 30th percentile, rank 3
+    QCOMPARE(fOracle->getStandard(), price(6 * sGwei));
+    QCOMPARE(fOracle->getFast(), price(9 * sGwei));
+}
+
+void TestGasOracle::sameBucket() {
+    // 1.0 and 1.05 gwei share a bucket, 1.1 doesn't
+    fOracle->onNewBlock(block(1, QList<quint64>() << 1000000000 << 1050000000 << 1100000000));
+    QCOMPARE(fOracle->getSlow(), price(1000000000));
+    QCOMPARE(fOracle->getSlow(), price(1050000000));
+    QCOMPARE(fOracle->getFast(), price(1100000000));
+
+    // a single sample is every percentile
+    init();
+    fOracle->onNewBlock(block(1, QList<quint64>() << 20 * sGwei));
+    QCOMPARE(fOracle->getSlow(), price(20 * sGwei));
+    QCOMPARE(fOracle->getFast(), price(20 * sGwei));
+}
+
+void TestGasOracle::skipsUnusable() {
+    fOracle->onNewBlock(block(0, QList<quint64>() << sGwei)); // pending
+    QCOMPARE(fOracle->getSamples(), 0);
+
+    DecodedBlock light = block(1, QList<quint64>() << sGwei);
+    light.fFull = false;
+    fOracle->onNewBlock(light);
+    QCOMPARE(fOracle->getSamples(), 0);
+
+    fOracle->onNewBlock(block(2, QList<quint64>() << 0 << 0 << 0 << 5 * sGwei)); // zero priced miner txs
+    QCOMPARE(fOracle->getSamples(), 1);
+    QCOMPARE(fOracle->getSlow(), price(5 * sGwei));
+}
+
+void TestGasOracle::reorgReplaces() {
+    fOracle->onNewBlock(block(1, QList<quint64>() << 1 * sGwei));
+    fOracle->onNewBlock(block(2, QList<quint64>() << 50 * sGwei << 50 * sGwei));
+    fOracle->onNewBlock(block(3, QList<quint64>() << 50 * sGwei));
+    QCOMPARE(fOracle->getSamples(), 4);
+
+    // new block 2 drops the old 2 and 3
+    fOracle->onNewBlock(block(2, QList<quint64>() << 2 * sGwei));
+    QCOMPARE(fOracle->getSamples(), 2);
+    QCOMPARE(fOracle->getSlow(), price(1 * sGwei));
+    QCOMPARE(fOracle->getFast(), price(2 * sGwei));
+}
+
+void TestGasOracle::windowSlides() {
+    fOracle->onNewBlock(block(1, QList<quint64>() << 100 * sGwei << 100 * sGwei));
+    for ( quint64 i = 2; i <= 50; i++ ) {
+        fOracle->onNewBlock(block(i, QList<quint64>() << 1 * sGwei));
+    }
+    QCOMPARE(fOracle->getSamples(), 51);
+    QCOMPARE(fOracle->getFast(), price(1 * sGwei));
+
+    // block 1 falls out of the 50 block window
+    fOracle->onNewBlock(block(51, QList<quint64>() << 1 * sGwei));
+    QCOMPARE(fOracle->getSamples(), 50);
+    for ( quint64 i = 52; i <= 60; i++ ) {
+        fOracle->onNewBlock(block(i, QList<quint64>() << 3 * sGwei << 3 * sGwei << 3 * sGwei << 3 * sGwei));
+    }
+    QCOMPARE(fOracle->getSamples(), 41 + 9 * 4);
+    QCOMPARE(fOracle->getSlow(), price(1 * sGwei));
+    QCOMPARE(fOracle->getFast(), price(3 * sGwei));
+}
+
+void TestGasOracle::clampsHighPrices() {
+    fOracle->onNewBlock(block(1, QList<quint64>() << 5000 * sGwei << 100000 * sGwei));
+    QCOMPARE(fOracle->getSamples(), 2);
+    QCOMPARE(fOracle->getSlow(), fOracle->getFast()); // both in the top bucket
+    QCOMPARE(fOracle->getFast(), price(Q_UINT64_C(16383) * 100000000));
+}
+
+void TestGasOracle::reconnectClears() {
+    fOracle->onNewBlock(block(1, QList<quint64>() << 1 * sGwei));
+    emit fIpc.connectToServerDone();
+    QCOMPARE(fOracle->getSamples(), 0);
+    QVERIFY(fOracle->getStandard().isEmpty());
+
+    fOracle->onNewBlock(block(1, QList<quint64>() << 4 * sGwei));
+    QCOMPARE(fOracle->getStandard(), price(4 * sGwei));
+}
+
+void TestGasOracle::staleSnapshot() {
+    fOracle->onNewBlock(block(1, QList<quint64>() << 1 * sGwei << 2 * sGwei << 3 * sGwei));
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        fOracle->saveState(out);
+    }
+
+    init();
+    QDataStream in(data);
+    fOracle->loadState(in);
+    QVERIFY(fOracle->getStale());
+    QCOMPARE(fOracle->getSlow(), price(1 * sGwei));
+    QCOMPARE(fOracle->getFast(), price(3 * sGwei));
+
+    // blocks without usable prices keep the snapshot
+    fOracle->onNewBlock(block(1, QList<quint64>() << 0));
+    QVERIFY(fOracle->getStale());
+
+    fOracle->onNewBlock(block(2, QList<quint64>() << 7 * sGwei));
+    QVERIFY(!fOracle->getStale());
+    QCOMPARE(fOracle->getSlow(), price(7 * sGwei));
+
+    // live prices aren't overwritten by a snapshot
+    QDataStream again(data);
+    fOracle->loadState(again);
+    QVERIFY(!fOracle->getStale());
+    QCOMPARE(fOracle->getSlow(), price(7 * sGwei));
+}
+
+QTEST_GUILESS_MAIN(TestGasOracle)
+
+#include "tst_gasoracle.moc"
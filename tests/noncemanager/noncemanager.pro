@@ -0,0 +1,9 @@
+include(../tests.pri)
+
+TARGET = tst_noncemanager
+
+SOURCES += tst_noncemanager.cpp \
+    $$SRC/noncemanager.cpp
+
+HEADERS += \
+    $$SRC/noncemanager.h
@@ -0,0 +1,180 @@
+#include <QtTest>
+#include "noncemanager.h"
+#include "etherlogapp.h"
+
+using namespace Etherwall;
+
+static const QString sAccount = "0x5aAeb6053F3E94C9b9A09f33669435E7Ef1BeAed";
+static const QString sOther = "0xfB6916095ca1df60bB79Ce92cE3Ea74c37c5d359";
+
+class TestNonceManager : public QObject
+{
+    Q_OBJECT
+private slots:
+    void reserveSequential();
+    void reserveFollowsNode();
+    void caseInsensitive();
+    void rollbackFillsGap();
+    void rollbackKeepsSubmitted();
+    void confirmFrees();
+    void expiredAfterDropBlocks();
+    void confirmPendingDropsUnknown();
+    void confirmPendingKeepsKnown();
+    void confirmPendingKeepsYoung();
+    void clear();
+private:
+    EtherLogApp fLog;
+};
+
+void TestNonceManager::reserveSequential() {
+    NonceManager nonces;
+    QCOMPARE(nonces.next(sAccount, 5), 5ull);
+    QCOMPARE(nonces.reserve(sAccount, 5, 100), 5ull);
+    QCOMPARE(nonces.reserve(sAccount, 5, 100), 6ull);
+    QCOMPARE(nonces.reserve(sAccount, 5, 100), 7ull);
+    QCOMPARE(nonces.next(sAccount, 5), 8ull);
+
+    // accounts don't share nonces
+    QCOMPARE(nonces.reserve(sOther, 0, 100), 0ull);
+}
+
+void TestNonceManager::reserveFollowsNode() {
+    NonceManager nonces;
+    QCOMPARE(nonces.reserve(sAccount, 5, 100), 5ull);
+    // node's count passed us, e.g. a send from another wallet
+    QCOMPARE(nonces.reserve(sAccount, 9, 101), 9ull);
+    // a stale lower count doesn't take us back
+    QCOMPARE(nonces.reserve(sAccount, 2, 102), 10ull);
+}
+
+void TestNonceManager::caseInsensitive() {
+    NonceManager nonces;
+    QCOMPARE(nonces.reserve(sAccount, 0, 100), 0ull);
+    QCOMPARE(nonces.reserve(sAccount.toLower(), 0, 100), 1ull);
+    QCOMPARE(nonces.next(sAccount.toUpper(), 0), 2ull);
+}
+
+void TestNonceManager::rollbackFillsGap() {
+    NonceManager nonces;
+    nonces.reserve(sAccount, 0, 100);
+    nonces.reserve(sAccount, 0, 100);
+    nonces.reserve(sAccount, 0, 100);
+
+    nonces.rollback(sAccount, 1);
+    QCOMPARE(nonces.next(sAccount, 0), 1ull);
+    QCOMPARE(nonces.reserve(sAccount, 0, 101), 1ull);
+    QCOMPARE(nonces.reserve(sAccount, 0, 101), 3ull);
+
+    // the last one going back just shortens the run
+    nonces.rollback(sAccount, 3);
+    QCOMPARE(nonces.next(sAccount, 0), 3ull);
+
+    // unknown nonces are ignored
+    nonces.rollback(sAccount, 42);
+    nonces.rollback(sOther, 0);
+    QCOMPARE(nonces.next(sAccount, 0), 3ull);
+}
+
+void TestNonceManager::rollbackKeepsSubmitted() {
+    NonceManager nonces;
+    nonces.reserve(sAccount, 0, 100);
+    nonces.submitted(sAccount, 0);
+
+    // e.g. a resend of it failed, the original is still out there
+    nonces.rollback(sAccount, 0);
+    QCOMPARE(nonces.next(sAccount, 0), 1ull);
+}
+
+void TestNonceManager::confirmFrees() {
+    NonceManager nonces;
+    nonces.reserve(sAccount, 0, 100);
+    nonces.reserve(sAccount, 0, 100);
+    nonces.reserve(sAccount, 0, 100);
+    nonces.submitted(sAccount, 0);
+    nonces.submitted(sAccount, 1);
+    nonces.submitted(sAccount, 2);
+
+    nonces.confirm(sAccount, 2);
+    QCOMPARE(nonces.next(sAccount, 0), 3ull);
+    QVERIFY(nonces.expired(1000).contains(sAccount.toLower())); // 2 is still out
+
+    nonces.confirm(sAccount, 3);
+    QVERIFY(nonces.expired(1000).isEmpty());
+    QCOMPARE(nonces.next(sAccount, 0), 3ull);
+
+    // accounts we never reserved for stay untracked
+    nonces.confirm(sOther, 7);
+    QCOMPARE(nonces.next(sOther, 0), 0ull);
+}
+
+void TestNonceManager::expiredAfterDropBlocks() {
+    NonceManager nonces;
+    nonces.reserve(sAccount, 0, 100);
+    nonces.reserve(sOther, 0, 100);
+    nonces.submitted(sAccount, 0);
+
+    QVERIFY(nonces.expired(140).isEmpty()); // 40 blocks is still in time
+    QCOMPARE(nonces.expired(141), QStringList() << sAccount.toLower());
+
+    // unsubmitted reservations never expire, the send is still in flight
+    QVERIFY(!nonces.expired(100000).contains(sOther.toLower()));
+}
+
+void TestNonceManager::confirmPendingDropsUnknown() {
+    NonceManager nonces;
+    nonces.reserve(sAccount, 0, 100);
+    nonces.reserve(sAccount, 0, 100);
+    nonces.reserve(sAccount, 0, 100);
+    nonces.submitted(sAccount, 0);
+    nonces.submitted(sAccount, 1);
+    nonces.submitted(sAccount, 2);
+
+    // node has 0 pending, doesn't know 1, so 1 was dropped and is free again; 2 waits for the gap
+    nonces.confirmPending(sAccount, 1, 200);
+    QCOMPARE(nonces.next(sAccount, 0), 1ull);
+    QCOMPARE(nonces.reserve(sAccount, 0, 200), 1ull);
+    QCOMPARE(nonces.reserve(sAccount, 0, 200), 3ull);
+}
+
+void TestNonceManager::confirmPendingKeepsKnown() {
+    NonceManager nonces;
+    nonces.reserve(sAccount, 0, 100);
+    nonces.reserve(sAccount, 0, 100);
+    nonces.submitted(sAccount, 0);
+    nonces.submitted(sAccount, 1);
+
+    // both in the node's pool
+    nonces.confirmPending(sAccount, 2, 200);
+    QVERIFY(nonces.expired(200).isEmpty());
+    QCOMPARE(nonces.next(sAccount, 0), 2ull);
+}
+
+void TestNonceManager::confirmPendingKeepsYoung() {
+    NonceManager nonces;
+    nonces.reserve(sAccount, 0, 100);
+    nonces.reserve(sAccount, 0, 190);
+    nonces.submitted(sAccount, 0);
+    nonces.submitted(sAccount, 1);
+
+    // 1 was sent recently, the node may just not have it yet
+    nonces.confirmPending(sAccount, 1, 200);
+    QCOMPARE(nonces.next(sAccount, 0), 2ull);
+
+    // not submitted yet, sign or send still in flight
+    nonces.reserve(sAccount, 0, 100);
+    nonces.confirmPending(sAccount, 2, 1000);
+    QCOMPARE(nonces.next(sAccount, 0), 3ull);
+}
+
+void TestNonceManager::clear() {
+    NonceManager nonces;
+    nonces.reserve(sAccount, 0, 100);
+    nonces.reserve(sAccount, 0, 100);
+    nonces.clear();
+    QCOMPARE(nonces.next(sAccount, 0), 0ull);
+    QVERIFY(nonces.expired(1000).isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestNonceManager)
+
+#include "tst_noncemanager.moc"
@@ -0,0 +1,9 @@
+include(../tests.pri)
+
+TARGET = tst_recordstore
+
+SOURCES += tst_recordstore.cpp \
+    $$SRC/recordstore.cpp
+
+HEADERS += \
+    $$SRC/recordstore.h
@@ -0,0 +1,294 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include "recordstore.h"
+#include "etherlogapp.h"
+
+using namespace Etherwall;
+
+static const int sLargeValue = 64 * 1024; // 16 of these fill a segment
+
+// same length for all so every record is the same size
+static const QString key(int i) {
+    return QString::number(i).rightJustified(2, '0');
+}
+
+class TestRecordStore : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void putAndGet();
+    void unchangedPutSkipped();
+    void replay();
+    void replayLastWriteWins();
+    void tornTail();
+    void badChecksum();
+    void rollover();
+    void compactOverwritten();
+    void compactRemoved();
+    void compactKeepsLive();
+    void migrateSettings();
+private:
+    EtherLogApp fLog;
+    QScopedPointer<QTemporaryDir> fDir;
+    QTemporaryDir fSettingsDir;
+
+    const QString segment(int number) const;
+    const QByteArray large(char fill) const;
+};
+
+void TestRecordStore::initTestCase() {
+    QVERIFY(fSettingsDir.isValid());
+    QCoreApplication::setOrganizationName("EtherwallTest");
+    QCoreApplication::setApplicationName("tst_recordstore");
+    QSettings::setDefaultFormat(QSettings::IniFormat);
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, fSettingsDir.path());
+}
+
+void TestRecordStore::init() {
+    fDir.reset(new QTemporaryDir());
+    QVERIFY(fDir->isValid());
+}
+
+const QString TestRecordStore::segment(int number) const {
+    return fDir->path() + "/" + QString("%1.log").arg(number, 6, 10, QChar('0'));
+}
+
+const QByteArray TestRecordStore::large(char fill) const {
+    return QByteArray(sLargeValue, fill);
+}
+
+void TestRecordStore::putAndGet() {
+    RecordStore store(fDir->path());
+    QVERIFY(!store.contains("accounts", "a"));
+    QVERIFY(store.value("accounts", "a").isEmpty());
+    QVERIFY(store.keys("accounts").isEmpty());
+
+    QVERIFY(store.put("accounts", "a", "1"));
+    QVERIFY(store.put("accounts", "b", "2"));
+    QVERIFY(store.put("contracts", "a", "3")); // tables are separate
+    QCOMPARE(store.value("accounts", "a"), QByteArray("1"));
+    QCOMPARE(store.value("contracts", "a"), QByteArray("3"));
+    QStringList keys = store.keys("accounts");
+    keys.sort();
+    QCOMPARE(keys, QStringList() << "a" << "b");
+
+    QVERIFY(store.put("accounts", "a", "4"));
+    QCOMPARE(store.value("accounts", "a"), QByteArray("4"));
+    QVERIFY(store.remove("accounts", "a"));
+    QVERIFY(!store.contains("accounts", "a"));
+    QVERIFY(store.remove("accounts", "missing"));
+    QVERIFY(store.put("accounts", "empty", QByteArray()));
+    QVERIFY(store.contains("accounts", "empty"));
+}
+
+void TestRecordStore::unchangedPutSkipped() {
+    RecordStore store(fDir->path());
+    QVERIFY(store.put("accounts", "a", "1"));
+    const qint64 size = QFileInfo(segment(1)).size();
+    QVERIFY(size > 0);
+
+    QVERIFY(store.put("accounts", "a", "1"));
+    QVERIFY(store.remove("accounts", "missing"));
+    QCOMPARE(QFileInfo(segment(1)).size(), size);
+}
+
+void TestRecordStore::replay() {
+    {
+        RecordStore store(fDir->path());
+        QVERIFY(store.put("transactions", "0x01", "{\"value\":1}"));
+        QVERIFY(store.put("transactions", "0x02", "{\"value\":2}"));
+        QVERIFY(store.put("filters", "f", QByteArray("\x00\xff\n", 3))); // binary safe
+        QVERIFY(store.remove("transactions", "0x01"));
+    }
+
+    RecordStore store(fDir->path());
+    QVERIFY(!store.contains("transactions", "0x01"));
+    QCOMPARE(store.value("transactions", "0x02"), QByteArray("{\"value\":2}"));
+    QCOMPARE(store.value("filters", "f"), QByteArray("\x00\xff\n", 3));
+    QCOMPARE(store.keys("transactions"), QStringList() << "0x02");
+}
+
+void TestRecordStore::replayLastWriteWins() {
+    {
+        RecordStore store(fDir->path());
+        for ( int i = 0; i < 10; i++ ) {
+            QVERIFY(store.put("accounts", "a", QByteArray::number(i)));
+        }
+        QVERIFY(store.remove("accounts", "b"));
+        QVERIFY(store.put("accounts", "b", "x"));
+        QVERIFY(store.remove("accounts", "b"));
+        QVERIFY(store.put("accounts", "b", "y"));
+    }
+
+    RecordStore store(fDir->path());
+    QCOMPARE(store.value("accounts", "a"), QByteArray("9"));
+    QCOMPARE(store.value("accounts", "b"), QByteArray("y"));
+
+    // appends go on after the replayed records
+    QVERIFY(store.put("accounts", "c", "z"));
+    RecordStore again(fDir->path());
+    QCOMPARE(again.value("accounts", "a"), QByteArray("9"));
+    QCOMPARE(again.value("accounts", "c"), QByteArray("z"));
+}
+
+void TestRecordStore::tornTail() {
+    qint64 intact = 0;
+    {
+        RecordStore store(fDir->path());
+        QVERIFY(store.put("accounts", "a", "1"));
+        QVERIFY(store.put("accounts", "b", "2"));
+        intact = QFileInfo(segment(1)).size();
+        QVERIFY(store.put("accounts", "c", "3"));
+    }
+
+    // crash in the middle of the last write
+    QVERIFY(QFile::resize(segment(1), QFileInfo(segment(1)).size() - 3));
+
+    {
+        RecordStore store(fDir->path());
+        QCOMPARE(store.value("accounts", "a"), QByteArray("1"));
+        QCOMPARE(store.value("accounts", "b"), QByteArray("2"));
+        QVERIFY(!store.contains("accounts", "c"));
+        QCOMPARE(QFileInfo(segment(1)).size(), intact); // partial record cut off
+
+        QVERIFY(store.put("accounts", "d", "4"));
+    }
+
+    // the record written after the cut replays fine
+    RecordStore store(fDir->path());
+    QCOMPARE(store.keys("accounts").size(), 3);
+    QCOMPARE(store.value("accounts", "d"), QByteArray("4"));
+}
+
+void TestRecordStore::badChecksum() {
+    qint64 intact = 0;
+    {
+        RecordStore store(fDir->path());
+        QVERIFY(store.put("accounts", "a", "1"));
+        intact = QFileInfo(segment(1)).size();
+        QVERIFY(store.put("accounts", "b", "22222222"));
+    }
+
+    // flip a byte of the last value, length is still right
+    QFile file(segment(1));
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.seek(file.size() - 2));
+    QVERIFY(file.write("x", 1) == 1);
+    file.close();
+
+    RecordStore store(fDir->path());
+    QCOMPARE(store.value("accounts", "a"), QByteArray("1"));
+    QVERIFY(!store.contains("accounts", "b"));
+    QCOMPARE(QFileInfo(segment(1)).size(), intact);
+}
+
+void TestRecordStore::rollover() {
+    {
+        RecordStore store(fDir->path());
+        for ( int i = 0; i < 20; i++ ) {
+            QVERIFY(store.put("contracts", key(i), large('a' + i)));
+        }
+        QVERIFY(QFile::exists(segment(1)));
+        QVERIFY(QFile::exists(segment(2)));
+        QVERIFY(QFileInfo(segment(1)).size() >= 1024 * 1024);
+    }
+
+    RecordStore store(fDir->path());
+    QCOMPARE(store.keys("contracts").size(), 20);
+    for ( int i = 0; i < 20; i++ ) {
+        QCOMPARE(store.value("contracts", key(i)), large('a' + i));
+    }
+}
+
+void TestRecordStore::compactOverwritten() {
+    {
+        RecordStore store(fDir->path());
+        QVERIFY(store.put("accounts", "small", "1"));
+        for ( int i = 0; i < 20; i++ ) {
+            QVERIFY(store.put("accounts", "big", large('a' + i)));
+        }
+
+        // the first segment only held overwritten values and one small live one, so it's gone
+        QVERIFY(!QFile::exists(segment(1)));
+        QVERIFY(QFile::exists(segment(2)));
+        QCOMPARE(store.value("accounts", "small"), QByteArray("1"));
+    }
+
+    RecordStore store(fDir->path());
+    QCOMPARE(store.value("accounts", "small"), QByteArray("1"));
+    QCOMPARE(store.value("accounts", "big"), large('a' + 19));
+    QCOMPARE(store.keys("accounts").size(), 2);
+}
+
+void TestRecordStore::compactRemoved() {
+    {
+        RecordStore store(fDir->path());
+        for ( int i = 0; i < 20; i++ ) {
+            QVERIFY(store.put("contracts", key(i), large('a' + i)));
+        }
+
+        // 0-15 are in the first segment, removing half of them leaves it half dead
+        for ( int i = 0; i < 7; i++ ) {
+            QVERIFY(store.remove("contracts", key(i)));
+        }
+        QVERIFY(QFile::exists(segment(1)));
+        QVERIFY(store.remove("contracts", key(7)));
+        QVERIFY(!QFile::exists(segment(1)));
+        QCOMPARE(store.keys("contracts").size(), 12);
+    }
+
+    // the removals went with the segment, nothing older is left for the removed keys to come back from
+    RecordStore store(fDir->path());
+    QCOMPARE(store.keys("contracts").size(), 12);
+    for ( int i = 0; i < 8; i++ ) {
+        QVERIFY(!store.contains("contracts", key(i)));
+    }
+    for ( int i = 8; i < 20; i++ ) {
+        QCOMPARE(store.value("contracts", key(i)), large('a' + i));
+    }
+}
+
+void TestRecordStore::compactKeepsLive() {
+    RecordStore store(fDir->path());
+    for ( int i = 0; i < 20; i++ ) {
+        QVERIFY(store.put("contracts", key(i), large('a' + i)));
+    }
+
+    // mostly live, rewriting it would just copy the same data
+    QVERIFY(store.remove("contracts", key(0)));
+    QVERIFY(store.put("contracts", key(1), large('z')));
+    QVERIFY(QFile::exists(segment(1)));
+    QCOMPARE(store.value("contracts", key(1)), large('z'));
+}
+
+void TestRecordStore::migrateSettings() {
+    {
+        QSettings settings;
+        settings.clear();
+        settings.setValue("accounts/default/", "0x01"); // mainnet, stored as accounts/default
+        settings.setValue("accounts/default/testnet", "0x02");
+        settings.setValue("accounts/0xabc", "{\"hash\":\"0xabc\"}");
+        settings.setValue("accountstestnet/0xdef", "{\"hash\":\"0xdef\"}");
+        settings.setValue("transactions/pendingfeed", true);
+        settings.setValue("geth/path", "/usr/bin/geth");
+    }
+
+    RecordStore store(fDir->path());
+    store.migrateSettings();
+    QCOMPARE(store.keys("accounts"), QStringList() << "0xabc");
+    QCOMPARE(store.keys("accountstestnet"), QStringList() << "0xdef");
+    QVERIFY(store.keys("transactions").isEmpty());
+
+    // default accounts and plain settings stay where they were
+    QSettings settings;
+    QCOMPARE(settings.value("accounts/default").toString(), QString("0x01"));
+    QCOMPARE(settings.value("accounts/default/testnet").toString(), QString("0x02"));
+    QVERIFY(settings.value("transactions/pendingfeed").toBool());
+    QVERIFY(!settings.contains("accounts/0xabc"));
+}
+
+QTEST_GUILESS_MAIN(TestRecordStore)
+
+#include "tst_recordstore.moc"
@@ -0,0 +1,9 @@
+include(../tests.pri)
+
+TARGET = tst_settingscache
+
+SOURCES += tst_settingscache.cpp \
+    $$SRC/settingscache.cpp
+
+HEADERS += \
+    $$SRC/settingscache.h
@@ -0,0 +1,88 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include "settingscache.h"
+
+using namespace Etherwall;
+
+class TestSettingsCache : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void init();
+    void trailingSlash();
+    void survivesRestart();
+    void childKeys();
+    void remove();
+private:
+    QTemporaryDir fDir;
+};
+
+void TestSettingsCache::initTestCase() {
+    QVERIFY(fDir.isValid());
+    QCoreApplication::setOrganizationName("EtherwallTest");
+    QCoreApplication::setApplicationName("tst_settingscache");
+    QSettings::setDefaultFormat(QSettings::IniFormat);
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, fDir.path());
+}
+
+void TestSettingsCache::init() {
+    QSettings settings;
+    settings.clear();
+    settings.sync();
+}
+
+void TestSettingsCache::trailingSlash() {
+    SettingsCache cache;
+    // mainnet has no network postfix, so the key ends in a slash
+    cache.setValue("accounts/default/", "0x01");
+    QCOMPARE(cache.value("accounts/default/").toString(), QString("0x01"));
+    QCOMPARE(cache.value("accounts/default").toString(), QString("0x01"));
+    QCOMPARE(cache.value("/accounts//default").toString(), QString("0x01"));
+    QVERIFY(cache.contains("accounts/default/"));
+
+    // the same key however it's spelled
+    cache.setValue("accounts/default", "0x02");
+    QCOMPARE(cache.value("accounts/default/").toString(), QString("0x02"));
+}
+
+void TestSettingsCache::survivesRestart() {
+    {
+        SettingsCache cache;
+        cache.setValue("accounts/default/", "0x01");
+        cache.setValue("accounts/default/testnet", "0x02");
+    }
+
+    SettingsCache cache;
+    QCOMPARE(cache.value("accounts/default/").toString(), QString("0x01"));
+    QCOMPARE(cache.value("accounts/default/testnet").toString(), QString("0x02"));
+    QVERIFY(!cache.contains("accounts/default/rinkeby"));
+}
+
+void TestSettingsCache::childKeys() {
+    SettingsCache cache;
+    cache.setValue("accounts/default/", "0x01");
+    cache.setValue("accounts/default/testnet", "0x02");
+    cache.setValue("accountsx/other", "0x03");
+
+    QStringList keys = cache.childKeys("accounts/");
+    keys.sort();
+    QCOMPARE(keys, QStringList() << "default" << "default/testnet");
+    QCOMPARE(cache.childKeys("accounts/default"), QStringList() << "testnet");
+}
+
+void TestSettingsCache::remove() {
+    SettingsCache cache;
+    cache.setValue("accounts/default/", "0x01");
+    cache.setValue("accounts/default/testnet", "0x02");
+    cache.setValue("helpers/currency", "USD");
+
+    cache.remove("accounts//default/");
+    QVERIFY(!cache.contains("accounts/default"));
+    QVERIFY(!cache.contains("accounts/default/testnet"));
+    QCOMPARE(cache.value("helpers/currency").toString(), QString("USD"));
+}
+
+QTEST_GUILESS_MAIN(TestSettingsCache)
+
+#include "tst_settingscache.moc"
@@ -0,0 +1,27 @@
+QT += testlib widgets network concurrent
+CONFIG += c++14 console testcase
+CONFIG -= app_bundle
+
+SRC = $$PWD/../src
+NODE = $$SRC/ew-node/src
+
+INCLUDEPATH += $$SRC $$NODE
+DEPENDPATH += $$SRC $$NODE
+
+SOURCES += \
+    $$NODE/etherlog.cpp \
+    $$NODE/gethlog.cpp \
+    $$NODE/helpers.cpp \
+    $$NODE/types.cpp \
+    $$NODE/ethereum/tx.cpp \
+    $$NODE/ethereum/bigint.cpp \
+    $$SRC/etherlogapp.cpp \
+    $$SRC/gethlogapp.cpp
+
+HEADERS += \
+    $$NODE/etherlog.h \
+    $$NODE/gethlog.h \
+    $$NODE/helpers.h \
+    $$NODE/types.h \
+    $$SRC/etherlogapp.h \
+    $$SRC/gethlogapp.h
@@ -0,0 +1,11 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    eventarchive \
+    erc20codec \
+    gasoracle \
+    noncemanager \
+    address \
+    balancetotal \
+    recordstore \
+    settingscache